@@ -0,0 +1,218 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file checkpoint.hpp
+  \brief Checkpoints to resume interrupted benchmark sweeps
+
+  A checkpoint stores, per key (usually the benchmark name), the results of
+  finished stages and the finished table rows.  A stage consists of an
+  optimized network in the binary format of `xmg_binary.hpp` and a JSON
+  object with the values computed up to that stage; table rows are stored as
+  JSON entries.  JSON values are written in CBOR.  All files are written to a
+  temporary file first and then renamed, such that a killed run never leaves
+  a partial checkpoint behind.
+
+  Without `resume`, existing checkpoints of the same name are removed.  With
+  `resume`, drivers restore the rows of finished keys and continue other keys
+  from their last finished stage.  Resuming assumes the same settings as the
+  interrupted run.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include "experiments.hpp"
+#include "xmg_binary.hpp"
+
+namespace experiments
+{
+
+class checkpoint
+{
+public:
+  /*! \brief Checkpoint in `checkpoints/<name>/` next to the experiment tables */
+  explicit checkpoint( std::string_view name, bool resume = false )
+      : resume_( resume )
+  {
+#ifndef EXPERIMENTS_PATH
+    directory_ = fmt::format( "checkpoints/{}/", name );
+#else
+    directory_ = fmt::format( "{}checkpoints/{}/", EXPERIMENTS_PATH, name );
+#endif
+
+    std::error_code ec;
+    if ( !resume_ )
+    {
+      std::filesystem::remove_all( directory_, ec );
+    }
+    std::filesystem::create_directories( directory_, ec );
+    if ( ec )
+    {
+      fmt::print( "[w] cannot create checkpoint directory {}: {}\n", directory_, ec.message() );
+    }
+  }
+
+  bool resume() const
+  {
+    return resume_;
+  }
+
+  /*! \brief Whether `restore_rows` would restore rows for `key` */
+  template<typename... ColumnTypes>
+  bool has_rows( std::string const& key, experiment<ColumnTypes...> const& exp, std::string const& table = {} ) const
+  {
+    std::error_code ec;
+    return resume_ && std::filesystem::exists( path( key, table.empty() ? exp.name() : table, "rows" ), ec );
+  }
+
+  /*! \brief Appends the rows saved for `key` to `exp`, returns false if there are none
+   *
+   * `table` distinguishes experiments with the same name and defaults to the
+   * name of `exp`.
+   */
+  template<typename... ColumnTypes>
+  bool restore_rows( std::string const& key, experiment<ColumnTypes...>& exp, std::string const& table = {} ) const
+  {
+    nlohmann::json entries;
+    if ( !resume_ || !read_json( path( key, table.empty() ? exp.name() : table, "rows" ), entries ) )
+    {
+      return false;
+    }
+
+    for ( auto const& entry : entries )
+    {
+      exp.add_entry( entry );
+    }
+    return true;
+  }
+
+  /*! \brief Saves the rows of `exp` starting from `first_row` as finished rows of `key` */
+  template<typename... ColumnTypes>
+  void save_rows( std::string const& key, experiment<ColumnTypes...> const& exp, std::size_t first_row, std::string const& table = {} )
+  {
+    auto entries = nlohmann::json::array();
+    for ( auto i = first_row; i < exp.num_rows(); ++i )
+    {
+      entries.push_back( exp.entry( i ) );
+    }
+    write_json( path( key, table.empty() ? exp.name() : table, "rows" ), entries );
+  }
+
+  /*! \brief Loads the data of a finished stage */
+  bool load_data( std::string const& key, std::string const& stage, nlohmann::json& data ) const
+  {
+    return resume_ && read_json( path( key, stage, "cbor" ), data );
+  }
+
+  /*! \brief Saves the data of a finished stage that does not change the network */
+  void save_data( std::string const& key, std::string const& stage, nlohmann::json const& data )
+  {
+    write_json( path( key, stage, "cbor" ), data );
+  }
+
+  /*! \brief Loads the network and data of a finished stage into an empty network */
+  template<class Ntk>
+  bool load_stage( std::string const& key, std::string const& stage, Ntk& ntk, nlohmann::json& data ) const
+  {
+    /* the data file is written last and marks the stage as finished */
+    return load_data( key, stage, data ) && mockturtle::read_xmg_binary( path( key, stage, "xmgb" ), ntk );
+  }
+
+  /*! \brief Saves the network and data of a finished stage */
+  template<class Ntk>
+  void save_stage( std::string const& key, std::string const& stage, Ntk const& ntk, nlohmann::json const& data = nlohmann::json::object() )
+  {
+    auto const filename = path( key, stage, "xmgb" );
+    {
+      std::ofstream os( filename + ".tmp", std::ofstream::out | std::ofstream::binary );
+      mockturtle::write_xmg_binary( ntk, os );
+    }
+    commit( filename );
+    save_data( key, stage, data );
+  }
+
+private:
+  std::string path( std::string const& key, std::string const& stage, std::string const& extension ) const
+  {
+    return fmt::format( "{}{}.{}.{}", directory_, key, stage, extension );
+  }
+
+  static bool read_json( std::string const& filename, nlohmann::json& data )
+  {
+    std::ifstream is( filename, std::ifstream::in | std::ifstream::binary );
+    if ( !is.good() )
+    {
+      return false;
+    }
+
+    std::vector<uint8_t> const bytes( ( std::istreambuf_iterator<char>( is ) ), std::istreambuf_iterator<char>() );
+    try
+    {
+      data = nlohmann::json::from_cbor( bytes );
+    }
+    catch ( nlohmann::json::exception const& )
+    {
+      return false;
+    }
+    return true;
+  }
+
+  void write_json( std::string const& filename, nlohmann::json const& data ) const
+  {
+    {
+      auto const bytes = nlohmann::json::to_cbor( data );
+      std::ofstream os( filename + ".tmp", std::ofstream::out | std::ofstream::binary );
+      os.write( reinterpret_cast<char const*>( bytes.data() ), bytes.size() );
+    }
+    commit( filename );
+  }
+
+  void commit( std::string const& filename ) const
+  {
+    std::error_code ec;
+    std::filesystem::rename( filename + ".tmp", filename, ec );
+    if ( ec )
+    {
+      fmt::print( "[w] cannot write checkpoint {}: {}\n", filename, ec.message() );
+    }
+  }
+
+private:
+  bool resume_;
+  std::string directory_;
+};
+
+} // namespace experiments
@@ -0,0 +1,291 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file convergence.hpp
+  \brief Per-iteration traces and early stopping for rewriting/resubstitution loops
+
+  `convergence_trace` records, after every pass of an iteration, the size,
+  the self-dual ratio, an area estimate, and the runtime of the pass.  The
+  area estimate is the sum of the genlib areas of all gates (see
+  `xmg_genlib_cost.hpp`); without a library, every gate costs one unit.
+  Traces are stored as rows of a trace experiment, one row per pass.
+
+  `early_stopping` decides, from the gains observed so far, whether a pass
+  still pays off and whether the loop should continue.  With the default
+  parameters it reproduces the fixed criterion of the loops (stop once an
+  iteration reduces the size by at most 0.5%).  With `min_relative_rate`, a
+  pass is skipped once the number of gates it removes per second drops below
+  the given fraction of the best rate it has reached, and the loop stops when
+  all passes are skipped.  With `predict`, the gains of the last two
+  iterations are extrapolated geometrically, and the loop stops before an
+  iteration that is predicted to fall below `min_improvement`, which saves the
+  last, unproductive iteration.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <mockturtle/networks/xmg.hpp>
+
+#include "experiments.hpp"
+#include "xmg_genlib_cost.hpp"
+#include "xmg_profile.hpp"
+
+namespace experiments
+{
+
+/*! \brief State of the network after one pass of a loop */
+struct iteration_record
+{
+  uint32_t iteration{0u};
+  std::string pass;
+  uint32_t size{0u};
+  double sd_ratio{0.0};
+  double area{0.0};
+
+  /*! \brief Runtime of the pass in seconds */
+  double seconds{0.0};
+};
+
+class convergence_trace
+{
+public:
+  /*! \brief Estimates areas with `cost` (must outlive the trace), or counts gates without */
+  explicit convergence_trace( mockturtle::xmg_genlib_cost const* cost = nullptr )
+      : cost_( cost )
+  {
+  }
+
+  void add( uint32_t iteration, std::string const& pass, mockturtle::xmg_network const& xmg, double seconds )
+  {
+    auto const profile = mockturtle::profile_xmg_gates( xmg );
+    records_.push_back( {iteration, pass, profile.num_gates, profile.self_dual_ratio(), estimated_area( xmg ), seconds} );
+  }
+
+  void clear()
+  {
+    records_.clear();
+  }
+
+  std::vector<iteration_record> const& records() const
+  {
+    return records_;
+  }
+
+  nlohmann::json to_json() const
+  {
+    auto result = nlohmann::json::array();
+    for ( auto const& r : records_ )
+    {
+      result.push_back( {{"iteration", r.iteration}, {"pass", r.pass}, {"size", r.size}, {"sd_ratio", r.sd_ratio}, {"area", r.area}, {"seconds", r.seconds}} );
+    }
+    return result;
+  }
+
+  static convergence_trace from_json( nlohmann::json const& data )
+  {
+    convergence_trace trace;
+    for ( auto const& r : data )
+    {
+      trace.records_.push_back( {r["iteration"].get<uint32_t>(), r["pass"].get<std::string>(), r["size"].get<uint32_t>(),
+                                 r["sd_ratio"].get<double>(), r["area"].get<double>(), r["seconds"].get<double>()} );
+    }
+    return trace;
+  }
+
+  void report() const
+  {
+    for ( auto const& r : records_ )
+    {
+      fmt::print( "[i] iteration {:>3} {:<16} size = {:>8}  sd = {:>6.2f}%  area = {:>10.2f}  time = {:>8.2f} s\n",
+                  r.iteration, r.pass, r.size, 100.0 * r.sd_ratio, r.area, r.seconds );
+    }
+  }
+
+private:
+  double estimated_area( mockturtle::xmg_network const& xmg ) const
+  {
+    if ( !cost_ )
+    {
+      return xmg.num_gates();
+    }
+    double area{0.0};
+    xmg.foreach_gate( [&]( auto const& n ) {
+      area += cost_->area( xmg, n );
+    } );
+    return area;
+  }
+
+private:
+  mockturtle::xmg_genlib_cost const* cost_;
+  std::vector<iteration_record> records_;
+};
+
+using trace_experiment = experiment<std::string, uint32_t, std::string, uint32_t, double, double, double>;
+
+inline trace_experiment make_trace_experiment( std::string_view name )
+{
+  return trace_experiment( name, "benchmark", "iteration", "pass", "size", "sd ratio", "area", "time [s]" );
+}
+
+/*! \brief Appends the records of `trace` as rows for `benchmark` to a trace experiment */
+inline void add_trace( trace_experiment& exp, std::string const& benchmark, convergence_trace const& trace )
+{
+  for ( auto const& r : trace.records() )
+  {
+    exp( benchmark, r.iteration, r.pass, r.size, r.sd_ratio, r.area, r.seconds );
+  }
+}
+
+struct early_stopping_params
+{
+  /*! \brief Stop once an iteration reduces the size by at most this many percent */
+  double min_improvement{0.5};
+
+  /*! \brief Skip a pass once its gates removed per second drop below this fraction of its best rate (0: never skip) */
+  double min_relative_rate{0.0};
+
+  /*! \brief Stop before an iteration whose extrapolated improvement is at most `min_improvement` */
+  bool predict{false};
+};
+
+class early_stopping
+{
+private:
+  struct pass_state
+  {
+    std::string name;
+    double best_rate{0.0};
+    bool skipped{false};
+  };
+
+public:
+  explicit early_stopping( early_stopping_params const& ps = {} )
+      : ps_( ps )
+  {
+  }
+
+  /*! \brief Whether `pass` still pays off and should be run */
+  bool run( std::string const& pass ) const
+  {
+    auto const it = std::find_if( passes_.begin(), passes_.end(), [&]( auto const& p ) { return p.name == pass; } );
+    return it == passes_.end() || !it->skipped;
+  }
+
+  /*! \brief Records that `pass` took the size from `size_before` to `size_after` in `seconds` */
+  void pass_done( std::string const& pass, uint32_t size_before, uint32_t size_after, double seconds )
+  {
+    auto it = std::find_if( passes_.begin(), passes_.end(), [&]( auto const& p ) { return p.name == pass; } );
+    if ( it == passes_.end() )
+    {
+      passes_.push_back( {pass} );
+      it = std::prev( passes_.end() );
+    }
+
+    auto const gain = size_before > size_after ? double( size_before - size_after ) : 0.0;
+    auto const rate = gain / std::max( seconds, 1e-6 );
+    it->best_rate = std::max( it->best_rate, rate );
+    if ( ps_.min_relative_rate > 0.0 && rate <= ps_.min_relative_rate * it->best_rate )
+    {
+      it->skipped = true;
+      fmt::print( "[i] skipping {} in later iterations ({:.1f} gates/s, best {:.1f} gates/s)\n", pass, rate, it->best_rate );
+    }
+  }
+
+  /*! \brief Ends an iteration that took the size from `size_before` to `size_after`, returns whether to continue */
+  bool next_iteration( uint32_t size_before, uint32_t size_after )
+  {
+    auto const improvement = size_before == 0u ? 0.0 : 100.0 * ( double( size_before ) - double( size_after ) ) / size_before;
+    auto const previous = last_improvement_;
+    last_improvement_ = improvement;
+
+    if ( std::abs( improvement ) <= ps_.min_improvement )
+    {
+      return false;
+    }
+    if ( !passes_.empty() && std::all_of( passes_.begin(), passes_.end(), []( auto const& p ) { return p.skipped; } ) )
+    {
+      fmt::print( "[i] stopping early, no pass pays off anymore\n" );
+      return false;
+    }
+    if ( ps_.predict && previous > 0.0 && improvement > 0.0 && improvement < previous )
+    {
+      auto const predicted = improvement * improvement / previous;
+      if ( predicted <= ps_.min_improvement )
+      {
+        fmt::print( "[i] stopping early, next iteration predicted to improve by {:.2f}%\n", predicted );
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  early_stopping_params ps_;
+  std::vector<pass_state> passes_;
+  double last_improvement_{0.0};
+};
+
+/*! \brief Removes `--min-improvement X`, `--early-stop R`, and `--predict-stop` from `args` and returns the policy */
+inline early_stopping_params parse_early_stopping_params( std::vector<char*>& args, early_stopping_params ps = {} )
+{
+  std::vector<char*> rest;
+  for ( auto i = 0u; i < args.size(); ++i )
+  {
+    std::string const arg = args[i];
+    if ( arg == "--min-improvement" && i + 1 < args.size() )
+    {
+      ps.min_improvement = std::stod( args[++i] );
+    }
+    else if ( arg == "--early-stop" && i + 1 < args.size() )
+    {
+      ps.min_relative_rate = std::stod( args[++i] );
+    }
+    else if ( arg == "--predict-stop" )
+    {
+      ps.predict = true;
+    }
+    else
+    {
+      rest.push_back( args[i] );
+    }
+  }
+  args = rest;
+  return ps;
+}
+
+} // namespace experiments
@@ -0,0 +1,146 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/operations.hpp>
+#include <lorina/aiger.hpp>
+#include <mockturtle/algorithms/cut_enumeration.hpp>
+#include <mockturtle/io/aiger_reader.hpp>
+#include <mockturtle/networks/aig.hpp>
+
+#include <experiments.hpp>
+#include <static_cut_enumeration.hpp>
+
+using cut_experiment = experiments::experiment<std::string, uint32_t, uint32_t, uint64_t, uint64_t, experiments::sample_statistics, experiments::sample_statistics, double, bool>;
+
+/* cuts with the same leaves must have the same function; the static truth table of k < K leaves depends on the first k variables only */
+template<uint32_t K, class DynamicCuts, class StaticCuts>
+bool equal_cut_functions( mockturtle::aig_network const& aig, DynamicCuts const& dynamic_cuts, StaticCuts const& static_cuts )
+{
+  bool equal{true};
+  for ( auto index = 0u; index < aig.size(); ++index )
+  {
+    for ( auto const& c : static_cuts.cuts( index ) )
+    {
+      for ( auto const& d : dynamic_cuts.cuts( index ) )
+      {
+        if ( d->size() != c.size() || !std::equal( d->begin(), d->end(), c.begin() ) )
+        {
+          continue;
+        }
+        auto const tt = dynamic_cuts.truth_table( *d );
+        for ( auto b = 0u; b < ( 1u << c.size() ); ++b )
+        {
+          equal &= kitty::get_bit( tt, b ) == kitty::get_bit( c.function, b );
+        }
+      }
+    }
+  }
+  return equal;
+}
+
+/* dynamic cut_enumeration against static_cut_enumeration<K> with the same cut limit */
+template<uint32_t K>
+bool compare_cut_enumeration( cut_experiment& exp, std::string const& benchmark, mockturtle::aig_network const& aig, experiments::benchmark_params const& bps )
+{
+  using namespace mockturtle;
+
+  cut_enumeration_params ps;
+  ps.cut_size = K;
+  ps.cut_limit = 12u;
+  ps.minimize_truth_table = true;
+
+  uint64_t dynamic_cuts{0u};
+  auto const runtime_dynamic = experiments::repeat( bps, [&]() {
+    cut_enumeration_stats st;
+    auto const cuts = cut_enumeration<aig_network, true>( aig, ps, &st );
+    dynamic_cuts = cuts.total_cuts();
+    return to_seconds( st.time_total );
+  } );
+
+  uint64_t static_cuts{0u};
+  auto const runtime_static = experiments::repeat( bps, [&]() {
+    static_cut_enumeration_stats st;
+    auto const cuts = static_cut_enumeration<K, 12u>( aig, {}, &st );
+    static_cuts = cuts.total_cuts();
+    return to_seconds( st.time_total );
+  } );
+
+  bool const equal = equal_cut_functions<K>( aig, cut_enumeration<aig_network, true>( aig, ps ), static_cut_enumeration<K, 12u>( aig ) );
+  if ( !equal )
+  {
+    fmt::print( "[e] static and dynamic cut functions of {} differ for K = {}\n", benchmark, K );
+  }
+
+  exp( benchmark, K, aig.num_gates(), dynamic_cuts, static_cuts, runtime_dynamic, runtime_static,
+       runtime_static.median > 0 ? runtime_dynamic.median / runtime_static.median : 0.0, equal );
+  return equal;
+}
+
+int main( int argc, char** argv )
+{
+  using namespace experiments;
+  using namespace mockturtle;
+
+  auto const bps = parse_benchmark_params( argc, argv );
+
+  cut_experiment exp( "cut_enumeration", "benchmark", "K", "gates", "cuts (dynamic)", "cuts (static)", "dynamic", "static", "speedup", "equal" );
+
+  /* differing cut functions fail the benchmark */
+  bool equal{true};
+  for ( auto const& benchmark : epfl_benchmarks() )
+  {
+    fmt::print( "[i] processing {}\n", benchmark );
+    aig_network aig;
+    if ( lorina::read_aiger( benchmark_path( benchmark ), aiger_reader( aig ) ) != lorina::return_code::success )
+    {
+      continue;
+    }
+
+    equal &= compare_cut_enumeration<4u>( exp, benchmark, aig, bps );
+    equal &= compare_cut_enumeration<5u>( exp, benchmark, aig, bps );
+    equal &= compare_cut_enumeration<6u>( exp, benchmark, aig, bps );
+  }
+
+  exp.save();
+  exp.table();
+
+  if ( !equal )
+  {
+    return 1;
+  }
+
+  if ( !bps.baseline.empty() )
+  {
+    auto const regressions = exp.check_regressions( bps.baseline, {{"static", false, bps.threshold}} );
+    return regressions == 0u ? 0 : 1;
+  }
+
+  return 0;
+}
@@ -30,28 +30,146 @@
   \author Mathias Soeken
 */
 
+#pragma once
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <fmt/color.h>
 #include <fmt/format.h>
 #include <mockturtle/io/write_bench.hpp>
 #include <mockturtle/io/write_verilog.hpp>
 #include <mockturtle/io/write_blif.hpp>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/views/topo_view.hpp>
 #include <nlohmann/json.hpp>
 
 //#define genlib_path "/home/shubham/My_work/abc-vlsi-cad-flow/std_libs/date_lib_count_tt_2.genlib"
 namespace experiments
 {
 
+/*! \brief Summary of repeated measurements (e.g., runtimes in seconds) */
+struct sample_statistics
+{
+  sample_statistics() = default;
+
+  explicit sample_statistics( std::vector<double> values )
+      : samples( std::move( values ) )
+  {
+    if ( samples.empty() )
+    {
+      return;
+    }
+
+    std::vector<double> sorted = samples;
+    std::sort( sorted.begin(), sorted.end() );
+    auto const n = sorted.size();
+    min = sorted.front();
+    median = n % 2 == 1 ? sorted[n / 2] : 0.5 * ( sorted[n / 2 - 1] + sorted[n / 2] );
+
+    for ( auto const& v : sorted )
+    {
+      mean += v;
+    }
+    mean /= n;
+
+    if ( n > 1 )
+    {
+      for ( auto const& v : sorted )
+      {
+        stddev += ( v - mean ) * ( v - mean );
+      }
+      stddev = std::sqrt( stddev / ( n - 1 ) );
+    }
+  }
+
+  std::vector<double> samples;
+  double median{0.0};
+  double min{0.0};
+  double mean{0.0};
+  double stddev{0.0};
+};
+
+inline void to_json( nlohmann::json& j, sample_statistics const& s )
+{
+  j = {{"median", s.median}, {"min", s.min}, {"mean", s.mean}, {"stddev", s.stddev}, {"samples", s.samples}};
+}
+
+/* plain numbers are read as a single sample, such that old datasets remain comparable */
+inline void from_json( nlohmann::json const& j, sample_statistics& s )
+{
+  if ( j.is_number() )
+  {
+    s = sample_statistics( {j.get<double>()} );
+  }
+  else
+  {
+    s = sample_statistics( j.at( "samples" ).get<std::vector<double>>() );
+  }
+}
+
+/*! \brief One-sided Welch t-test at 95% confidence whether `a` has a larger mean than `b` */
+inline bool significantly_greater( sample_statistics const& a, sample_statistics const& b )
+{
+  /* one-sided critical values of Student's t-distribution (alpha = 0.05) for 1 to 30 degrees of freedom */
+  static constexpr std::array<double, 30> t_critical = {
+      6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+      1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+      1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697};
+
+  auto const n1 = a.samples.size();
+  auto const n2 = b.samples.size();
+  if ( n1 < 2u || n2 < 2u )
+  {
+    /* no variance information, fall back to comparing medians */
+    return a.median > b.median;
+  }
+
+  auto const v1 = a.stddev * a.stddev / n1;
+  auto const v2 = b.stddev * b.stddev / n2;
+  if ( v1 + v2 == 0.0 )
+  {
+    return a.mean > b.mean;
+  }
+
+  auto const t = ( a.mean - b.mean ) / std::sqrt( v1 + v2 );
+  auto const df = ( v1 + v2 ) * ( v1 + v2 ) / ( v1 * v1 / ( n1 - 1 ) + v2 * v2 / ( n2 - 1 ) );
+  auto const index = static_cast<uint32_t>( std::max( 1.0, std::floor( df ) ) );
+  return t > ( index <= t_critical.size() ? t_critical[index - 1u] : 1.645 );
+}
+
+/*! \brief Column that is checked by `experiment::check_regressions`
+ *
+ * Columns holding `sample_statistics` regress if the current samples are
+ * significantly worse (Welch t-test) and the median is worse by more than
+ * `threshold` (relative).  Plain numeric columns regress if they are worse by
+ * more than `threshold` (relative, use 0 for deterministic QoR columns).
+ */
+struct regression_criterion
+{
+  std::string column;
+  bool higher_is_better{false};
+  double threshold{0.0};
+};
+
 struct json_table
 {
   explicit json_table( nlohmann::json const& data, std::vector<std::string> const& columns )
@@ -107,6 +225,10 @@ private:
       {
         cell = fmt::format( "{}", static_cast<bool>( data ) );
       }
+      else if ( data.is_object() && data.contains( "median" ) )
+      {
+        cell = fmt::format( "{:.2f} ±{:.2f}", static_cast<float>( data["median"] ), static_cast<float>( data["stddev"] ) );
+      }
 
       max_widths_[ctr] = std::max<uint32_t>( max_widths_[ctr], cell.size() );
       ++ctr;
@@ -161,16 +283,9 @@ public:
   void save( std::string_view version = use_github_revision )
   {
     nlohmann::json entries;
-    for ( auto const& row : rows_ )
+    for ( auto i = 0u; i < rows_.size(); ++i )
     {
-      auto it = column_names_.begin();
-      nlohmann::json entry;
-      std::apply(
-          [&]( auto&&... args ) {
-            ( ( entry[*it++] = args ), ... );
-          },
-          row );
-      entries.push_back( entry );
+      entries.push_back( entry( i ) );
     }
 
     std::string version_;
@@ -199,6 +314,35 @@ public:
     rows_.emplace_back( args... );
   }
 
+  std::string const& name() const
+  {
+    return name_;
+  }
+
+  std::size_t num_rows() const
+  {
+    return rows_.size();
+  }
+
+  /*! \brief Row `index` as JSON object with one key per column */
+  nlohmann::json entry( std::size_t index ) const
+  {
+    auto it = column_names_.begin();
+    nlohmann::json entry;
+    std::apply(
+        [&]( auto&&... args ) {
+          ( ( entry[*it++] = args ), ... );
+        },
+        rows_.at( index ) );
+    return entry;
+  }
+
+  /*! \brief Appends a row given as JSON object, e.g., restored from a checkpoint */
+  void add_entry( nlohmann::json const& entry )
+  {
+    add_entry( entry, std::index_sequence_for<ColumnTypes...>{} );
+  }
+
   nlohmann::json const& dataset( std::string const& version, nlohmann::json const& def ) const
   {
     if ( version.empty() )
@@ -354,7 +498,107 @@ public:
     return true;
   }
 
+  /*! \brief Checks the latest dataset against a baseline version
+   *
+   * Rows are matched by the first column.  Every regression is printed and
+   * the number of regressions is returned, such that drivers can exit with a
+   * nonzero code.  A missing baseline is reported as one regression, and so
+   * is every row that is only in one of the two datasets, since such a row
+   * cannot be gated.
+   */
+  uint32_t check_regressions( std::string const& baseline_version,
+                              std::vector<regression_criterion> const& criteria,
+                              std::ostream& os = std::cout ) const
+  {
+    auto const it_base = std::find_if( data_.begin(), data_.end(), [&]( auto const& entry ) { return entry["version"] == baseline_version; } );
+    if ( data_.empty() || it_base == data_.end() )
+    {
+      fmt::print( "[e] baseline version {} not found\n", baseline_version );
+      return 1u;
+    }
+
+    auto const& entries_base = ( *it_base )["entries"];
+    auto const& entries_cur = data_.back()["entries"];
+
+    fmt::print( "[i] check " );
+    fmt::print( fg( fmt::terminal_color::blue ), "{}", data_.back()["version"] );
+    fmt::print( " against baseline " );
+    fmt::print( fg( fmt::terminal_color::blue ), "{}\n", baseline_version );
+
+    uint32_t regressions{0u};
+    for ( auto const& cur : entries_cur )
+    {
+      auto const& key = cur[column_names_.front()];
+      auto const base = std::find_if( entries_base.begin(), entries_base.end(), [&]( auto const& entry ) { return entry[column_names_.front()] == key; } );
+      if ( base == entries_base.end() )
+      {
+        ++regressions;
+        os << fmt::format( "[e] {} is missing in the baseline\n", key.dump() );
+        continue;
+      }
+
+      for ( auto const& c : criteria )
+      {
+        if ( !cur.contains( c.column ) || !base->contains( c.column ) )
+        {
+          continue;
+        }
+
+        nlohmann::json const& vcur = cur[c.column];
+        nlohmann::json const& vbase = ( *base )[c.column];
+        if ( !( vcur.is_number() || vcur.is_object() ) || !( vbase.is_number() || vbase.is_object() ) )
+        {
+          continue;
+        }
+
+        auto const scur = vcur.get<sample_statistics>();
+        auto const sbase = vbase.get<sample_statistics>();
+
+        bool worse;
+        if ( scur.samples.size() > 1u || sbase.samples.size() > 1u )
+        {
+          auto const significant = c.higher_is_better ? significantly_greater( sbase, scur ) : significantly_greater( scur, sbase );
+          auto const change = ( scur.median - sbase.median ) / std::max( std::abs( sbase.median ), 1e-9 );
+          worse = significant && ( c.higher_is_better ? -change : change ) > c.threshold;
+        }
+        else
+        {
+          auto const change = sbase.median == 0.0 ? scur.median - sbase.median : ( scur.median - sbase.median ) / std::abs( sbase.median );
+          worse = ( c.higher_is_better ? -change : change ) > c.threshold;
+        }
+
+        if ( worse )
+        {
+          ++regressions;
+          os << fmt::format( "[e] regression in {} column '{}': {:.4f} -> {:.4f}\n", key.dump(), c.column, sbase.median, scur.median );
+        }
+      }
+    }
+
+    for ( auto const& base : entries_base )
+    {
+      auto const& key = base[column_names_.front()];
+      if ( std::none_of( entries_cur.begin(), entries_cur.end(), [&]( auto const& entry ) { return entry[column_names_.front()] == key; } ) )
+      {
+        ++regressions;
+        os << fmt::format( "[e] {} is missing in the current dataset\n", key.dump() );
+      }
+    }
+
+    if ( regressions == 0u )
+    {
+      os << "[i] no regressions\n";
+    }
+    return regressions;
+  }
+
 private:
+  template<std::size_t... Is>
+  void add_entry( nlohmann::json const& entry, std::index_sequence<Is...> )
+  {
+    rows_.emplace_back( entry.at( column_names_[Is] ).template get<ColumnTypes>()... );
+  }
+
   std::string name_;
   std::string filename_;
   std::vector<std::string> column_names_;
@@ -363,6 +607,119 @@ private:
   nlohmann::json data_;
 };
 
+/*! \brief Settings for running each (benchmark, flow) pair repeatedly */
+struct benchmark_params
+{
+  /*! \brief Number of measured runs. */
+  uint32_t repetitions{1u};
+
+  /*! \brief Number of unmeasured runs before the measured ones. */
+  uint32_t warmup{0u};
+
+  /*! \brief Version to check regressions against (no check if empty). */
+  std::string baseline;
+
+  /*! \brief Tolerated relative runtime slowdown. */
+  double threshold{0.05};
+
+  /*! \brief Skip work recorded in the checkpoints of an interrupted run. */
+  bool resume{false};
+
+  /*! \brief Number of threads of pipelined flows (0: hardware concurrency). */
+  uint32_t jobs{1u};
+
+  uint32_t num_runs() const
+  {
+    return warmup + repetitions;
+  }
+};
+
+/*! \brief Reads `--repeat N`, `--warmup N`, `--baseline VERSION`, `--threshold X`, `--jobs N`, and `--resume` */
+inline benchmark_params parse_benchmark_params( int argc, char** argv )
+{
+  benchmark_params ps;
+  for ( auto i = 1; i < argc; ++i )
+  {
+    std::string const arg = argv[i];
+
+    /* the value of a flag, nullptr if the flag is the last argument */
+    auto const value = [&]() -> char const* {
+      if ( i + 1 == argc )
+      {
+        fmt::print( "[w] ignoring argument {} without a value\n", arg );
+        return nullptr;
+      }
+      return argv[++i];
+    };
+
+    if ( arg == "--resume" )
+    {
+      ps.resume = true;
+    }
+    else if ( arg == "--repeat" )
+    {
+      if ( auto const v = value() )
+      {
+        ps.repetitions = std::max( 1, std::stoi( v ) );
+      }
+    }
+    else if ( arg == "--warmup" )
+    {
+      if ( auto const v = value() )
+      {
+        ps.warmup = std::stoi( v );
+      }
+    }
+    else if ( arg == "--baseline" )
+    {
+      if ( auto const v = value() )
+      {
+        ps.baseline = v;
+      }
+    }
+    else if ( arg == "--threshold" )
+    {
+      if ( auto const v = value() )
+      {
+        ps.threshold = std::stod( v );
+      }
+    }
+    else if ( arg == "--jobs" )
+    {
+      if ( auto const v = value() )
+      {
+        ps.jobs = std::max( 0, std::stoi( v ) );
+      }
+    }
+    else
+    {
+      fmt::print( "[w] ignoring argument {}\n", arg );
+    }
+  }
+  return ps;
+}
+
+/*! \brief Calls `fn` `ps.warmup` times and then `ps.repetitions` times
+ *
+ * `fn` returns the runtime of one run in seconds; only the measured runs are
+ * part of the returned statistics.
+ */
+template<typename Fn>
+sample_statistics repeat( benchmark_params const& ps, Fn&& fn )
+{
+  for ( auto i = 0u; i < ps.warmup; ++i )
+  {
+    fn();
+  }
+
+  std::vector<double> samples;
+  for ( auto i = 0u; i < ps.repetitions; ++i )
+  {
+    samples.push_back( fn() );
+  }
+  return sample_statistics( samples );
+}
+
 // clang-format off
 static constexpr uint32_t adder      = 0b00000000000000000001;
 static constexpr uint32_t bar        = 0b00000000000000000010;
@@ -415,6 +772,16 @@ std::string benchmark_path( std::string const& benchmark_name, std::string const
 #endif
 }
 
+/*! \brief Path of a data file in the experiments directory (e.g., an NPN database) */
+std::string experiments_file_path( std::string const& filename )
+{
+#ifndef EXPERIMENTS_PATH
+  return filename;
+#else
+  return fmt::format( "{}{}", EXPERIMENTS_PATH, filename );
+#endif
+}
+
 std::string abc_path( std::string const& benchmark_name )
 {
 #ifndef EXPERIMENTS_PATH
@@ -424,122 +791,290 @@ std::string abc_path( std::string const& benchmark_name )
 #endif
 }
 
-template<class Ntk>
-bool abc_cec( Ntk const& ntk, std::string const& benchmark )
+/*! \brief File name in /tmp that is unique per process and object, the file is removed on destruction
+ *
+ * ABC helpers exchange networks through such files, so that concurrent calls
+ * do not overwrite each other's inputs.
+ */
+class temporary_file
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"cec -n {} /tmp/test.bench\"", benchmark_path( benchmark ) );
+public:
+  explicit temporary_file( std::string_view extension )
+  {
+    static std::atomic<uint64_t> counter{0u};
+    path_ = fmt::format( "/tmp/experiments_{}_{}.{}", getpid(), counter++, extension );
+  }
 
-  std::array<char, 128> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
+  ~temporary_file()
   {
-    throw std::runtime_error( "popen() failed" );
+    std::remove( path_.c_str() );
   }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
+
+  temporary_file( temporary_file const& ) = delete;
+  temporary_file& operator=( temporary_file const& ) = delete;
+
+  std::string const& path() const
   {
-    result += buffer.data();
+    return path_;
   }
 
-  return result.size() >= 23 && result.substr( 0u, 23u ) == "Networks are equivalent";
-}
+private:
+  std::string path_;
+};
 
-template <class Ntk>
-float abc_map (Ntk const& ntk, std::string const& genlib_path )
+/*! \brief File through which a network or result is exchanged with ABC
+ *
+ * On Linux the contents live in an anonymous `memfd` that the ABC process
+ * inherits and opens as `/dev/fd/N`, so nothing is written to disk and
+ * concurrent calls never collide; elsewhere a `temporary_file` is used.
+ */
+class abc_exchange_file
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; read_genlib {} ;map; print_gates\"", genlib_path);
-  
-  std::array<char, 1024> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
+public:
+  abc_exchange_file()
   {
-    throw std::runtime_error( "popen() failed" );
+#ifdef __linux__
+    fd_ = memfd_create( "experiments_abc", 0 );
+    if ( fd_ >= 0 )
+    {
+      path_ = fmt::format( "/dev/fd/{}", fd_ );
+      return;
+    }
+#endif
+    file_ = std::make_unique<temporary_file>( "aig" );
+    path_ = file_->path();
   }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
+
+  ~abc_exchange_file()
   {
-    result += buffer.data();
+    if ( fd_ >= 0 )
+    {
+      close( fd_ );
+    }
   }
 
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
+  abc_exchange_file( abc_exchange_file const& ) = delete;
+  abc_exchange_file& operator=( abc_exchange_file const& ) = delete;
 
-  std::string total_str = result.substr ( result.find( "TOTAL " ) + 1);
-  uint32_t sp = total_str.find( "Area" );
-  uint32_t lp = total_str.find( "100 \%" );
-  //std::cout << " sp "<< sp << " lp " << lp << std::endl;
-  std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) ); // 6 as to ignore "=" 
-  //std::cout << " value of str1 = " << str1 << std::endl;
+  /*! \brief Path under which ABC reads or writes the contents */
+  std::string const& path() const
+  {
+    return path_;
+  }
 
-  return std::stof( str1 ); 
-}
+  void write( std::string const& data )
+  {
+    if ( file_ )
+    {
+      std::ofstream( path_, std::ofstream::out | std::ofstream::binary ).write( data.data(), data.size() );
+      return;
+    }
 
-template <class Ntk>
-float abc_map_dc2 (Ntk const& ntk, std::string const& genlib_path )
+    std::size_t offset = 0u;
+    while ( offset < data.size() )
+    {
+      auto const written = pwrite( fd_, data.data() + offset, data.size() - offset, offset );
+      if ( written <= 0 )
+      {
+        throw std::runtime_error( "abc_exchange_file: write failed" );
+      }
+      offset += written;
+    }
+  }
+
+  std::string read() const
+  {
+    if ( file_ )
+    {
+      std::ifstream is( path_, std::ifstream::in | std::ifstream::binary );
+      return std::string( std::istreambuf_iterator<char>( is ), std::istreambuf_iterator<char>() );
+    }
+
+    /* ABC reopens the memfd by path, the data written there is visible here */
+    std::string data;
+    std::array<char, 65536> buffer;
+    off_t offset = 0;
+    ssize_t num_read;
+    while ( ( num_read = pread( fd_, buffer.data(), buffer.size(), offset ) ) > 0 )
+    {
+      data.append( buffer.data(), num_read );
+      offset += num_read;
+    }
+    return data;
+  }
+
+private:
+  int fd_{-1};
+  std::unique_ptr<temporary_file> file_;
+  std::string path_;
+};
+
+namespace detail
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; read_genlib {} ;strash; dc2; map; print_gates\"", genlib_path);
-  
-  std::array<char, 1024> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
+
+/*! \brief AND gates of a binary AIGER file, other gates are decomposed on the fly */
+class aiger_encoder
+{
+public:
+  explicit aiger_encoder( uint32_t num_pis )
+      : num_pis( num_pis )
   {
-    throw std::runtime_error( "popen() failed" );
   }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
+
+  uint32_t create_and( uint32_t a, uint32_t b )
   {
-    result += buffer.data();
+    if ( a > b )
+    {
+      std::swap( a, b );
+    }
+    if ( a == 0u || a == ( b ^ 1u ) )
+    {
+      return 0u;
+    }
+    if ( a == 1u || a == b )
+    {
+      return b;
+    }
+    ands.emplace_back( b, a );
+    return 2u * ( num_pis + static_cast<uint32_t>( ands.size() ) );
   }
 
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
+  uint32_t create_or( uint32_t a, uint32_t b )
+  {
+    return create_and( a ^ 1u, b ^ 1u ) ^ 1u;
+  }
 
-  std::string total_str = result.substr ( result.find( "TOTAL " ) + 1);
-  uint32_t sp = total_str.find( "Area" );
-  uint32_t lp = total_str.find( "100 \%" );
-  //std::cout << " sp "<< sp << " lp " << lp << std::endl;
-  std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) ); // 6 as to ignore "=" 
-  //std::cout << " value of str1 = " << str1 << std::endl;
+  uint32_t create_xor( uint32_t a, uint32_t b )
+  {
+    if ( a <= 1u || b <= 1u )
+    {
+      return a ^ b;
+    }
+    return create_or( create_and( a, b ^ 1u ), create_and( a ^ 1u, b ) );
+  }
 
-  return std::stof( str1 ); 
-}
+  uint32_t create_maj( uint32_t a, uint32_t b, uint32_t c )
+  {
+    return create_or( create_and( a, b ), create_and( c, create_or( a, b ) ) );
+  }
 
-template <class Ntk>
-float abc_map_compress2rs (Ntk const& ntk, std::string const& genlib_path )
-{
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; read_genlib {} ;strash; compress2rs; map; print_gates\"", genlib_path);
-  
-  std::array<char, 1024> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
+  void write( std::ostream& os, std::vector<uint32_t> const& outputs ) const
   {
-    throw std::runtime_error( "popen() failed" );
+    auto const num_ands = static_cast<uint32_t>( ands.size() );
+    os << fmt::format( "aig {} {} 0 {} {}\n", num_pis + num_ands, num_pis, outputs.size(), num_ands );
+    for ( auto const& o : outputs )
+    {
+      os << o << '\n';
+    }
+
+    /* the delta encoding relies on fanins being created before their gates */
+    for ( auto i = 0u; i < num_ands; ++i )
+    {
+      auto const lhs = 2u * ( num_pis + i + 1u );
+      write_delta( os, lhs - ands[i].first );
+      write_delta( os, ands[i].first - ands[i].second );
+    }
   }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
+
+private:
+  static void write_delta( std::ostream& os, uint32_t delta )
   {
-    result += buffer.data();
+    while ( delta & ~0x7fu )
+    {
+      os.put( static_cast<char>( ( delta & 0x7fu ) | 0x80u ) );
+      delta >>= 7u;
+    }
+    os.put( static_cast<char>( delta ) );
   }
 
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
+private:
+  uint32_t num_pis;
+  std::vector<std::pair<uint32_t, uint32_t>> ands;
+};
 
-  std::string total_str = result.substr ( result.find( "TOTAL " ) + 1);
-  uint32_t sp = total_str.find( "Area" );
-  uint32_t lp = total_str.find( "100 \%" );
-  //std::cout << " sp "<< sp << " lp " << lp << std::endl;
-  std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) ); // 6 as to ignore "=" 
-  //std::cout << " value of str1 = " << str1 << std::endl;
+} // namespace detail
 
-  return std::stof( str1 ); 
+/*! \brief Writes `ntk` as binary AIGER, XOR, MAJ, and XOR3 gates are decomposed into ANDs */
+template<class Ntk>
+void write_binary_aiger( Ntk const& ntk, std::ostream& os )
+{
+  detail::aiger_encoder enc( ntk.num_pis() );
+  std::vector<uint32_t> lits( ntk.size(), 0u );
+  ntk.foreach_pi( [&]( auto const& n, auto i ) {
+    lits[ntk.node_to_index( n )] = 2u * ( i + 1u );
+  } );
+
+  auto const lit = [&]( auto const& f ) {
+    return lits[ntk.node_to_index( ntk.get_node( f ) )] ^ ( ntk.is_complemented( f ) ? 1u : 0u );
+  };
+
+  /* gates are encoded in topological order, as AIGER requires */
+  mockturtle::topo_view topo{ntk};
+  topo.foreach_gate( [&]( auto const& n ) {
+    std::array<uint32_t, 3u> fanins{};
+    ntk.foreach_fanin( n, [&]( auto const& f, auto i ) {
+      fanins[i] = lit( f );
+    } );
+
+    auto& l = lits[ntk.node_to_index( n )];
+    if constexpr ( mockturtle::has_is_xor3_v<Ntk> )
+    {
+      if ( ntk.is_xor3( n ) )
+      {
+        l = enc.create_xor( enc.create_xor( fanins[0], fanins[1] ), fanins[2] );
+        return;
+      }
+    }
+    if constexpr ( mockturtle::has_is_maj_v<Ntk> )
+    {
+      if ( ntk.is_maj( n ) )
+      {
+        l = enc.create_maj( fanins[0], fanins[1], fanins[2] );
+        return;
+      }
+    }
+    if constexpr ( mockturtle::has_is_xor_v<Ntk> )
+    {
+      if ( ntk.is_xor( n ) )
+      {
+        l = enc.create_xor( fanins[0], fanins[1] );
+        return;
+      }
+    }
+    if constexpr ( mockturtle::has_is_and_v<Ntk> )
+    {
+      if ( ntk.is_and( n ) )
+      {
+        l = enc.create_and( fanins[0], fanins[1] );
+        return;
+      }
+    }
+    throw std::runtime_error( "write_binary_aiger: unsupported gate type" );
+  } );
+
+  std::vector<uint32_t> outputs;
+  ntk.foreach_po( [&]( auto const& f ) {
+    outputs.push_back( lit( f ) );
+  } );
+  enc.write( os, outputs );
 }
-template <class Ntk>
-float abc_map_dch (Ntk const& ntk, std::string const& genlib_path )
+
+/*! \brief Exchange file that holds `ntk` as binary AIGER, ABC reads it with `&r` */
+template<class Ntk>
+std::unique_ptr<abc_exchange_file> abc_input( Ntk const& ntk )
+{
+  std::ostringstream os;
+  write_binary_aiger( ntk, os );
+  auto file = std::make_unique<abc_exchange_file>();
+  file->write( os.str() );
+  return file;
+}
+
+/*! \brief Runs the ABC commands in `script` and returns ABC's output */
+inline std::string run_abc( std::string const& script )
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; read_genlib {} ;strash; dch; map; print_gates\"", genlib_path);
-  
+  std::string const command = fmt::format( "abc -q \"{}\"", script );
+
   std::array<char, 1024> buffer;
   std::string result;
   std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
@@ -551,47 +1086,80 @@ float abc_map_dch (Ntk const& ntk, std::string const& genlib_path )
   {
     result += buffer.data();
   }
+  return result;
+}
+
+template<class Ntk>
+bool abc_cec( Ntk const& ntk, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+{
+  auto const input = abc_input( ntk );
+  auto const result = run_abc( fmt::format( "read {}; strash; &get; &cec {}", benchmark_path( benchmark, path_type, file_type ), input->path() ) );
+  return result.find( "Networks are equivalent" ) != std::string::npos;
+}
+
+/*! \brief `abc_cec` for networks that are exchanged as BLIF, e.g., the k-LUT netlist of a mapping */
+template<class Ntk>
+bool abc_cec_blif( Ntk const& ntk, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+{
+  std::ostringstream os;
+  mockturtle::write_blif( ntk, os );
+  abc_exchange_file blif, aiger;
+  blif.write( os.str() );
+  auto const result = run_abc( fmt::format( "read_blif {}; strash; write_aiger {}; read {}; strash; &get; &cec {}",
+                                            blif.path(), aiger.path(), benchmark_path( benchmark, path_type, file_type ), aiger.path() ) );
+  return result.find( "Networks are equivalent" ) != std::string::npos;
+}
 
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
+/*! \brief Maps `ntk` with ABC's `map` after the optimization commands in `script` and returns the area */
+template<class Ntk>
+float abc_map_after( Ntk const& ntk, std::string const& genlib_path, std::string const& script )
+{
+  auto const input = abc_input( ntk );
+  auto const result = run_abc( fmt::format( "&r {}; &put; read_genlib {}; {}map; print_gates", input->path(), genlib_path, script ) );
 
   std::string total_str = result.substr ( result.find( "TOTAL " ) + 1);
   uint32_t sp = total_str.find( "Area" );
   uint32_t lp = total_str.find( "100 \%" );
-  //std::cout << " sp "<< sp << " lp " << lp << std::endl;
   std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) ); // 6 as to ignore "=" 
-  //std::cout << " value of str1 = " << str1 << std::endl;
 
   return std::stof( str1 ); 
 }
 
 template <class Ntk>
-float abc_map_rsrw (Ntk const& ntk, std::string const& genlib_path )
+float abc_map (Ntk const& ntk, std::string const& genlib_path )
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; read_genlib {} ;strash; rw; rs; map; print_gates\"", genlib_path);
-  
-  std::array<char, 1024> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
-  {
-    throw std::runtime_error( "popen() failed" );
-  }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
-  {
-    result += buffer.data();
-  }
+  return abc_map_after( ntk, genlib_path, "" );
+}
 
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
+/*! \brief Area of `ntk` after standard-cell mapping with ABC's `map` */
+template<class Ntk>
+float abc_techmap( Ntk const& ntk, std::string const& genlib_path )
+{
+  return abc_map( ntk, genlib_path );
+}
 
-  std::string total_str = result.substr ( result.find( "TOTAL " ) + 1);
-  uint32_t sp = total_str.find( "Area" );
-  uint32_t lp = total_str.find( "100 \%" );
-  //std::cout << " sp "<< sp << " lp " << lp << std::endl;
-  std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) ); // 6 as to ignore "=" 
-  //std::cout << " value of str1 = " << str1 << std::endl;
+template <class Ntk>
+float abc_map_dc2 (Ntk const& ntk, std::string const& genlib_path )
+{
+  return abc_map_after( ntk, genlib_path, "strash; dc2; " );
+}
 
-  return std::stof( str1 ); 
+template <class Ntk>
+float abc_map_compress2rs (Ntk const& ntk, std::string const& genlib_path )
+{
+  return abc_map_after( ntk, genlib_path, "strash; compress2rs; " );
+}
+
+template <class Ntk>
+float abc_map_dch (Ntk const& ntk, std::string const& genlib_path )
+{
+  return abc_map_after( ntk, genlib_path, "strash; dch; " );
+}
+
+template <class Ntk>
+float abc_map_rsrw (Ntk const& ntk, std::string const& genlib_path )
+{
+  return abc_map_after( ntk, genlib_path, "strash; rw; rs; " );
 }
 
 struct lut_info
@@ -603,33 +1171,14 @@ struct lut_info
 template <class Ntk>
 lut_info abc_lut_mapper_if( Ntk const& ntk )
 {
-  mockturtle::write_bench( ntk, "/tmp/test.bench" );
-  std::string command = fmt::format( "abc -q \"read /tmp/test.bench; if -K 6 ; print_stats\"" );
+  auto const input = abc_input( ntk );
+  auto const result = run_abc( fmt::format( "&r {}; &put; if -K 6 ; print_stats", input->path() ) );
 
   lut_info ldata;
-  std::array<char, 1024> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );
-  if ( !pipe )
-  {
-    throw std::runtime_error( "popen() failed" );
-  }
-  while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
-  {
-    result += buffer.data();
-  }
-
-  std :: cout << "results for mapping ============" <<  std::endl << result << std::endl;
-
   std::string node_str = result.substr ( result.find( "nd =" ) + 5, 5);
   std::string lev_str = result.substr ( result.find( "lev" ) + 6 ); 
-  std::cout << "node_str ---------> " << node_str << std::endl;
-  std::cout << "lev_str ------>  " << lev_str << std::endl;
   ldata.depth = std::stoi( lev_str );
   ldata.size = std::stoi( node_str );
-  //uint32_t sp = total_str.find( "Area" );
-  //uint32_t lp = total_str.find( "100 \%" );
-  //std::string str1 = total_str.substr ( ( sp + 6 ), ( lp - sp - 6 ) );
   return ldata;
 
 }
@@ -637,40 +1186,14 @@ lut_info abc_lut_mapper_if( Ntk const& ntk )
 
 void abc_lut_reader_if ( std::string const& benchmark )
 {
-     std::string command = fmt::format( "abc -q \"read {}; if -K 4; print_stats; write_bench {}\"", benchmark_path ( benchmark ), benchmark_path( benchmark, "_if_bench", "bench") );
-
-    std::array<char, 1024> buffer;
-    std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );    
-    std::string result;
-
-    if ( !pipe )
-    {
-        throw std::runtime_error( "popen() failed" );
-    }
-    while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
-    {
-        result += buffer.data();
-    }
+    auto const result = run_abc( fmt::format( "read {}; if -K 4; print_stats; write_bench {}", benchmark_path ( benchmark ), benchmark_path( benchmark, "_if_bench", "bench") ) );
     std::cout << "result LUT mapped ===============" << std::endl <<  std::endl;
     std::cout << result << std::endl;
 }
 
 void abc_lut_reader_mf ( std::string const& benchmark )
 {
-     std::string command = fmt::format( "abc -q \"read {};&get; &mf -K 4;&put print_stats; write_bench {}\"", benchmark_path ( benchmark ), benchmark_path( benchmark, "_mf_bench", "bench") );
-
-    std::array<char, 1024> buffer;
-    std::unique_ptr<FILE, decltype( &pclose )> pipe( popen( command.c_str(), "r" ), pclose );    
-    std::string result;
-
-    if ( !pipe )
-    {
-        throw std::runtime_error( "popen() failed" );
-    }
-    while ( fgets( buffer.data(), buffer.size(), pipe.get() ) != nullptr )
-    {
-        result += buffer.data();
-    }
+    auto const result = run_abc( fmt::format( "read {};&get; &mf -K 4;&put print_stats; write_bench {}", benchmark_path ( benchmark ), benchmark_path( benchmark, "_mf_bench", "bench") ) );
     std::cout << "result LUT mapped ===============" << std::endl <<  std::endl;
     std::cout << result << std::endl;
 }
@@ -0,0 +1,467 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file golden_signatures.hpp
+  \brief Cached simulation signatures of the reference benchmarks
+
+  Equivalence checks compare an optimized network against the benchmark file
+  it was derived from.  The golden signature of a benchmark consists of the values of
+  its outputs under a fixed set of input patterns: random patterns and
+  structured ones (all zeros, all ones, and a walking one and a walking zero
+  over the inputs).  Signatures are computed once per process and benchmark
+  file and are stored in `golden/` under the 64-bit FNV-1a hash of the file
+  contents, so that later runs only hash the file.
+
+  `golden_cec` simulates the optimized network with the same patterns and
+  only calls ABC's `cec` if the signatures agree.  ABC reads and strashes the
+  benchmark file once per process into an in-memory AIGER file, which all
+  later formal checks load with `&r`, and networks that are structurally
+  identical to an already verified one are not checked again.  The cache may
+  be used from several threads.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/format.h>
+#include <lorina/aiger.hpp>
+#include <lorina/verilog.hpp>
+#include <mockturtle/io/aiger_reader.hpp>
+#include <mockturtle/io/verilog_reader.hpp>
+#include <mockturtle/networks/xmg.hpp>
+
+#include "experiments.hpp"
+#include "xmg_simulation.hpp"
+
+namespace experiments
+{
+
+struct golden_signature_params
+{
+  /*! \brief Number of 64-bit words of random patterns. */
+  uint32_t random_words{16u};
+
+  /*! \brief Add all-zero, all-one, walking-one, and walking-zero patterns. */
+  bool structured_patterns{true};
+
+  /*! \brief Seed for the random patterns. */
+  uint64_t seed{0x5eed};
+
+  /*! \brief Store signatures in `golden/` to reuse them across runs. */
+  bool persistent{true};
+};
+
+struct golden_signature_stats
+{
+  /*! \brief Benchmarks read and simulated. */
+  uint32_t num_computed{0u};
+
+  /*! \brief Benchmarks whose signature was read from `golden/`. */
+  uint32_t num_restored{0u};
+
+  /*! \brief Checks answered from the in-memory cache. */
+  uint32_t num_hits{0u};
+
+  /*! \brief Checks that found a differing output. */
+  uint32_t num_mismatches{0u};
+
+  /*! \brief Formal checks skipped for already verified structures. */
+  uint32_t num_verified_hits{0u};
+
+  void report() const
+  {
+    fmt::print( "[i] golden signatures: {} computed, {} restored, {} cache hits, {} mismatches, {} verified structures reused\n",
+                num_computed, num_restored, num_hits, num_mismatches, num_verified_hits );
+  }
+};
+
+struct golden_signature
+{
+  uint64_t content_hash{0u};
+  uint32_t num_pis{0u};
+  uint32_t num_pos{0u};
+  uint32_t num_words{0u};
+
+  /*! \brief `num_words` words per output */
+  std::vector<uint64_t> outputs;
+};
+
+/*! \brief 64-bit FNV-1a hash of a file, 0 if it cannot be read */
+inline uint64_t file_content_hash( std::string const& filename )
+{
+  std::ifstream is( filename, std::ifstream::in | std::ifstream::binary );
+  if ( !is.good() )
+  {
+    return 0u;
+  }
+
+  uint64_t hash = 0xcbf29ce484222325;
+  std::vector<char> buffer( 1u << 16 );
+  while ( is.read( buffer.data(), buffer.size() ), is.gcount() > 0 )
+  {
+    for ( auto i = 0; i < is.gcount(); ++i )
+    {
+      hash = ( hash ^ static_cast<uint8_t>( buffer[i] ) ) * 0x100000001b3;
+    }
+  }
+  return hash;
+}
+
+/*! \brief 64-bit FNV-1a hash of the structure of `ntk` (inputs, gate fanins, and outputs) */
+inline uint64_t structural_hash( mockturtle::xmg_network const& ntk )
+{
+  uint64_t hash = 0xcbf29ce484222325;
+  auto const add = [&]( uint64_t value ) {
+    hash = ( hash ^ value ) * 0x100000001b3;
+  };
+  auto const add_signal = [&]( auto const& f ) {
+    add( ( uint64_t( ntk.node_to_index( ntk.get_node( f ) ) ) << 1 ) | ( ntk.is_complemented( f ) ? 1u : 0u ) );
+  };
+
+  add( ntk.num_pis() );
+  ntk.foreach_gate( [&]( auto const& n ) {
+    add( ntk.node_to_index( n ) );
+    ntk.foreach_fanin( n, add_signal );
+  } );
+  ntk.foreach_po( add_signal );
+  return hash;
+}
+
+/*! \brief Number of 64-bit words per signal for `num_pis` inputs */
+inline uint32_t golden_num_words( uint32_t num_pis, golden_signature_params const& ps )
+{
+  uint32_t const num_structured = ps.structured_patterns ? 2u * num_pis + 2u : 0u;
+  return ps.random_words + ( num_structured + 63u ) / 64u;
+}
+
+/*! \brief Input patterns, `golden_num_words` words per primary input */
+inline std::vector<std::vector<uint64_t>> golden_patterns( uint32_t num_pis, golden_signature_params const& ps )
+{
+  uint32_t const num_words = golden_num_words( num_pis, ps );
+
+  std::vector<std::vector<uint64_t>> patterns( num_pis, std::vector<uint64_t>( num_words, 0u ) );
+  std::mt19937_64 rng( ps.seed );
+  for ( auto& words : patterns )
+  {
+    for ( auto w = 0u; w < ps.random_words; ++w )
+    {
+      words[w] = rng();
+    }
+  }
+
+  /* pattern 0 is all zeros, 1 all ones, 2 + i has only input i set, 2 + n + i only input i cleared */
+  auto const set = [&]( uint32_t pi, uint32_t pattern ) {
+    patterns[pi][ps.random_words + pattern / 64u] |= uint64_t( 1 ) << ( pattern % 64u );
+  };
+  for ( auto i = 0u; i < num_pis && ps.structured_patterns; ++i )
+  {
+    set( i, 1u );
+    set( i, 2u + i );
+    for ( auto j = 0u; j < num_pis; ++j )
+    {
+      if ( j != i )
+      {
+        set( j, 2u + num_pis + i );
+      }
+    }
+  }
+  return patterns;
+}
+
+/*! \brief Simulates the outputs of `ntk` under `golden_patterns` */
+inline std::vector<uint64_t> simulate_golden_patterns( mockturtle::xmg_network const& ntk, golden_signature_params const& ps )
+{
+  auto const patterns = golden_patterns( ntk.num_pis(), ps );
+  uint32_t const num_words = golden_num_words( ntk.num_pis(), ps );
+
+  mockturtle::xmg_simulator sim( ntk, num_words );
+  ntk.foreach_pi( [&]( auto const& n, auto i ) {
+    sim.set_pi( n, patterns[i] );
+  } );
+  sim.simulate();
+
+  std::vector<uint64_t> outputs;
+  outputs.reserve( static_cast<std::size_t>( ntk.num_pos() ) * num_words );
+  ntk.foreach_po( [&]( auto const& f ) {
+    auto const value = sim.value( f );
+    outputs.insert( outputs.end(), value.begin(), value.end() );
+  } );
+  return outputs;
+}
+
+class golden_signature_cache
+{
+public:
+  explicit golden_signature_cache( golden_signature_params const& ps = {} )
+      : ps_( ps )
+  {
+#ifndef EXPERIMENTS_PATH
+    directory_ = "golden/";
+#else
+    directory_ = fmt::format( "{}golden/", EXPERIMENTS_PATH );
+#endif
+  }
+
+  /*! \brief Signature of a benchmark, nullptr if the benchmark cannot be read */
+  golden_signature const* get( std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+  {
+    /* references to elements stay valid when the map grows */
+    std::lock_guard lock( mutex_ );
+    auto const filename = benchmark_path( benchmark, path_type, file_type );
+    if ( auto it = cache_.find( filename ); it != cache_.end() )
+    {
+      ++st_.num_hits;
+      return &it->second;
+    }
+
+    golden_signature sig;
+    sig.content_hash = file_content_hash( filename );
+    if ( sig.content_hash == 0u )
+    {
+      return nullptr;
+    }
+
+    if ( restore( sig ) )
+    {
+      ++st_.num_restored;
+    }
+    else
+    {
+      mockturtle::xmg_network golden;
+      if ( !read_golden( filename, file_type, golden ) )
+      {
+        return nullptr;
+      }
+      sig.num_pis = golden.num_pis();
+      sig.num_pos = golden.num_pos();
+      sig.outputs = simulate_golden_patterns( golden, ps_ );
+      sig.num_words = golden_num_words( sig.num_pis, ps_ );
+      ++st_.num_computed;
+      store( sig );
+    }
+
+    return &cache_.emplace( filename, std::move( sig ) ).first->second;
+  }
+
+  /*! \brief Returns false if `ntk` is certainly not equivalent to the benchmark
+   *
+   * Also returns true if the benchmark cannot be read, such that the formal
+   * check decides.
+   */
+  bool matches( mockturtle::xmg_network const& ntk, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+  {
+    auto const* sig = get( benchmark, path_type, file_type );
+    if ( sig == nullptr )
+    {
+      return true;
+    }
+
+    if ( ntk.num_pis() != sig->num_pis || ntk.num_pos() != sig->num_pos || simulate_golden_patterns( ntk, ps_ ) != sig->outputs )
+    {
+      std::lock_guard lock( mutex_ );
+      ++st_.num_mismatches;
+      return false;
+    }
+    return true;
+  }
+
+  /*! \brief Benchmark as structurally hashed binary AIGER, nullptr if ABC cannot read it
+   *
+   * The file is written by ABC on the first call and kept in memory for the
+   * lifetime of the cache.
+   */
+  abc_exchange_file const* golden_aiger( std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+  {
+    std::lock_guard lock( mutex_ );
+    auto const filename = benchmark_path( benchmark, path_type, file_type );
+    if ( auto it = aigers_.find( filename ); it != aigers_.end() )
+    {
+      return it->second.get();
+    }
+
+    auto file = std::make_unique<abc_exchange_file>();
+    run_abc( fmt::format( "read {}; strash; write_aiger {}", filename, file->path() ) );
+    if ( file->read().empty() )
+    {
+      file.reset();
+    }
+    return aigers_.emplace( filename, std::move( file ) ).first->second.get();
+  }
+
+  /*! \brief Returns true if a network with this structural hash was proven equivalent to the benchmark */
+  bool verified( uint64_t structure, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+  {
+    std::lock_guard lock( mutex_ );
+    auto const it = verified_.find( benchmark_path( benchmark, path_type, file_type ) );
+    if ( it == verified_.end() || it->second.count( structure ) == 0u )
+    {
+      return false;
+    }
+    ++st_.num_verified_hits;
+    return true;
+  }
+
+  void add_verified( uint64_t structure, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+  {
+    std::lock_guard lock( mutex_ );
+    verified_[benchmark_path( benchmark, path_type, file_type )].insert( structure );
+  }
+
+  golden_signature_stats const& stats() const
+  {
+    return st_;
+  }
+
+private:
+  static bool read_golden( std::string const& filename, std::string const& file_type, mockturtle::xmg_network& golden )
+  {
+    if ( file_type == "aig" )
+    {
+      return lorina::read_aiger( filename, mockturtle::aiger_reader( golden ) ) == lorina::return_code::success;
+    }
+    else if ( file_type == "v" )
+    {
+      return lorina::read_verilog( filename, mockturtle::verilog_reader( golden ) ) == lorina::return_code::success;
+    }
+    return false;
+  }
+
+  std::string signature_path( uint64_t content_hash ) const
+  {
+    return fmt::format( "{}{:016x}.sig", directory_, content_hash );
+  }
+
+  /* header: content hash, random words, structured flag, seed, #PIs, #POs, #words */
+  bool restore( golden_signature& sig ) const
+  {
+    if ( !ps_.persistent )
+    {
+      return false;
+    }
+
+    std::ifstream is( signature_path( sig.content_hash ), std::ifstream::in | std::ifstream::binary );
+    uint64_t header[7];
+    if ( !is.read( reinterpret_cast<char*>( header ), sizeof( header ) ) || header[0] != sig.content_hash ||
+         header[1] != ps_.random_words || header[2] != uint64_t( ps_.structured_patterns ) || header[3] != ps_.seed )
+    {
+      return false;
+    }
+
+    sig.num_pis = static_cast<uint32_t>( header[4] );
+    sig.num_pos = static_cast<uint32_t>( header[5] );
+    sig.num_words = static_cast<uint32_t>( header[6] );
+    sig.outputs.resize( static_cast<std::size_t>( sig.num_pos ) * sig.num_words );
+    return static_cast<bool>( is.read( reinterpret_cast<char*>( sig.outputs.data() ), sig.outputs.size() * sizeof( uint64_t ) ) );
+  }
+
+  void store( golden_signature const& sig ) const
+  {
+    if ( !ps_.persistent )
+    {
+      return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories( directory_, ec );
+    auto const filename = signature_path( sig.content_hash );
+    {
+      std::ofstream os( filename + ".tmp", std::ofstream::out | std::ofstream::binary );
+      uint64_t const header[7] = {sig.content_hash, ps_.random_words, uint64_t( ps_.structured_patterns ), ps_.seed, sig.num_pis, sig.num_pos, sig.num_words};
+      os.write( reinterpret_cast<char const*>( header ), sizeof( header ) );
+      os.write( reinterpret_cast<char const*>( sig.outputs.data() ), sig.outputs.size() * sizeof( uint64_t ) );
+    }
+    std::filesystem::rename( filename + ".tmp", filename, ec );
+  }
+
+private:
+  golden_signature_params ps_;
+  golden_signature_stats st_;
+  std::string directory_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, golden_signature> cache_;
+  std::unordered_map<std::string, std::unique_ptr<abc_exchange_file>> aigers_;
+  std::unordered_map<std::string, std::unordered_set<uint64_t>> verified_;
+};
+
+/*! \brief Process-wide cache used by `golden_cec` */
+inline golden_signature_cache& golden_signatures()
+{
+  static golden_signature_cache cache;
+  return cache;
+}
+
+/*! \brief `abc_cec` that first compares against the cached golden signature
+ *
+ * Networks with differing signatures are reported as not equivalent without
+ * calling ABC, and networks with the structure of an already verified network
+ * are reported as equivalent.  Otherwise, ABC compares the network against
+ * the cached AIGER of the benchmark.
+ */
+inline bool golden_cec( mockturtle::xmg_network const& ntk, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
+{
+  auto& cache = golden_signatures();
+  if ( !cache.matches( ntk, benchmark, path_type, file_type ) )
+  {
+    fmt::print( "[e] {} differs from the golden signature\n", benchmark );
+    return false;
+  }
+
+  auto const structure = structural_hash( ntk );
+  if ( cache.verified( structure, benchmark, path_type, file_type ) )
+  {
+    return true;
+  }
+
+  bool equivalent;
+  if ( auto const* golden = cache.golden_aiger( benchmark, path_type, file_type ) )
+  {
+    auto const input = abc_input( ntk );
+    equivalent = run_abc( fmt::format( "&r {}; &cec {}", golden->path(), input->path() ) ).find( "Networks are equivalent" ) != std::string::npos;
+  }
+  else
+  {
+    equivalent = abc_cec( ntk, benchmark, path_type, file_type );
+  }
+
+  if ( equivalent )
+  {
+    cache.add_verified( structure, benchmark, path_type, file_type );
+  }
+  return equivalent;
+}
+
+} // namespace experiments
@@ -0,0 +1,163 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file memory.hpp
+  \brief Resident set size and allocation counting
+
+  RSS values are read from `/proc/self/status`.  The peak (`VmHWM`) can be
+  reset through `/proc/self/clear_refs`, which allows to attribute a peak to a
+  single optimization stage.
+
+  Allocation counting replaces the global `operator new` and is therefore
+  opt-in: define `EXPERIMENTS_COUNT_ALLOCATIONS` before including this header
+  in exactly one translation unit (every experiment is a single translation
+  unit).  It then counts all heap allocations, including network storage and
+  cut sets.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+namespace experiments
+{
+
+/*! \brief Memory usage of the process in KiB */
+struct memory_status
+{
+  /*! \brief Current resident set size (`VmRSS`) */
+  uint64_t rss{0u};
+
+  /*! \brief Peak resident set size since start or last reset (`VmHWM`) */
+  uint64_t peak_rss{0u};
+};
+
+inline memory_status read_memory_status()
+{
+  memory_status status;
+
+  std::ifstream in( "/proc/self/status", std::ifstream::in );
+  std::string line;
+  while ( std::getline( in, line ) )
+  {
+    if ( line.compare( 0u, 6u, "VmRSS:" ) == 0 )
+    {
+      status.rss = std::strtoull( line.c_str() + 6u, nullptr, 10 );
+    }
+    else if ( line.compare( 0u, 6u, "VmHWM:" ) == 0 )
+    {
+      status.peak_rss = std::strtoull( line.c_str() + 6u, nullptr, 10 );
+    }
+  }
+
+  return status;
+}
+
+/*! \brief Resets the peak RSS to the current RSS
+ *
+ * Returns false if the kernel does not support resetting the peak (Linux
+ * 4.0 and later do).
+ */
+inline bool reset_peak_rss()
+{
+  std::ofstream os( "/proc/self/clear_refs", std::ofstream::out );
+  if ( !os.good() )
+  {
+    return false;
+  }
+  os << "5";
+  os.flush();
+  return os.good();
+}
+
+/*! \brief Heap allocation counters (only updated with `EXPERIMENTS_COUNT_ALLOCATIONS`) */
+inline std::atomic<uint64_t> num_allocations{0u};
+inline std::atomic<uint64_t> num_allocated_bytes{0u};
+
+struct allocation_status
+{
+  uint64_t allocations{0u};
+  uint64_t bytes{0u};
+};
+
+inline allocation_status read_allocation_status()
+{
+  return {num_allocations.load( std::memory_order_relaxed ), num_allocated_bytes.load( std::memory_order_relaxed )};
+}
+
+inline constexpr bool allocation_counting_enabled()
+{
+#ifdef EXPERIMENTS_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace experiments
+
+#ifdef EXPERIMENTS_COUNT_ALLOCATIONS
+void* operator new( std::size_t size )
+{
+  experiments::num_allocations.fetch_add( 1u, std::memory_order_relaxed );
+  experiments::num_allocated_bytes.fetch_add( size, std::memory_order_relaxed );
+  if ( void* p = std::malloc( size == 0u ? 1u : size ) )
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size )
+{
+  return operator new( size );
+}
+
+void operator delete( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p, std::size_t ) noexcept
+{
+  std::free( p );
+}
+#endif
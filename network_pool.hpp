@@ -0,0 +1,206 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file network_pool.hpp
+  \brief Recycling of network storage between short-lived networks
+
+  The drivers create many short-lived networks of similar size: the result of
+  `node_resynthesis`, the copy made by every `cleanup_dangling`, and fresh
+  copies of a benchmark for each repeated run.  Each of them allocates a node
+  vector and a structural hash table that grow by reallocation and are freed
+  again shortly after.
+
+  A `network_pool` keeps the storage of released networks and hands it out
+  again with its contents cleared but its capacity retained, so that after
+  the first iteration nodes and hash buckets are neither reallocated nor
+  freed.  Networks obtained from `acquire` can additionally be given a size
+  hint (usually the size of the source network) to reserve their capacity
+  upfront.  Acquiring and releasing is thread-safe.  The pool only applies to networks without storage data (AIG,
+  MIG, XAG, XMG); the truth-table cache of k-LUT networks is initialized by
+  their constructor.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mockturtle/algorithms/cleanup.hpp>
+#include <mockturtle/networks/storage.hpp>
+
+namespace experiments
+{
+
+/*! \brief Reserves space for `num_nodes` nodes in the node vector and the structural hash table */
+template<class Ntk>
+void reserve_network( Ntk& ntk, uint64_t num_nodes )
+{
+  ntk._storage->nodes.reserve( num_nodes );
+  ntk._storage->hash.reserve( num_nodes );
+}
+
+/*! \brief Creates an empty network with space reserved for `num_nodes` nodes */
+template<class Ntk>
+Ntk make_network( uint64_t num_nodes )
+{
+  Ntk ntk;
+  reserve_network( ntk, num_nodes );
+  return ntk;
+}
+
+struct network_pool_stats
+{
+  /*! \brief Networks handed out by `acquire` */
+  uint64_t num_acquired{0u};
+
+  /*! \brief Networks that reused the storage of a released network */
+  uint64_t num_reused{0u};
+
+  /*! \brief Released networks whose storage was still shared or exceeded the pool size */
+  uint64_t num_dropped{0u};
+};
+
+/*! \brief Pool of network storages with retained capacity
+ *
+ * Example to rewrite a network repeatedly without reallocating its storage:
+ *
+   \verbatim embed:rst
+
+   .. code-block:: c++
+
+      experiments::network_pool<xmg_network> pool;
+      for ( ... )
+      {
+        cut_rewriting( xmg, resyn );
+        pool.replace( xmg, pool.cleanup_dangling( xmg ) );
+      }
+   \endverbatim
+ */
+template<class Ntk>
+class network_pool
+{
+public:
+  using storage = typename Ntk::storage;
+  using storage_type = typename storage::element_type;
+  using node_type = typename storage_type::node_type;
+
+  static_assert( std::is_same_v<std::decay_t<decltype( std::declval<storage_type>().data )>, mockturtle::empty_storage_data>,
+                 "network_pool only supports networks without storage data" );
+
+  /*! \brief Creates a pool that keeps at most `max_storages` released storages */
+  explicit network_pool( uint32_t max_storages = 4u )
+      : max_storages( max_storages )
+  {
+  }
+
+  /*! \brief Returns an empty network, reusing a released storage if possible */
+  Ntk acquire( uint64_t size_hint = 0u )
+  {
+    storage s;
+    {
+      std::lock_guard lock( mutex );
+      ++st.num_acquired;
+      if ( free_storages.empty() )
+      {
+        return make_network<Ntk>( size_hint );
+      }
+
+      ++st.num_reused;
+      s = std::move( free_storages.back() );
+      free_storages.pop_back();
+    }
+
+    /* the first node is the constant, as in the storage constructor */
+    s->nodes.resize( 1u );
+    s->nodes.front() = node_type{};
+    s->inputs.clear();
+    s->outputs.clear();
+    s->hash.clear();
+
+    Ntk ntk( s );
+    reserve_network( ntk, size_hint );
+    return ntk;
+  }
+
+  /*! \brief Takes the storage of `ntk` if no other network or view shares it */
+  void release( Ntk&& ntk )
+  {
+    storage s = std::move( ntk._storage );
+    std::lock_guard lock( mutex );
+    if ( s.use_count() == 1 && free_storages.size() < max_storages )
+    {
+      free_storages.push_back( std::move( s ) );
+    }
+    else
+    {
+      ++st.num_dropped;
+    }
+  }
+
+  /*! \brief Assigns `replacement` to `ntk` and releases the previous network */
+  void replace( Ntk& ntk, Ntk&& replacement )
+  {
+    release( std::exchange( ntk, std::move( replacement ) ) );
+  }
+
+  /*! \brief `mockturtle::cleanup_dangling` into a network of the pool */
+  template<class NtkSrc>
+  Ntk cleanup_dangling( NtkSrc const& ntk )
+  {
+    auto dest = acquire( ntk.size() );
+
+    std::vector<typename Ntk::signal> pis;
+    pis.reserve( ntk.num_pis() );
+    for ( auto i = 0u; i < ntk.num_pis(); ++i )
+    {
+      pis.push_back( dest.create_pi() );
+    }
+
+    for ( auto const& f : mockturtle::cleanup_dangling( ntk, dest, pis.begin(), pis.end() ) )
+    {
+      dest.create_po( f );
+    }
+
+    return dest;
+  }
+
+  network_pool_stats const& stats() const
+  {
+    return st;
+  }
+
+private:
+  uint32_t max_storages;
+  std::mutex mutex;
+  std::vector<storage> free_storages;
+  network_pool_stats st;
+};
+
+} // namespace experiments
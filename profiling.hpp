@@ -0,0 +1,550 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file profiling.hpp
+  \brief Per-phase wall time, CPU time, hardware counters and memory
+
+  Phases are opened with RAII markers (`auto const _ = prof.phase( "rewriting" );`)
+  and accumulate over all calls with the same name.  CPU time includes
+  terminated child processes, so time spent in ABC is attributed to the phase
+  that called it.  Hardware counters are read via `perf_event_open` and are
+  silently reported as zero if the kernel does not grant access (e.g. with a
+  restrictive `perf_event_paranoid` setting).
+
+  Every phase also records the peak RSS reached while it was open and how far
+  above the RSS at its start this peak was, as well as the number of heap
+  allocations if allocation counting is enabled (see memory.hpp).
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include "experiments.hpp"
+#include "memory.hpp"
+
+namespace experiments
+{
+
+/*! \brief Hardware events recorded for every phase */
+enum class hw_event : uint32_t
+{
+  cycles = 0,
+  instructions,
+  llc_misses,
+  branch_misses
+};
+
+static constexpr uint32_t num_hw_events = 4u;
+
+using hw_event_values = std::array<uint64_t, num_hw_events>;
+
+/*! \brief Hardware counters of the calling thread and its future children
+ *
+ * The counters are opened with `inherit` set, such that work done in child
+ * processes (e.g. ABC started via `popen`) is folded into the counters once
+ * the child has been waited for.
+ */
+class perf_counters
+{
+public:
+  perf_counters()
+  {
+    fds_.fill( -1 );
+#if defined( __linux__ )
+    static constexpr std::array<std::pair<uint32_t, uint64_t>, num_hw_events> events = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}}};
+
+    for ( auto i = 0u; i < num_hw_events; ++i )
+    {
+      perf_event_attr attr{};
+      attr.size = sizeof( perf_event_attr );
+      attr.type = events[i].first;
+      attr.config = events[i].second;
+      attr.disabled = 0;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      fds_[i] = static_cast<int>( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) );
+    }
+#endif
+  }
+
+  ~perf_counters()
+  {
+    for ( auto const fd : fds_ )
+    {
+      if ( fd >= 0 )
+      {
+        close( fd );
+      }
+    }
+  }
+
+  perf_counters( perf_counters const& ) = delete;
+  perf_counters& operator=( perf_counters const& ) = delete;
+
+  /*! \brief Returns true if at least one counter could be opened */
+  bool available() const
+  {
+    return std::any_of( fds_.begin(), fds_.end(), []( auto fd ) { return fd >= 0; } );
+  }
+
+  /*! \brief Reads all counters (scaled if the kernel had to multiplex them) */
+  hw_event_values read_values() const
+  {
+    hw_event_values values{};
+    for ( auto i = 0u; i < num_hw_events; ++i )
+    {
+      if ( fds_[i] < 0 )
+      {
+        continue;
+      }
+
+      /* value, time enabled, time running */
+      std::array<uint64_t, 3> buffer{};
+      if ( ::read( fds_[i], buffer.data(), sizeof( buffer ) ) != sizeof( buffer ) || buffer[2] == 0u )
+      {
+        continue;
+      }
+      values[i] = buffer[1] == buffer[2] ? buffer[0] : static_cast<uint64_t>( double( buffer[0] ) * buffer[1] / buffer[2] );
+    }
+    return values;
+  }
+
+private:
+  std::array<int, num_hw_events> fds_;
+};
+
+/*! \brief Accumulated measurements of one named phase */
+struct phase_record
+{
+  std::string name;
+  uint32_t calls{0u};
+
+  /*! \brief Wall-clock time in seconds */
+  double wall{0.0};
+
+  /*! \brief User and system time of this process and waited-for children in seconds */
+  double cpu{0.0};
+
+  hw_event_values events{};
+
+  /*! \brief Largest peak RSS over all calls in KiB */
+  uint64_t peak_rss{0u};
+
+  /*! \brief Largest growth of the peak RSS above the RSS at the start of a call in KiB */
+  uint64_t peak_rss_delta{0u};
+
+  /*! \brief Heap allocations (requires `EXPERIMENTS_COUNT_ALLOCATIONS`) */
+  uint64_t allocations{0u};
+  uint64_t allocated_bytes{0u};
+
+  double ipc() const
+  {
+    auto const cycles = events[static_cast<uint32_t>( hw_event::cycles )];
+    return cycles == 0u ? 0.0 : double( events[static_cast<uint32_t>( hw_event::instructions )] ) / cycles;
+  }
+};
+
+class phase_profiler
+{
+private:
+  struct snapshot
+  {
+    std::chrono::steady_clock::time_point wall;
+    double cpu;
+    hw_event_values events;
+    uint64_t rss;
+    allocation_status allocs;
+  };
+
+public:
+  /*! \brief RAII marker that attributes its lifetime to one phase */
+  class scoped_phase
+  {
+  public:
+    scoped_phase( phase_profiler& profiler, uint32_t index )
+        : profiler_( profiler ), index_( index ), start_( profiler.take_snapshot() )
+    {
+    }
+
+    ~scoped_phase()
+    {
+      profiler_.finish( index_, start_ );
+    }
+
+    scoped_phase( scoped_phase const& ) = delete;
+    scoped_phase& operator=( scoped_phase const& ) = delete;
+
+  private:
+    phase_profiler& profiler_;
+    uint32_t index_;
+    snapshot start_;
+  };
+
+public:
+  /*! \brief Opens a phase that lasts until the returned marker is destroyed
+   *
+   * Phases may be nested; every phase reports its inclusive measurements.
+   */
+  scoped_phase phase( std::string const& name )
+  {
+    return scoped_phase( *this, find_or_create( name ) );
+  }
+
+  /*! \brief Calls `fn` inside the phase `name` and returns its result */
+  template<typename Fn>
+  decltype( auto ) measure( std::string const& name, Fn&& fn )
+  {
+    auto const _ = phase( name );
+    return fn();
+  }
+
+  bool counters_available() const
+  {
+    return counters_.available();
+  }
+
+  std::vector<phase_record> const& phases() const
+  {
+    return phases_;
+  }
+
+  void reset()
+  {
+    phases_.clear();
+  }
+
+  /*! \brief Keeps the process-wide peak RSS when phases start (for concurrent phases) */
+  void disable_peak_reset()
+  {
+    can_reset_peak_ = false;
+  }
+
+  /*! \brief Adds the measurements of `other` phase by phase */
+  void merge( phase_profiler const& other )
+  {
+    for ( auto const& q : other.phases_ )
+    {
+      auto& p = phases_[find_or_create( q.name )];
+      p.calls += q.calls;
+      p.wall += q.wall;
+      p.cpu += q.cpu;
+      for ( auto i = 0u; i < num_hw_events; ++i )
+      {
+        p.events[i] += q.events[i];
+      }
+      p.peak_rss = std::max( p.peak_rss, q.peak_rss );
+      p.peak_rss_delta = std::max( p.peak_rss_delta, q.peak_rss_delta );
+      p.allocations += q.allocations;
+      p.allocated_bytes += q.allocated_bytes;
+    }
+  }
+
+  /*! \brief Largest peak RSS of all phases in MiB */
+  double peak_rss_mb() const
+  {
+    uint64_t peak = 0u;
+    for ( auto const& p : phases_ )
+    {
+      peak = std::max( peak, p.peak_rss );
+    }
+    return peak / 1024.0;
+  }
+
+  nlohmann::json to_json() const
+  {
+    nlohmann::json result;
+    for ( auto const& p : phases_ )
+    {
+      result.push_back( {{"phase", p.name},
+                         {"calls", p.calls},
+                         {"wall", p.wall},
+                         {"cpu", p.cpu},
+                         {"cycles", p.events[static_cast<uint32_t>( hw_event::cycles )]},
+                         {"instructions", p.events[static_cast<uint32_t>( hw_event::instructions )]},
+                         {"llc_misses", p.events[static_cast<uint32_t>( hw_event::llc_misses )]},
+                         {"branch_misses", p.events[static_cast<uint32_t>( hw_event::branch_misses )]},
+                         {"peak_rss", p.peak_rss},
+                         {"peak_rss_delta", p.peak_rss_delta},
+                         {"allocations", p.allocations},
+                         {"allocated_bytes", p.allocated_bytes}} );
+    }
+    return result;
+  }
+
+  void print( std::ostream& os = std::cout ) const
+  {
+    nlohmann::json rows;
+    for ( auto const& p : phases_ )
+    {
+      rows.push_back( {{"phase", p.name},
+                       {"calls", p.calls},
+                       {"wall [s]", p.wall},
+                       {"cpu [s]", p.cpu},
+                       {"Gcycles", p.events[static_cast<uint32_t>( hw_event::cycles )] * 1e-9},
+                       {"IPC", p.ipc()},
+                       {"LLC miss [M]", p.events[static_cast<uint32_t>( hw_event::llc_misses )] * 1e-6},
+                       {"br miss [M]", p.events[static_cast<uint32_t>( hw_event::branch_misses )] * 1e-6},
+                       {"peak RSS [MB]", p.peak_rss / 1024.0},
+                       {"+RSS [MB]", p.peak_rss_delta / 1024.0},
+                       {"allocs [k]", p.allocations * 1e-3}} );
+    }
+    json_table( rows, {"phase", "calls", "wall [s]", "cpu [s]", "Gcycles", "IPC", "LLC miss [M]", "br miss [M]", "peak RSS [MB]", "+RSS [MB]", "allocs [k]"} ).print( os );
+  }
+
+private:
+  uint32_t find_or_create( std::string const& name )
+  {
+    for ( auto i = 0u; i < phases_.size(); ++i )
+    {
+      if ( phases_[i].name == name )
+      {
+        return i;
+      }
+    }
+    phases_.emplace_back();
+    phases_.back().name = name;
+    return static_cast<uint32_t>( phases_.size() - 1u );
+  }
+
+  /* The kernel keeps a single peak RSS value, which is reset whenever a phase
+   * starts.  Peaks that have been observed before a reset are kept on a stack
+   * for all enclosing phases that are still open. */
+  snapshot take_snapshot()
+  {
+    auto const mem = read_memory_status();
+    for ( auto& peak : open_peaks_ )
+    {
+      peak = std::max( peak, mem.peak_rss );
+    }
+    can_reset_peak_ = can_reset_peak_ && reset_peak_rss();
+    open_peaks_.push_back( can_reset_peak_ ? mem.rss : mem.peak_rss );
+
+    return {std::chrono::steady_clock::now(), cpu_seconds(), counters_.read_values(), mem.rss, read_allocation_status()};
+  }
+
+  void finish( uint32_t index, snapshot const& start )
+  {
+    auto const wall = std::chrono::steady_clock::now();
+    auto const cpu = cpu_seconds();
+    auto const events = counters_.read_values();
+    auto const allocs = read_allocation_status();
+    auto const mem = read_memory_status();
+
+    auto const peak = std::max( open_peaks_.back(), mem.peak_rss );
+    open_peaks_.pop_back();
+    for ( auto& p : open_peaks_ )
+    {
+      p = std::max( p, peak );
+    }
+
+    auto& p = phases_[index];
+    ++p.calls;
+    p.wall += std::chrono::duration<double>( wall - start.wall ).count();
+    p.cpu += cpu - start.cpu;
+    for ( auto i = 0u; i < num_hw_events; ++i )
+    {
+      p.events[i] += events[i] - start.events[i];
+    }
+    p.peak_rss = std::max( p.peak_rss, peak );
+    p.peak_rss_delta = std::max( p.peak_rss_delta, peak > start.rss ? peak - start.rss : 0u );
+    p.allocations += allocs.allocations - start.allocs.allocations;
+    p.allocated_bytes += allocs.bytes - start.allocs.bytes;
+  }
+
+  static double cpu_seconds()
+  {
+    auto const to_sec = []( timeval const& tv ) { return tv.tv_sec + tv.tv_usec * 1e-6; };
+
+    rusage self{}, children{};
+    getrusage( RUSAGE_SELF, &self );
+    getrusage( RUSAGE_CHILDREN, &children );
+    return to_sec( self.ru_utime ) + to_sec( self.ru_stime ) + to_sec( children.ru_utime ) + to_sec( children.ru_stime );
+  }
+
+private:
+  perf_counters counters_;
+  std::vector<phase_record> phases_;
+  std::vector<uint64_t> open_peaks_;
+  bool can_reset_peak_{true};
+};
+
+/*! \brief Profiler for phases that run concurrently on several threads
+ *
+ * Every call of `measure` uses a profiler of its own, such that hardware
+ * counters belong to the calling thread, and merges it afterwards.  CPU
+ * times and RSS peaks are process-wide and include the other threads.
+ *
+ * Resetting the kernel's peak RSS would clear it under the phases of the
+ * other threads, so a phase only resets it if no other phase of any shared
+ * profiler is running; the check and the reset happen under one lock, such
+ * that no phase starts in between.  Phases that overlap with others report
+ * the process-wide peak since the last reset, an upper bound of their own.
+ * If phases overlap most of the time, `disable_peak_reset` keeps the
+ * process-wide peak (VmHWM) of the whole run instead.
+ */
+class shared_phase_profiler
+{
+public:
+  template<typename Fn>
+  decltype( auto ) measure( std::string const& name, Fn&& fn )
+  {
+    running_phase const running;
+    phase_profiler local;
+    local.disable_peak_reset();
+    merge_on_exit const _{*this, local};
+    return local.measure( name, std::forward<Fn>( fn ) );
+  }
+
+  void reset()
+  {
+    std::lock_guard lock( mutex_ );
+    profiler_.reset();
+  }
+
+  /*! \brief Merged measurements (only to be read while no phase is running) */
+  phase_profiler const& profiler() const
+  {
+    return profiler_;
+  }
+
+  double peak_rss_mb() const
+  {
+    return profiler_.peak_rss_mb();
+  }
+
+  /*! \brief No shared phase resets the process-wide peak RSS anymore */
+  static void disable_peak_reset()
+  {
+    std::lock_guard lock( start_mutex() );
+    peak_reset_enabled() = false;
+  }
+
+private:
+  /* counts the phases running in all shared profilers; the first one resets the peak RSS */
+  struct running_phase
+  {
+    running_phase()
+    {
+      std::lock_guard lock( start_mutex() );
+      if ( num_running().fetch_add( 1u ) == 0u && peak_reset_enabled() )
+      {
+        reset_peak_rss();
+      }
+    }
+
+    ~running_phase()
+    {
+      num_running().fetch_sub( 1u );
+    }
+  };
+
+  static std::mutex& start_mutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static bool& peak_reset_enabled()
+  {
+    static bool enabled{true};
+    return enabled;
+  }
+
+  static std::atomic<uint32_t>& num_running()
+  {
+    static std::atomic<uint32_t> count{0u};
+    return count;
+  }
+
+  struct merge_on_exit
+  {
+    shared_phase_profiler& shared;
+    phase_profiler const& local;
+
+    ~merge_on_exit()
+    {
+      std::lock_guard lock( shared.mutex_ );
+      shared.profiler_.merge( local );
+    }
+  };
+
+private:
+  std::mutex mutex_;
+  phase_profiler profiler_;
+};
+
+/*! \brief Experiment table with one row per (benchmark, phase) */
+using phase_experiment = experiment<std::string, std::string, uint32_t, double, double, double, double, double, double, double, double, double>;
+
+inline phase_experiment make_phase_experiment( std::string_view name )
+{
+  return phase_experiment( name, "benchmark", "phase", "calls", "wall [s]", "cpu [s]", "Gcycles", "IPC", "LLC miss [M]", "br miss [M]", "peak RSS [MB]", "+RSS [MB]", "allocs [k]" );
+}
+
+/*! \brief Appends the phases of `profiler` as rows for `benchmark` to a phase experiment */
+inline void add_phases( phase_experiment& exp, std::string const& benchmark, phase_profiler const& profiler )
+{
+  for ( auto const& p : profiler.phases() )
+  {
+    exp( benchmark, p.name, p.calls, p.wall, p.cpu,
+         p.events[static_cast<uint32_t>( hw_event::cycles )] * 1e-9,
+         p.ipc(),
+         p.events[static_cast<uint32_t>( hw_event::llc_misses )] * 1e-6,
+         p.events[static_cast<uint32_t>( hw_event::branch_misses )] * 1e-6,
+         p.peak_rss / 1024.0,
+         p.peak_rss_delta / 1024.0,
+         p.allocations * 1e-3 );
+  }
+}
+
+} // namespace experiments
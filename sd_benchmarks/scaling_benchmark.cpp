@@ -0,0 +1,221 @@
+/* Scaling suite on synthetic XMGs from `create_xmg`
+ *
+ * Generates circuits from `--min-gates` to `--max-gates` gates (default 1K to
+ * 10M, `--steps` sizes per decade) with `--pis` primary inputs, `--width`
+ * nodes per level, and `--sd-ratio` self-dual nodes out of ten, and records
+ * wall time and peak memory of every pass at every size.  A power law
+ * `time = c * gates^k` is fitted per pass, so that the exponent `k` tells
+ * which pass breaks first as the designs grow.
+ */
+
+#include <utils.hpp>
+#include <profiling.hpp>
+#include <streaming_cut_enumeration.hpp>
+#include <xmg_simulation.hpp>
+
+#include <mockturtle/networks/aig.hpp>
+
+#include <cmath>
+#include <map>
+
+struct scaling_params
+{
+  uint64_t min_gates{1000u};
+  uint64_t max_gates{10000000u};
+  uint32_t steps_per_decade{1u};
+  uint32_t num_pis{128u};
+  uint32_t width{1000u};
+  uint32_t sd_ratio{5u};
+  uint32_t seed{5u};
+};
+
+/*! \brief Least-squares fit of `y = c * x^k` on a log-log scale */
+struct power_law
+{
+  double exponent{0.0};
+  double coefficient{0.0};
+
+  /*! \brief Coefficient of determination of the fit in log space */
+  double r2{0.0};
+};
+
+power_law fit_power_law( std::vector<std::pair<double, double>> const& points )
+{
+  power_law fit;
+  if ( points.size() < 2u )
+  {
+    return fit;
+  }
+
+  double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+  for ( auto const& [x, y] : points )
+  {
+    auto const lx = std::log( x ), ly = std::log( y );
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+    syy += ly * ly;
+  }
+  auto const n = double( points.size() );
+  auto const vxx = sxx - sx * sx / n, vxy = sxy - sx * sy / n, vyy = syy - sy * sy / n;
+  if ( vxx <= 0.0 )
+  {
+    return fit;
+  }
+
+  fit.exponent = vxy / vxx;
+  fit.coefficient = std::exp( ( sy - fit.exponent * sx ) / n );
+  fit.r2 = vyy <= 0.0 ? 1.0 : ( vxy * vxy ) / ( vxx * vyy );
+  return fit;
+}
+
+/*! \brief Compares the outputs of two XMGs with the same inputs under random simulation */
+bool equal_signatures( xmg_network const& a, xmg_network const& b, uint32_t num_words = 4u )
+{
+  if ( a.num_pis() != b.num_pis() || a.num_pos() != b.num_pos() )
+  {
+    return false;
+  }
+
+  xmg_simulator sim_a( a, num_words ), sim_b( b, num_words );
+  sim_a.simulate();
+  sim_b.simulate();
+
+  std::vector<std::vector<uint64_t>> outputs;
+  a.foreach_po( [&]( auto const& f ) {
+    outputs.push_back( sim_a.value( f ) );
+  } );
+  bool equal = true;
+  b.foreach_po( [&]( auto const& f, auto i ) {
+    equal = equal && sim_b.value( f ) == outputs[i];
+  } );
+  return equal;
+}
+
+int main( int argc, char** argv )
+{
+  scaling_params ps;
+  for ( auto i = 1; i + 1 < argc; i += 2 )
+  {
+    std::string const arg = argv[i];
+    auto const value = std::stoull( argv[i + 1] );
+    if ( arg == "--min-gates" )
+      ps.min_gates = std::max<uint64_t>( value, 1u );
+    else if ( arg == "--max-gates" )
+      ps.max_gates = value;
+    else if ( arg == "--steps" )
+      ps.steps_per_decade = std::max<uint32_t>( value, 1u );
+    else if ( arg == "--pis" )
+      ps.num_pis = value;
+    else if ( arg == "--width" )
+      ps.width = std::max<uint32_t>( value, 1u );
+    else if ( arg == "--sd-ratio" )
+      ps.sd_ratio = value;
+    else if ( arg == "--seed" )
+      ps.seed = value;
+    else
+      fmt::print( "[w] ignoring argument {}\n", arg );
+  }
+
+  experiments::experiment<std::string, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, bool>
+    exp( "scaling", "benchmark", "levels", "width", "gates", "after rw", "after rs", "equivalent" );
+  auto exp_phases = experiments::make_phase_experiment( "scaling_phases" );
+
+  /* (gates, wall time) and (gates, growth of the peak RSS) per phase */
+  std::map<std::string, std::vector<std::pair<double, double>>> times, memory;
+
+  for ( auto step = 0u;; ++step )
+  {
+    auto const target = static_cast<uint64_t>( std::llround( ps.min_gates * std::pow( 10.0, double( step ) / ps.steps_per_decade ) ) );
+    if ( target > ps.max_gates )
+      break;
+
+    /* levels times width nodes are created, the first level holds the PIs */
+    auto const width = static_cast<uint32_t>( std::min<uint64_t>( ps.width, target ) );
+    auto const levels = static_cast<uint32_t>( std::max<uint64_t>( target / width, 1u ) + 1u );
+    auto const benchmark = fmt::format( "scaling_{}_{}_{}_{}", ps.num_pis, levels, width, ps.sd_ratio );
+    fmt::print( "[i] processing {}\n", benchmark );
+
+    experiments::phase_profiler prof;
+
+    srand( ps.seed );
+    xmg_network golden;
+    prof.measure( "generation", [&]() {
+      create_xmg( golden, ps.num_pis, levels, width, ps.sd_ratio );
+      golden = cleanup_dangling( golden );
+    } );
+
+    /* parsing and resynthesis start from the AIG read from the written Verilog */
+    aig_network aig;
+    {
+      experiments::temporary_file const verilog( "v" );
+      prof.measure( "writing", [&]() { write_verilog( golden, verilog.path() ); } );
+      if ( !prof.measure( "parsing", [&]() { return lorina::read_verilog( verilog.path(), verilog_reader( aig ) ) == lorina::return_code::success; } ) )
+      {
+        fmt::print( "[e] parsing {} failed\n", benchmark );
+        continue;
+      }
+    }
+
+    xmg3_npn_resynthesis<xmg_network> resyn;
+    xmg_network xmg = prof.measure( "resynthesis", [&]() {
+      return node_resynthesis<xmg_network>( aig, resyn );
+    } );
+    aig = aig_network();
+
+    uint64_t num_cuts = 0u;
+    prof.measure( "cut enumeration", [&]() {
+      streaming_cut_enumeration( xmg, [&]( auto const&, auto const& cuts ) { num_cuts += cuts.size(); } );
+    } );
+
+    cut_rewriting_params rewrite_ps;
+    rewrite_ps.cut_enumeration_ps.cut_size = 4u;
+    prof.measure( "rewriting", [&]() { cut_rewriting( xmg, resyn, rewrite_ps ); } );
+    prof.measure( "cleanup", [&]() { xmg = cleanup_dangling( xmg ); } );
+    auto const size_after_rw = xmg.num_gates();
+
+    resubstitution_params resub_ps;
+    resub_ps.max_pis = 8u;
+    resub_ps.max_inserts = 1u;
+    resub_ps.use_dont_cares = true;
+    resub_ps.window_size = 12u;
+    prof.measure( "resubstitution", [&]() { xmg_resubstitution( xmg, resub_ps ); } );
+    prof.measure( "cleanup", [&]() { xmg = cleanup_dangling( xmg ); } );
+
+    /* ABC's CEC does not reach 10M gates, outputs are compared under simulation */
+    auto const equivalent = prof.measure( "verification", [&]() { return equal_signatures( golden, xmg ); } );
+
+    exp( benchmark, levels, width, golden.num_gates(), size_after_rw, xmg.num_gates(), equivalent );
+    experiments::add_phases( exp_phases, benchmark, prof );
+
+    for ( auto const& p : prof.phases() )
+    {
+      /* runtimes below a millisecond are dominated by noise */
+      if ( p.wall >= 1e-3 )
+        times[p.name].emplace_back( golden.num_gates(), p.wall );
+      if ( p.peak_rss_delta > 0u )
+        memory[p.name].emplace_back( golden.num_gates(), p.peak_rss_delta / 1024.0 );
+    }
+    fmt::print( "[i] {} cuts enumerated\n", num_cuts );
+  }
+
+  exp.save();
+  exp.table();
+  exp_phases.save();
+  exp_phases.table();
+
+  experiments::experiment<std::string, double, double, double, double, double, double>
+    exp_fit( "scaling_exponents", "phase", "time exponent", "time R^2", "time at 10M [s]", "memory exponent", "memory R^2", "memory at 10M [MB]" );
+  for ( auto const& [phase, points] : times )
+  {
+    auto const time_fit = fit_power_law( points );
+    auto const memory_fit = fit_power_law( memory[phase] );
+    exp_fit( phase, time_fit.exponent, time_fit.r2, time_fit.coefficient * std::pow( 1e7, time_fit.exponent ),
+             memory_fit.exponent, memory_fit.r2, memory_fit.coefficient * std::pow( 1e7, memory_fit.exponent ) );
+  }
+  exp_fit.save();
+  exp_fit.table();
+
+  return 0;
+}
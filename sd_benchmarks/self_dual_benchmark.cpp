@@ -4,9 +4,16 @@ int main( int argc, char** argv )
 {
     //srand(time(NULL));
     srand(5);
-    if (argc != 4)
+    /* `--early-stop R` and `--predict-stop` set the early-stopping policy of the rw/rs loop (see convergence.hpp) */
+    std::vector<char*> args( argv, argv + argc );
+    auto const es_ps = parse_early_stopping_params( args );
+    argc = static_cast<int>( args.size() );
+    argv = args.data();
+    /* an optional fourth argument `--resume` continues an interrupted run from its checkpoints */
+    bool const resume = argc == 5 && std::string( argv[4] ) == "--resume";
+    if (argc != 4 && !resume)
     {
-        std::cout << "[e] Usage executable num pis num_levels nodes per level and sd ratio" << std::endl;
+        std::cout << "[e] Usage executable num pis num_levels nodes per level and sd ratio [--resume] [--early-stop R] [--predict-stop]" << std::endl;
         exit(0);
     }
     std::cout << "num_pis "           << argv[1] << std::endl;
@@ -17,7 +24,6 @@ int main( int argc, char** argv )
     uint32_t num_levels             = std::stoi( std::string( argv[2] ) );
     uint32_t max_nodes_per_levels   = std::stoi( std::string( argv[3] ) );
     uint32_t sd_ratio               = 0; 
-    xmg_cost_params ps1, ps2;
 
 
     experiments::experiment<std::string, std::string, std::string>
@@ -26,68 +32,116 @@ int main( int argc, char** argv )
     experiments::experiment<std::string, uint32_t, double, double, double, double, double, uint32_t, uint32_t>
         exp( "RFET_area", "benchmark", "init_size", "init_area", "c2rs_area", "dc2_area", "dch_area", "final_area","final_size", "num_pos" );
 
+    auto exp_trace = make_trace_experiment( "RFET_area_trace" );
+
+    experiments::checkpoint cp( "RFET_area", resume );
+
+    /* the trace estimates areas with the mapping library */
+    std::vector<genlib_gate> trace_gates;
+    xmg_genlib_cost const trace_cost = read_genlib( genlib_path, trace_gates ) ? xmg_genlib_cost( trace_gates ) : xmg_genlib_cost();
+
     for (int i = 0; i < 10; i++)
     {
         sd_ratio++;
+        /* the network is generated also when resuming to keep the sequence of rand() */
         xmg_network xmg;
         create_xmg( xmg, num_pis, num_levels, max_nodes_per_levels, sd_ratio );
         xmg = cleanup_dangling( xmg );
 
+        std::string ofname = "benchmarks_" + std::string( argv[1] ) + "_" + std::string( argv[2] ) + "_" + std::string( argv[3] ) + "_" + std::to_string( sd_ratio ) + ".v";
+        if ( cp.restore_rows( ofname, exp, "area" ) )
+        {
+            cp.restore_rows( ofname, exp2, "sd_ratio" );
+            cp.restore_rows( ofname, exp_trace, "trace" );
+            std::cout << "[i] restored " << ofname << " from checkpoint" << std::endl;
+            continue;
+        }
 
        std::cout << "Before Optimizations" <<  std::endl;
-        ps1.reset();
-        num_gate_profile( xmg, ps1 );
+        auto const ps1 = profile_xmg( xmg );
         ps1.report();
-        auto size_before = xmg.num_gates();
-        double sd_rat = ( double( ps1.actual_maj + ps1.actual_xor3 + ps1.actual_xor2 )/  size_before ) * 100;
-        std::string sd_before = fmt::format( "{}/{} = {}", ( ps1.actual_maj + ps1.actual_xor3 + ps1.actual_xor2),  size_before, sd_rat);
+        auto size_before = ps1.num_gates;
+        double sd_rat = ps1.self_dual_ratio_with_xor2() * 100;
+        std::string sd_before = fmt::format( "{}/{} = {}", ( ps1.actual_maj + ps1.actual_xor3 + ps1.xor2 ),  size_before, sd_rat);
 
-        auto const init_area  = abc_map( xmg, genlib_path );
-        auto const c2rs_area  = abc_map_compress2rs( xmg, genlib_path); 
-        auto const dch_area   = abc_map_dch( xmg, genlib_path );
-        auto const dc2_area   = abc_map_dc2( xmg, genlib_path );
+        nlohmann::json mapped;
+        if ( !cp.load_data( ofname, "mapped", mapped ) )
+        {
+            mapped = {{"init_area", abc_map( xmg, genlib_path )},
+                      {"c2rs_area", abc_map_compress2rs( xmg, genlib_path )},
+                      {"dch_area", abc_map_dch( xmg, genlib_path )},
+                      {"dc2_area", abc_map_dc2( xmg, genlib_path )}};
+            cp.save_data( ofname, "mapped", mapped );
+        }
+        auto const init_area  = mapped["init_area"].get<double>();
+        auto const c2rs_area  = mapped["c2rs_area"].get<double>();
+        auto const dch_area   = mapped["dch_area"].get<double>();
+        auto const dc2_area   = mapped["dc2_area"].get<double>();
 
         auto const init_size = xmg.num_gates();
 
         uint32_t num_iters = 0;
         uint32_t size_per_iteration = 0;
         float total_opt_time = 0; 
-        float total_imp = 0;
+        convergence_trace trace( &trace_cost );
 
-        do 
+        /* the optimized network is checkpointed before the final mapping */
+        nlohmann::json optimized;
+        xmg_network xmg_optimized;
+        if ( cp.load_stage( ofname, "optimized", xmg_optimized, optimized ) )
         {
-            num_iters++;
-
-            auto rw_params = call_rw( xmg );
-            auto rs_params = call_rs( xmg );
-
-            total_opt_time = total_opt_time + rs_params.opt_time + rw_params.opt_time;
-            size_per_iteration = rs_params.size; 
-
-            if (size_per_iteration == 0u)
-                total_imp = 0;
-            else
+            xmg = xmg_optimized;
+            num_iters = optimized["num_iters"].get<uint32_t>();
+            total_opt_time = optimized["opt_time"].get<float>();
+            if ( optimized.contains( "trace" ) )
             {
-                int diff = size_per_iteration - xmg.num_gates();
-                total_imp = 100 * (double(std::abs(diff))/size_per_iteration);
+                trace = convergence_trace::from_json( optimized["trace"] );
             }
-            std::cout << "Iterations # " << num_iters <<  std::endl;
-
-        } while ( total_imp > 0.5 );
+        }
+        else
+        {
+            early_stopping stopping( es_ps );
+            do 
+            {
+                num_iters++;
+                size_per_iteration = xmg.num_gates();
+
+                if ( stopping.run( "rewriting" ) )
+                {
+                    auto const size_before_rw = xmg.num_gates();
+                    auto rw_params = call_rw( xmg );
+                    total_opt_time = total_opt_time + rw_params.opt_time;
+                    stopping.pass_done( "rewriting", size_before_rw, rw_params.size, rw_params.opt_time );
+                    trace.add( num_iters, "rewriting", xmg, rw_params.opt_time );
+                }
+                if ( stopping.run( "resubstitution" ) )
+                {
+                    auto const size_before_rs = xmg.num_gates();
+                    auto rs_params = call_rs( xmg );
+                    total_opt_time = total_opt_time + rs_params.opt_time;
+                    stopping.pass_done( "resubstitution", size_before_rs, rs_params.size, rs_params.opt_time );
+                    trace.add( num_iters, "resubstitution", xmg, rs_params.opt_time );
+                }
+                std::cout << "Iterations # " << num_iters <<  std::endl;
+
+            } while ( stopping.next_iteration( size_per_iteration, xmg.num_gates() ) );
+            cp.save_stage( ofname, "optimized", xmg, {{"num_iters", num_iters}, {"opt_time", total_opt_time}, {"trace", trace.to_json()}} );
+        }
+        trace.report();
+        auto const first_trace_row = exp_trace.num_rows();
+        add_trace( exp_trace, ofname, trace );
 
         profile(xmg);
         float area_after = abc_map( xmg, genlib_path );
 
-        std::string ofname = "benchmarks_" + std::string( argv[1] ) + "_" + std::string( argv[2] ) + "_" + std::string( argv[3] ) + "_" + std::to_string( sd_ratio ) + ".v";
         mockturtle::write_verilog( xmg, ofname);
         std::cout << "After Optimizations" <<  std::endl;
 
-        ps2.reset();
-        num_gate_profile( xmg, ps2);
+        auto const ps2 = profile_xmg( xmg );
         ps2.report();
-        auto size_after = xmg.num_gates();
-        sd_rat = ( double( ps2.actual_maj + ps2.actual_xor3 + ps2.actual_xor2 )/  size_after ) * 100;
-        std::string sd_after = fmt::format( "{}/{} = {}", ( ps2.actual_maj + ps2.actual_xor3 + ps2.actual_xor2 ),  size_after, sd_rat );
+        auto size_after = ps2.num_gates;
+        sd_rat = ps2.self_dual_ratio_with_xor2() * 100;
+        std::string sd_after = fmt::format( "{}/{} = {}", ( ps2.actual_maj + ps2.actual_xor3 + ps2.xor2 ),  size_after, sd_rat );
 
 
         std::cout << "init area "  << init_area     << std::endl;
@@ -98,15 +152,21 @@ int main( int argc, char** argv )
         std::cout << "num_pos "    << xmg.num_pos() << std::endl;
         exp ( ofname, init_size, init_area, c2rs_area, dc2_area, dch_area, area_after, xmg.num_gates(), xmg.num_pos() );
         exp2 (ofname, sd_before, sd_after);
+        cp.save_rows( ofname, exp2, exp2.num_rows() - 1u, "sd_ratio" );
+        cp.save_rows( ofname, exp_trace, first_trace_row, "trace" );
+        cp.save_rows( ofname, exp, exp.num_rows() - 1u, "area" );
         exp.save();
         exp.table();
         exp2.save();
         exp2.table();
+        exp_trace.save();
 
     }
     exp.save();
     exp.table();
     exp2.save();
     exp2.table();
+    exp_trace.save();
+    exp_trace.table();
     return 0;
 }
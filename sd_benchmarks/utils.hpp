@@ -21,7 +21,11 @@
 #include <mockturtle/views/depth_view.hpp>
 
 
+#include <checkpoint.hpp>
+#include <convergence.hpp>
 #include <experiments.hpp>
+#include <network_pool.hpp>
+#include <xmg_profile.hpp>
    
 using namespace mockturtle; 
 using namespace experiments;
@@ -42,20 +46,16 @@ float area_from_abc ( const xmg_network& xmg)
 
 void profile( const xmg_network& xmg)
 {
-    xmg_cost_params xmg_ps;
-    xmg_ps.reset();
-    num_gate_profile( xmg, xmg_ps );
-    xmg_ps.report();
-    std::cout << "xmg size " << xmg.num_gates() << std::endl;
+    profile_xmg( xmg ).report();
 }
 
-mockturtle::xmg_network::signal create_xmg_sd_node ( xmg_network& xmg, std::vector<std::pair<mockturtle::xmg_network::signal, bool>> sl, const uint32_t& rand_id, const uint32_t& i1, const uint32_t& i2, const uint32_t& i3)
+mockturtle::xmg_network::signal create_xmg_sd_node ( xmg_network& xmg, std::vector<std::pair<mockturtle::xmg_network::signal, bool>> const& sl, const uint32_t& rand_id, const uint32_t& i1, const uint32_t& i2, const uint32_t& i3)
 {
     //std::cout << "xmg create self-dual function " << std::endl;
     return (rand_id%2) ? xmg.create_maj(sl[i1].first, sl[i2].first, xmg.create_not(sl[i3].first)) : xmg.create_xor3(xmg.create_not(sl[i1].first), sl[i2].first, sl[i3].first);
 }
 
-mockturtle::xmg_network::signal create_xmg_node ( xmg_network& xmg, std::vector<std::pair<mockturtle::xmg_network::signal, bool>> sl, const uint32_t& rand_id, const uint32_t& i1, const uint32_t& i2, const uint32_t& i3 )
+mockturtle::xmg_network::signal create_xmg_node ( xmg_network& xmg, std::vector<std::pair<mockturtle::xmg_network::signal, bool>> const& sl, const uint32_t& rand_id, const uint32_t& i1, const uint32_t& i2, const uint32_t& i3 )
 {
     //std::cout << "xmg create and " << std::endl;
     if (rand_id%5 == 0)
@@ -80,6 +80,8 @@ void create_xmg( xmg_network& xmg, const uint32_t& num_pis, const uint32_t& num_
     uint32_t normal_attempts = 0;
     bool sd_or_normal = true;
 
+    reserve_network( xmg, 1u + num_pis + num_lev * max_nodes_per_levels );
+
     for (uint32_t i =0; i < num_pis; i++)
     {
         sl.emplace_back( xmg.create_pi( ), false );
@@ -188,10 +190,14 @@ opt_parameters call_rw( xmg_network& xmg)
 template<typename Ntk>
 mockturtle::klut_network lut_map( Ntk const& ntk, uint32_t k = 4 )
 {
-  mockturtle::write_verilog( ntk, "/tmp/ex_network.v" );
-  system( fmt::format( "abc -q \"/tmp/ex_network.v; &get; &if -a -K {}; &put; write_blif /tmp/ex_output.blif\"", k ).c_str() );
+  auto const input = abc_input( ntk );
+  abc_exchange_file output;
+  run_abc( fmt::format( "&r {}; &if -a -K {}; &put; write_blif {}", input->path(), k, output.path() ) );
+
+  /* mockturtle cannot read ABC's binary mapping, the BLIF stays in memory */
+  std::istringstream blif( output.read() );
   mockturtle::klut_network klut;
-  if ( lorina::read_blif( "/tmp/ex_output.blif", mockturtle::blif_reader( klut ) ) != lorina::return_code::success )
+  if ( lorina::read_blif( blif, mockturtle::blif_reader( klut ) ) != lorina::return_code::success )
   {
     std::cout << "ERROR 1" << std::endl;
     std::abort();
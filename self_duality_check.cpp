@@ -0,0 +1,124 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <lorina/verilog.hpp>
+#include <mockturtle/algorithms/cleanup.hpp>
+#include <mockturtle/io/verilog_reader.hpp>
+#include <mockturtle/networks/xmg.hpp>
+
+#include <experiments.hpp>
+#include <xmg_sd_resub.hpp>
+#include <xmg_self_duality.hpp>
+
+/* checks that the outputs of the self-dualized EPFL benchmarks are self-dual, before and after optimization */
+int main( int argc, char** argv )
+{
+  using namespace experiments;
+  using namespace mockturtle;
+
+  auto const bps = parse_benchmark_params( argc, argv );
+
+  experiment<std::string, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, sample_statistics, sample_statistics> exp( "self_duality_check", "benchmark", "pos", "sd_pos", "refuted_by_sim", "size_after", "sd_pos_after", "runtime", "runtime_after" );
+
+  for ( auto const& benchmark : epfl_benchmarks() )
+  {
+    auto const filename = fmt::format( "{}self_dualized_epfl_benchmarks/{}_sd.v", EXPERIMENTS_PATH, benchmark );
+    if ( !std::ifstream( filename ).good() )
+    {
+      continue;
+    }
+
+    fmt::print( "[i] processing {}\n", benchmark );
+    xmg_network xmg;
+    if ( lorina::read_verilog( filename, verilog_reader( xmg ) ) != lorina::return_code::success )
+    {
+      fmt::print( "[e] could not read {}\n", filename );
+      continue;
+    }
+
+    self_duality_params ps;
+    self_duality_stats st;
+    self_duality_result result;
+
+    auto const runtime = repeat( bps, [&]() {
+      result = check_self_duality( xmg, ps, &st );
+      return to_seconds( st.time_total );
+    } );
+    auto const refuted_by_sim = st.num_refuted_by_simulation;
+
+    /* report the first outputs that are not self-dual */
+    auto num_printed = 0u;
+    for ( auto i = 0u; i < result.outputs.size() && num_printed < 5u; ++i )
+    {
+      if ( result.outputs[i] == self_duality_result::status::not_self_dual )
+      {
+        std::string cex;
+        for ( auto b : result.counterexamples[i] )
+        {
+          cex += b ? '1' : '0';
+        }
+        fmt::print( "[w] output {} is not self-dual, f(x) = f(!x) for x = {}\n", i, cex );
+        ++num_printed;
+      }
+    }
+
+    /* self-duality must survive optimization */
+    xmg_sd_resubstitution( xmg );
+    xmg = cleanup_dangling( xmg );
+
+    self_duality_result result_after;
+    auto const runtime_after = repeat( bps, [&]() {
+      result_after = check_self_duality( xmg, ps, &st );
+      return to_seconds( st.time_total );
+    } );
+
+    for ( auto i = 0u; i < result.outputs.size(); ++i )
+    {
+      if ( result.outputs[i] != result_after.outputs[i] && result_after.outputs[i] != self_duality_result::status::undecided )
+      {
+        fmt::print( "[e] self-duality of output {} changed by optimization\n", i );
+      }
+    }
+
+    exp( benchmark, xmg.num_pos(), result.count( self_duality_result::status::self_dual ), refuted_by_sim, xmg.num_gates(),
+         result_after.count( self_duality_result::status::self_dual ), runtime, runtime_after );
+  }
+
+  exp.save();
+  exp.table();
+
+  if ( !bps.baseline.empty() )
+  {
+    auto const regressions = exp.check_regressions( bps.baseline, {{"runtime", false, bps.threshold}, {"sd_pos", true, 0.0}, {"sd_pos_after", true, 0.0}} );
+    return regressions == 0u ? 0 : 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,421 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file self_duality_sampling.hpp
+  \brief Self-duality scores estimated from sampled gates
+
+  The exact scores of experiment #3 enumerate the cuts of every gate.  Here
+  gates are sampled, stratified by level, and cuts are enumerated only in a
+  window of bounded depth below the sampled gates, where nodes at the window
+  boundary act as leaves.  Each score is reported with a confidence interval
+  and the number of samples that would bound the error by
+  `ps.error_bound`.
+
+  Cuts of a window are the cuts of the network whose leaves are within the
+  window depth, so the estimate converges to the exact score as the window
+  depth grows.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/properties.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+#include "streaming_cut_enumeration.hpp"
+
+namespace mockturtle
+{
+
+struct self_duality_sampling_params
+{
+  /*! \brief Number of sampled gates (all gates are scored if the network is smaller). */
+  uint32_t num_samples{1000u};
+
+  /*! \brief Number of level ranges sampled separately (1: uniform sampling). */
+  uint32_t num_strata{8u};
+
+  /*! \brief Depth of the window below a sampled gate in which cuts are enumerated. */
+  uint32_t window_depth{8u};
+
+  /*! \brief Confidence level of the reported intervals. */
+  double confidence{0.95};
+
+  /*! \brief Half width of the interval for which the required sample size is reported. */
+  double error_bound{0.01};
+
+  /*! \brief Seed of the random sampling. */
+  uint64_t seed{1u};
+
+  /*! \brief Parameters of the cut enumeration in the windows. */
+  streaming_cut_enumeration_params cut_ps{};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct self_duality_sampling_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime of the cut enumeration in the windows. */
+  stopwatch<>::duration time_cuts{0};
+
+  uint32_t num_gates{0u};
+  uint32_t num_samples{0u};
+
+  /*! \brief Number of nodes in the union of all windows. */
+  uint32_t num_window_nodes{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] sampled gates = {} / {}, window nodes = {}\n", num_samples, num_gates, num_window_nodes );
+    std::cout << fmt::format( "[i] cut time   = {:>5.2f} secs\n", to_seconds( time_cuts ) );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", to_seconds( time_total ) );
+  }
+};
+
+/*! \brief Score with the half width of its confidence interval */
+struct self_duality_estimate
+{
+  double value{0.0};
+  double half_width{0.0};
+
+  /*! \brief Number of samples for a half width of at most `error_bound`. */
+  uint32_t required_samples{0u};
+
+  double lower() const
+  {
+    return value - half_width;
+  }
+
+  double upper() const
+  {
+    return value + half_width;
+  }
+};
+
+struct self_duality_scores
+{
+  /*! \brief Average over gates of the ratio of self-dual cuts. */
+  self_duality_estimate average_over_cuts;
+
+  /*! \brief Fraction of gates with a self-dual cut. */
+  self_duality_estimate maximum_of_cuts;
+};
+
+namespace detail
+{
+
+/*! \brief Contribution of a gate to the score averaged over cuts */
+template<class CutSet>
+double average_cut_score( CutSet const& cuts )
+{
+  auto num_self_dual_node_cuts = 0u;
+  auto num_node_cuts = 0u;
+  double score = 0.0;
+  for ( auto const& cut : cuts )
+  {
+    /* skip trivial cuts */
+    if ( cut.size() < 2 )
+      continue;
+
+    if ( kitty::is_selfdual( cut.truth_table() ) )
+    {
+      ++num_self_dual_node_cuts;
+    }
+    ++num_node_cuts;
+
+    score += double( num_self_dual_node_cuts ) / num_node_cuts;
+  }
+  return score;
+}
+
+/*! \brief Whether a non-trivial cut of a gate is self-dual */
+template<class CutSet>
+bool has_self_dual_cut( CutSet const& cuts )
+{
+  return std::any_of( cuts.begin(), cuts.end(), []( auto const& cut ) {
+    return cut.size() >= 2 && kitty::is_selfdual( cut.truth_table() );
+  } );
+}
+
+/*! \brief Quantile of the standard normal distribution for a two-sided `confidence` */
+inline double normal_quantile( double confidence )
+{
+  double lower = 0.0, upper = 10.0;
+  for ( auto i = 0u; i < 64u; ++i )
+  {
+    auto const mid = 0.5 * ( lower + upper );
+    ( std::erf( mid / std::sqrt( 2.0 ) ) < confidence ? lower : upper ) = mid;
+  }
+  return 0.5 * ( lower + upper );
+}
+
+template<class Ntk>
+class self_duality_sampling_impl
+{
+public:
+  using node = typename Ntk::node;
+  using signal = typename Ntk::signal;
+
+  self_duality_sampling_impl( Ntk const& ntk, self_duality_sampling_params const& ps, self_duality_sampling_stats& st )
+      : ntk( ntk ), ps( ps ), st( st ), rng( ps.seed )
+  {
+  }
+
+  self_duality_scores run()
+  {
+    stopwatch t( st.time_total );
+
+    sample();
+    score();
+
+    self_duality_scores scores;
+    scores.average_over_cuts = estimate( 0u );
+    scores.maximum_of_cuts = estimate( 1u );
+    return scores;
+  }
+
+private:
+  /* gates are sorted by level and split into strata of equal size, every
+     stratum gets a share of the samples proportional to its size */
+  void sample()
+  {
+    std::vector<uint32_t> levels( ntk.size(), 0u );
+    std::vector<node> gates;
+    topo_view topo{ntk};
+    topo.foreach_gate( [&]( auto const& n ) {
+      auto& level = levels[ntk.node_to_index( n )];
+      ntk.foreach_fanin( n, [&]( auto const& f ) {
+        level = std::max( level, levels[ntk.node_to_index( ntk.get_node( f ) )] + 1u );
+      } );
+      gates.push_back( n );
+    } );
+    std::stable_sort( gates.begin(), gates.end(), [&]( auto const& a, auto const& b ) {
+      return levels[ntk.node_to_index( a )] < levels[ntk.node_to_index( b )];
+    } );
+    st.num_gates = static_cast<uint32_t>( gates.size() );
+
+    auto const num_strata = std::max( 1u, std::min<uint32_t>( ps.num_strata, st.num_gates ) );
+    for ( auto h = 0u; h < num_strata; ++h )
+    {
+      auto const begin = gates.begin() + uint64_t( gates.size() ) * h / num_strata;
+      auto const end = gates.begin() + uint64_t( gates.size() ) * ( h + 1u ) / num_strata;
+      auto const size = static_cast<uint32_t>( std::distance( begin, end ) );
+
+      /* two samples per stratum give a variance estimate */
+      auto const share = static_cast<uint32_t>( std::lround( double( ps.num_samples ) * size / std::max( st.num_gates, 1u ) ) );
+      auto const num_samples = std::min( size, std::max( share, 2u ) );
+
+      strata.push_back( {size, static_cast<uint32_t>( samples.size() ), num_samples} );
+      std::sample( begin, end, std::back_inserter( samples ), num_samples, rng );
+    }
+    st.num_samples = static_cast<uint32_t>( samples.size() );
+  }
+
+  /* copies the windows of all samples into one network, in which the nodes
+     at depth `ps.window_depth` below a sample are primary inputs */
+  void score()
+  {
+    std::vector<uint32_t> depth( ntk.size(), UINT32_MAX );
+    std::vector<node> queue;
+    for ( auto const& n : samples )
+    {
+      if ( depth[ntk.node_to_index( n )] == UINT32_MAX )
+      {
+        depth[ntk.node_to_index( n )] = 0u;
+        queue.push_back( n );
+      }
+    }
+    for ( auto i = 0u; i < queue.size(); ++i )
+    {
+      auto const n = queue[i];
+      auto const d = depth[ntk.node_to_index( n )];
+      if ( d == ps.window_depth || ntk.is_constant( n ) || ntk.is_ci( n ) )
+      {
+        continue;
+      }
+      ntk.foreach_fanin( n, [&]( auto const& f ) {
+        auto const c = ntk.get_node( f );
+        if ( depth[ntk.node_to_index( c )] == UINT32_MAX )
+        {
+          depth[ntk.node_to_index( c )] = d + 1u;
+          queue.push_back( c );
+        }
+      } );
+    }
+    st.num_window_nodes = static_cast<uint32_t>( queue.size() );
+
+    Ntk window;
+    std::vector<signal> old_to_new( ntk.size() );
+    topo_view topo{ntk};
+    topo.foreach_node( [&]( auto const& n ) {
+      auto const index = ntk.node_to_index( n );
+      if ( depth[index] == UINT32_MAX )
+      {
+        return;
+      }
+      if ( ntk.is_constant( n ) )
+      {
+        old_to_new[index] = window.get_constant( false );
+      }
+      else if ( ntk.is_ci( n ) || depth[index] == ps.window_depth )
+      {
+        old_to_new[index] = window.create_pi();
+      }
+      else
+      {
+        std::vector<signal> children;
+        ntk.foreach_fanin( n, [&]( auto const& f ) {
+          auto const s = old_to_new[ntk.node_to_index( ntk.get_node( f ) )];
+          children.push_back( ntk.is_complemented( f ) ? window.create_not( s ) : s );
+        } );
+        old_to_new[index] = window.clone_node( ntk, n, children );
+      }
+    } );
+
+    std::vector<std::array<double, 2u>> window_values( window.size(), {0.0, 0.0} );
+    streaming_cut_enumeration_stats cut_st;
+    streaming_cut_enumeration( window, [&]( auto const& n, auto const& cuts ) {
+      window_values[window.node_to_index( n )] = {average_cut_score( cuts ), has_self_dual_cut( cuts ) ? 1.0 : 0.0};
+    }, ps.cut_ps, &cut_st );
+    st.time_cuts += cut_st.time_total;
+
+    /* a sample that became a leaf of the window has no non-trivial cuts */
+    for ( auto const& n : samples )
+    {
+      values.push_back( window_values[window.node_to_index( window.get_node( old_to_new[ntk.node_to_index( n )] ) )] );
+    }
+  }
+
+  /* stratified mean with finite population correction */
+  self_duality_estimate estimate( uint32_t score ) const
+  {
+    self_duality_estimate est;
+    if ( st.num_gates == 0u )
+    {
+      return est;
+    }
+
+    double variance = 0.0, pooled_variance = 0.0;
+    for ( auto const& s : strata )
+    {
+      if ( s.num_samples == 0u )
+      {
+        continue;
+      }
+
+      double mean = 0.0;
+      for ( auto i = s.first_sample; i < s.first_sample + s.num_samples; ++i )
+      {
+        mean += values[i][score];
+      }
+      mean /= s.num_samples;
+
+      double sample_variance = 0.0;
+      for ( auto i = s.first_sample; i < s.first_sample + s.num_samples; ++i )
+      {
+        sample_variance += ( values[i][score] - mean ) * ( values[i][score] - mean );
+      }
+      sample_variance = s.num_samples > 1u ? sample_variance / ( s.num_samples - 1u ) : 0.0;
+
+      auto const weight = double( s.size ) / st.num_gates;
+      est.value += weight * mean;
+      variance += weight * weight * ( 1.0 - double( s.num_samples ) / s.size ) * sample_variance / s.num_samples;
+      pooled_variance += weight * sample_variance;
+    }
+
+    auto const z = normal_quantile( ps.confidence );
+    est.half_width = z * std::sqrt( variance );
+
+    /* sample size for the error bound under proportional allocation */
+    auto const n0 = z * z * pooled_variance / ( ps.error_bound * ps.error_bound );
+    est.required_samples = static_cast<uint32_t>( std::ceil( n0 / ( 1.0 + n0 / st.num_gates ) ) );
+    return est;
+  }
+
+private:
+  struct stratum
+  {
+    uint32_t size;
+    uint32_t first_sample;
+    uint32_t num_samples;
+  };
+
+  Ntk const& ntk;
+  self_duality_sampling_params const& ps;
+  self_duality_sampling_stats& st;
+  std::mt19937_64 rng;
+
+  std::vector<stratum> strata;
+  std::vector<node> samples;
+
+  /* score averaged over cuts and self-dual cut indicator of every sample */
+  std::vector<std::array<double, 2u>> values;
+};
+
+} // namespace detail
+
+/*! \brief Estimates the self-duality scores of `ntk` from sampled gates
+ *
+ * The network must provide `clone_node` and a `node_function` of at most six
+ * inputs, as required by `streaming_cut_enumeration`.
+ */
+template<class Ntk>
+self_duality_scores estimate_self_duality( Ntk const& ntk, self_duality_sampling_params const& ps = {}, self_duality_sampling_stats* pst = nullptr )
+{
+  self_duality_sampling_stats st;
+  detail::self_duality_sampling_impl<Ntk> p( ntk, ps, st );
+  auto const scores = p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+    std::cout << fmt::format( "[i] average over cuts = {:.3f} +- {:.3f} ({} samples for +- {})\n", scores.average_over_cuts.value, scores.average_over_cuts.half_width, scores.average_over_cuts.required_samples, ps.error_bound );
+    std::cout << fmt::format( "[i] maximum of cuts   = {:.3f} +- {:.3f} ({} samples for +- {})\n", scores.maximum_of_cuts.value, scores.maximum_of_cuts.half_width, scores.maximum_of_cuts.required_samples, ps.error_bound );
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return scores;
+}
+
+} // namespace mockturtle
@@ -0,0 +1,141 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file self_dualize.hpp
+  \brief Self-dualization of logic networks
+
+  Every output f(x) is replaced by a self-dual function of x and one fresh
+  primary input p per output.  The network is copied twice, once with inputs
+  x and once with inputs !x, and each output is combined from p, f(x), and
+  f(!x) with the cheapest combiner of the gate basis:
+
+  - networks with `create_node` (k-LUT): one 3-LUT MAJ(p, f(x), !f(!x)),
+  - networks with `create_maj` (XMG, MIG): one gate MAJ(p, f(x), !f(!x)),
+  - otherwise (AIG): the multiplexer p ? f(x) : !f(!x) with three gates.
+
+  Inputs are ordered x followed by one p per output.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/operators.hpp>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+#include "network_pool.hpp"
+
+namespace mockturtle
+{
+
+namespace detail
+{
+
+template<class Ntk>
+signal<Ntk> self_dual_combiner( Ntk& ntk, signal<Ntk> const& p, signal<Ntk> const& f, signal<Ntk> const& f_dual )
+{
+  if constexpr ( has_create_node_v<Ntk> )
+  {
+    std::vector<kitty::dynamic_truth_table> vars( 3u, kitty::dynamic_truth_table( 3u ) );
+    for ( auto i = 0u; i < 3u; ++i )
+    {
+      kitty::create_nth_var( vars[i], i );
+    }
+    return ntk.create_node( {p, f, f_dual}, kitty::ternary_majority( vars[0], vars[1], ~vars[2] ) );
+  }
+  else if constexpr ( has_create_maj_v<Ntk> )
+  {
+    return ntk.create_maj( p, f, ntk.create_not( f_dual ) );
+  }
+  else
+  {
+    return ntk.create_or( ntk.create_and( p, f ), ntk.create_and( ntk.create_not( p ), ntk.create_not( f_dual ) ) );
+  }
+}
+
+} /* namespace detail */
+
+/*! \brief Self-dualizes all outputs of a network
+ *
+ * Returns a new network of the same type in which output i is a self-dual
+ * function of the primary inputs and a new input p_i.  Logic shared between
+ * outputs is copied only once per polarity of the inputs.
+ */
+template<class Ntk>
+Ntk self_dualize( Ntk const& ntk )
+{
+  static_assert( is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( has_clone_node_v<Ntk>, "Ntk does not implement the clone_node method" );
+  static_assert( has_create_not_v<Ntk>, "Ntk does not implement the create_not method" );
+
+  /* two copies of every node, plus one selector input and combiner per output */
+  auto dest = experiments::make_network<Ntk>( 2u * ntk.size() + 2u * ntk.num_pos() );
+  node_map<signal<Ntk>, Ntk> copy_x( ntk );
+  node_map<signal<Ntk>, Ntk> copy_nx( ntk );
+
+  copy_x[ntk.get_node( ntk.get_constant( false ) )] = dest.get_constant( false );
+  copy_nx[ntk.get_node( ntk.get_constant( false ) )] = dest.get_constant( false );
+  if ( ntk.get_node( ntk.get_constant( true ) ) != ntk.get_node( ntk.get_constant( false ) ) )
+  {
+    copy_x[ntk.get_node( ntk.get_constant( true ) )] = dest.get_constant( true );
+    copy_nx[ntk.get_node( ntk.get_constant( true ) )] = dest.get_constant( true );
+  }
+
+  ntk.foreach_pi( [&]( auto const& n ) {
+    auto const pi = dest.create_pi();
+    copy_x[n] = pi;
+    copy_nx[n] = dest.create_not( pi );
+  } );
+
+  auto const fanin_signal = [&]( auto& copy, auto const& fi ) {
+    auto const s = copy[ntk.get_node( fi )];
+    return ntk.is_complemented( fi ) ? dest.create_not( s ) : s;
+  };
+
+  topo_view topo{ntk};
+  topo.foreach_gate( [&]( auto const& n ) {
+    std::vector<signal<Ntk>> children_x, children_nx;
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      children_x.push_back( fanin_signal( copy_x, fi ) );
+      children_nx.push_back( fanin_signal( copy_nx, fi ) );
+    } );
+    copy_x[n] = dest.clone_node( ntk, n, children_x );
+    copy_nx[n] = dest.clone_node( ntk, n, children_nx );
+  } );
+
+  ntk.foreach_po( [&]( auto const& f ) {
+    auto const p = dest.create_pi();
+    dest.create_po( detail::self_dual_combiner( dest, p, fanin_signal( copy_x, f ), fanin_signal( copy_nx, f ) ) );
+  } );
+
+  return dest;
+}
+
+} /* namespace mockturtle */
@@ -0,0 +1,496 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file static_cut_enumeration.hpp
+  \brief Cut enumeration with the cut size as a compile-time constant
+
+  `static_cut_enumeration<K, CutLimit>` computes the same kind of priority cuts
+  as `cut_enumeration<Ntk, true>`, but every cut stores its leaves in a
+  `std::array<uint32_t, K>` with a 64-bit signature and its function as a
+  `kitty::static_truth_table<K>` (one machine word for K <= 6).  Cut sets are
+  fixed arrays of `CutLimit` cuts, so enumeration does not allocate per cut,
+  and merging, dominance checks, and truth-table expansion are loops over
+  compile-time bounds.
+
+  The truth table of a cut with k < K leaves is a function of the first k
+  variables and does not depend on the others.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/operations.hpp>
+#include <kitty/operators.hpp>
+#include <kitty/static_truth_table.hpp>
+#include <mockturtle/networks/aig.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+namespace mockturtle
+{
+
+struct static_cut_enumeration_params
+{
+  /*! \brief Remove leaves outside of the functional support. */
+  bool minimize_truth_table{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct static_cut_enumeration_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of cuts of all nodes. */
+  uint64_t num_cuts{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] cuts = {}, total time = {:>5.2f} secs\n", num_cuts, to_seconds( time_total ) );
+  }
+};
+
+template<uint32_t K>
+struct static_cut
+{
+  static_assert( K >= 1u && K <= 6u, "cut size must be between 1 and 6" );
+
+  std::array<uint32_t, K> leaves{};
+  uint32_t num_leaves{0u};
+  uint64_t signature{0u};
+  kitty::static_truth_table<K> function{};
+
+  uint32_t size() const
+  {
+    return num_leaves;
+  }
+
+  uint32_t const* begin() const
+  {
+    return leaves.data();
+  }
+
+  uint32_t const* end() const
+  {
+    return leaves.data() + num_leaves;
+  }
+
+  bool dominates( static_cut const& other ) const
+  {
+    if ( num_leaves > other.num_leaves || ( signature & other.signature ) != signature )
+    {
+      return false;
+    }
+    /* both leaf arrays are sorted */
+    uint32_t j{0u};
+    for ( auto i = 0u; i < num_leaves; ++i )
+    {
+      while ( j < other.num_leaves && other.leaves[j] < leaves[i] )
+      {
+        ++j;
+      }
+      if ( j == other.num_leaves || other.leaves[j] != leaves[i] )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/*! \brief At most `CutLimit` cuts of one node, the trivial cut last */
+template<uint32_t K, uint32_t CutLimit>
+struct static_cut_set
+{
+  std::array<static_cut<K>, CutLimit> cuts;
+  uint32_t num_cuts{0u};
+
+  uint32_t size() const
+  {
+    return num_cuts;
+  }
+
+  static_cut<K> const* begin() const
+  {
+    return cuts.data();
+  }
+
+  static_cut<K> const* end() const
+  {
+    return cuts.data() + num_cuts;
+  }
+
+  static_cut<K> const& operator[]( uint32_t i ) const
+  {
+    return cuts[i];
+  }
+};
+
+template<uint32_t K, uint32_t CutLimit>
+class static_network_cuts
+{
+public:
+  explicit static_network_cuts( uint32_t size )
+      : sets( size )
+  {
+  }
+
+  static_cut_set<K, CutLimit> const& cuts( uint32_t index ) const
+  {
+    return sets[index];
+  }
+
+  static_cut_set<K, CutLimit>& cuts( uint32_t index )
+  {
+    return sets[index];
+  }
+
+  uint64_t total_cuts() const
+  {
+    uint64_t total{0u};
+    for ( auto const& s : sets )
+    {
+      total += s.num_cuts;
+    }
+    return total;
+  }
+
+private:
+  std::vector<static_cut_set<K, CutLimit>> sets;
+};
+
+namespace detail
+{
+
+template<uint32_t K, uint32_t CutLimit, class Ntk>
+class static_cut_enumeration_impl
+{
+public:
+  using node = typename Ntk::node;
+  using cut_t = static_cut<K>;
+  using cut_set_t = static_cut_set<K, CutLimit>;
+
+  /* AIGs implement `is_xor3` as well, so gates are told apart by the network type */
+  static constexpr bool is_xmg = std::is_same_v<typename Ntk::base_type, xmg_network>;
+
+  static_cut_enumeration_impl( Ntk const& ntk, static_cut_enumeration_params const& ps, static_cut_enumeration_stats& st, static_network_cuts<K, CutLimit>& result )
+      : ntk( ntk ), ps( ps ), st( st ), result( result )
+  {
+    for ( auto i = 0u; i < K; ++i )
+    {
+      kitty::create_nth_var( projections[i], i );
+    }
+  }
+
+  void run()
+  {
+    stopwatch t( st.time_total );
+
+    /* the constant has the empty cut, primary inputs have the trivial cut */
+    auto& constant = result.cuts( ntk.node_to_index( ntk.get_node( ntk.get_constant( false ) ) ) );
+    constant.cuts[0] = cut_t{};
+    constant.num_cuts = 1u;
+    ntk.foreach_pi( [&]( auto const& n ) {
+      auto& set = result.cuts( ntk.node_to_index( n ) );
+      set.cuts[0] = trivial_cut( ntk.node_to_index( n ) );
+      set.num_cuts = 1u;
+    } );
+
+    topo_view topo{ntk};
+    topo.foreach_gate( [&]( auto const& n ) {
+      compute_cuts( n );
+      st.num_cuts += result.cuts( ntk.node_to_index( n ) ).size();
+    } );
+  }
+
+private:
+  cut_t trivial_cut( uint32_t index ) const
+  {
+    cut_t cut;
+    cut.leaves[0] = index;
+    cut.num_leaves = 1u;
+    cut.signature = uint64_t( 1 ) << ( index % 64u );
+    cut.function = projections[0];
+    return cut;
+  }
+
+  void compute_cuts( node const& n )
+  {
+    num_fanins = 0u;
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      fanin_sets[num_fanins] = &result.cuts( ntk.node_to_index( ntk.get_node( fi ) ) );
+      fanin_complements[num_fanins++] = ntk.is_complemented( fi );
+    } );
+    if constexpr ( is_xmg )
+    {
+      is_maj = ntk.is_maj( n );
+    }
+
+    auto& set = result.cuts( ntk.node_to_index( n ) );
+    set.num_cuts = 0u;
+    enumerate( 0u, set );
+    if ( set.num_cuts == CutLimit )
+    {
+      --set.num_cuts;
+    }
+    set.cuts[set.num_cuts++] = trivial_cut( ntk.node_to_index( n ) );
+  }
+
+  void enumerate( uint32_t fanin, cut_set_t& set )
+  {
+    if ( fanin == num_fanins )
+    {
+      cut_t cut;
+      if ( merge( cut ) )
+      {
+        insert( cut, set );
+      }
+      return;
+    }
+    for ( auto i = 0u; i < fanin_sets[fanin]->size(); ++i )
+    {
+      selection[fanin] = i;
+      enumerate( fanin + 1u, set );
+    }
+  }
+
+  bool merge( cut_t& cut )
+  {
+    for ( auto f = 0u; f < num_fanins; ++f )
+    {
+      auto const& c = ( *fanin_sets[f] )[selection[f]];
+      if ( __builtin_popcountll( cut.signature | c.signature ) > K )
+      {
+        return false;
+      }
+
+      std::array<uint32_t, K> merged;
+      uint32_t i{0u}, j{0u}, k{0u};
+      while ( i < cut.num_leaves || j < c.num_leaves )
+      {
+        if ( k == K )
+        {
+          return false;
+        }
+        if ( j == c.num_leaves || ( i < cut.num_leaves && cut.leaves[i] < c.leaves[j] ) )
+        {
+          merged[k++] = cut.leaves[i++];
+        }
+        else if ( i == cut.num_leaves || c.leaves[j] < cut.leaves[i] )
+        {
+          merged[k++] = c.leaves[j++];
+        }
+        else
+        {
+          merged[k++] = cut.leaves[i++];
+          ++j;
+        }
+      }
+      cut.leaves = merged;
+      cut.num_leaves = k;
+      cut.signature |= c.signature;
+    }
+
+    std::array<kitty::static_truth_table<K>, 3> fanin_functions;
+    for ( auto f = 0u; f < num_fanins; ++f )
+    {
+      auto const& c = ( *fanin_sets[f] )[selection[f]];
+      fanin_functions[f] = expand( c, cut );
+      if ( fanin_complements[f] )
+      {
+        fanin_functions[f] = ~fanin_functions[f];
+      }
+    }
+
+    if constexpr ( is_xmg )
+    {
+      cut.function = is_maj ? kitty::ternary_majority( fanin_functions[0], fanin_functions[1], fanin_functions[2] )
+                            : fanin_functions[0] ^ fanin_functions[1] ^ fanin_functions[2];
+    }
+    else
+    {
+      cut.function = fanin_functions[0] & fanin_functions[1];
+    }
+
+    if ( ps.minimize_truth_table )
+    {
+      minimize( cut );
+    }
+    return true;
+  }
+
+  /* moves variable j of `c` to the position of its leaf in `cut` */
+  kitty::static_truth_table<K> expand( cut_t const& c, cut_t const& cut ) const
+  {
+    auto tt = c.function;
+    if ( c.num_leaves == 0u )
+    {
+      return tt;
+    }
+
+    std::array<uint32_t, K> position{};
+    for ( auto j = 0u, k = 0u; j < c.num_leaves; ++j )
+    {
+      while ( cut.leaves[k] != c.leaves[j] )
+      {
+        ++k;
+      }
+      position[j] = k;
+    }
+    for ( auto j = c.num_leaves; j-- > 0u; )
+    {
+      if ( position[j] != j )
+      {
+        kitty::swap_inplace( tt, j, position[j] );
+      }
+    }
+    return tt;
+  }
+
+  void minimize( cut_t& cut ) const
+  {
+    for ( auto i = 0u; i < cut.num_leaves; )
+    {
+      if ( kitty::has_var( cut.function, i ) )
+      {
+        ++i;
+        continue;
+      }
+
+      /* move the variable behind the last leaf and drop it */
+      for ( auto j = i; j + 1u < cut.num_leaves; ++j )
+      {
+        kitty::swap_inplace( cut.function, j, j + 1u );
+        cut.leaves[j] = cut.leaves[j + 1u];
+      }
+      --cut.num_leaves;
+      cut.signature = 0u;
+      for ( auto j = 0u; j < cut.num_leaves; ++j )
+      {
+        cut.signature |= uint64_t( 1 ) << ( cut.leaves[j] % 64u );
+      }
+    }
+  }
+
+  /* keeps cuts sorted by size; drops dominated cuts and the largest cut beyond the limit */
+  void insert( cut_t const& cut, cut_set_t& set ) const
+  {
+    for ( auto i = 0u; i < set.num_cuts; ++i )
+    {
+      if ( set.cuts[i].dominates( cut ) )
+      {
+        return;
+      }
+    }
+
+    uint32_t k{0u};
+    for ( auto i = 0u; i < set.num_cuts; ++i )
+    {
+      if ( !cut.dominates( set.cuts[i] ) )
+      {
+        set.cuts[k++] = set.cuts[i];
+      }
+    }
+    set.num_cuts = k;
+
+    auto pos = set.num_cuts;
+    while ( pos > 0u && set.cuts[pos - 1u].num_leaves > cut.num_leaves )
+    {
+      --pos;
+    }
+    if ( pos == CutLimit )
+    {
+      return;
+    }
+    auto const last = std::min( set.num_cuts, CutLimit - 1u );
+    for ( auto i = last; i > pos; --i )
+    {
+      set.cuts[i] = set.cuts[i - 1u];
+    }
+    set.cuts[pos] = cut;
+    set.num_cuts = last + 1u;
+  }
+
+private:
+  Ntk const& ntk;
+  static_cut_enumeration_params const& ps;
+  static_cut_enumeration_stats& st;
+  static_network_cuts<K, CutLimit>& result;
+
+  std::array<kitty::static_truth_table<K>, K> projections;
+
+  /* state of the current node */
+  std::array<cut_set_t const*, 3> fanin_sets{};
+  std::array<bool, 3> fanin_complements{};
+  std::array<uint32_t, 3> selection{};
+  uint32_t num_fanins{0u};
+  bool is_maj{false};
+};
+
+} /* namespace detail */
+
+/*! \brief Enumerates cuts of at most K leaves with truth tables
+ *
+ * Supports networks with AND gates (AIGs) and networks with MAJ3/XOR3 gates
+ * (XMGs).  `CutLimit` includes the trivial cut.
+ */
+template<uint32_t K, uint32_t CutLimit = 12u, class Ntk>
+static_network_cuts<K, CutLimit> static_cut_enumeration( Ntk const& ntk, static_cut_enumeration_params const& ps = {}, static_cut_enumeration_stats* pst = nullptr )
+{
+  static_assert( is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( std::is_same_v<typename Ntk::base_type, aig_network> || std::is_same_v<typename Ntk::base_type, xmg_network>,
+                 "Ntk is neither an AIG nor an XMG (gate functions are only computed for AND and MAJ3/XOR3 gates)" );
+  static_assert( CutLimit >= 2u, "cut limit must leave room for one non-trivial cut" );
+
+  static_cut_enumeration_stats st;
+  static_network_cuts<K, CutLimit> result( ntk.size() );
+  detail::static_cut_enumeration_impl<K, CutLimit, Ntk> p( ntk, ps, st, result );
+  p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return result;
+}
+
+} /* namespace mockturtle */
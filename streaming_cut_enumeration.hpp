@@ -0,0 +1,432 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file streaming_cut_enumeration.hpp
+  \brief Cut enumeration with bounded memory
+
+  `streaming_cut_enumeration` visits the gates in topological order, computes
+  their priority cuts with truth tables, and passes them to a callback.  The
+  cuts of a node are released as soon as all gates in its fanout have been
+  visited, so the memory held by cuts is proportional to the cut frontier of
+  the topological order instead of the network size.
+
+  Cuts have at most 6 leaves; truth tables are single 64-bit words.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+namespace mockturtle
+{
+
+struct streaming_cut_enumeration_params
+{
+  /*! \brief Maximum number of leaves of a cut (at most 6). */
+  uint32_t cut_size{5u};
+
+  /*! \brief Maximum number of cuts of a node including the trivial cut. */
+  uint32_t cut_limit{12u};
+
+  /*! \brief Remove leaves outside of the functional support. */
+  bool minimize_truth_table{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct streaming_cut_enumeration_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of cuts passed to the callback. */
+  uint64_t num_cuts{0u};
+
+  /*! \brief Maximum number of nodes with cuts in memory. */
+  uint32_t peak_live_nodes{0u};
+
+  /*! \brief Maximum number of cuts in memory. */
+  uint64_t peak_live_cuts{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] cuts = {}, peak live nodes = {}, peak live cuts = {}\n", num_cuts, peak_live_nodes, peak_live_cuts );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", to_seconds( time_total ) );
+  }
+};
+
+/*! \brief Cut with at most 6 sorted leaves and its truth table */
+struct streaming_cut
+{
+  std::array<uint32_t, 6> leaves{};
+  uint32_t num_leaves{0u};
+  uint64_t signature{0u};
+  uint64_t function{0u};
+
+  uint32_t size() const
+  {
+    return num_leaves;
+  }
+
+  uint32_t const* begin() const
+  {
+    return leaves.data();
+  }
+
+  uint32_t const* end() const
+  {
+    return leaves.data() + num_leaves;
+  }
+
+  bool dominates( streaming_cut const& other ) const
+  {
+    return num_leaves <= other.num_leaves && ( signature & other.signature ) == signature && std::includes( other.begin(), other.end(), begin(), end() );
+  }
+
+  kitty::dynamic_truth_table truth_table() const
+  {
+    kitty::dynamic_truth_table tt( num_leaves );
+    *tt.begin() = function;
+    return tt;
+  }
+};
+
+namespace detail
+{
+
+inline uint64_t cut_function_mask( uint32_t num_vars )
+{
+  return num_vars >= 6u ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << ( 1u << num_vars ) ) - 1u );
+}
+
+template<class Ntk, class Fn>
+class streaming_cut_enumeration_impl
+{
+public:
+  using node = typename Ntk::node;
+  using cut_set = std::vector<streaming_cut>;
+
+  streaming_cut_enumeration_impl( Ntk const& ntk, Fn& fn, streaming_cut_enumeration_params const& ps, streaming_cut_enumeration_stats& st )
+      : ntk( ntk ), fn( fn ), ps( ps ), st( st ), cuts( ntk.size() ), refs( ntk.size(), 0u )
+  {
+    assert( ps.cut_size <= 6u );
+    assert( ps.cut_limit >= 1u );
+  }
+
+  void run()
+  {
+    stopwatch t( st.time_total );
+
+    /* only gates in the transitive fanin of the outputs are visited, so only their fanins are referenced */
+    topo_view topo{ntk};
+    topo.foreach_gate( [&]( auto const& n ) {
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        ++refs[ntk.node_to_index( ntk.get_node( fi ) )];
+      } );
+    } );
+
+    /* the constant has the empty cut, primary inputs have the trivial cut */
+    streaming_cut constant;
+    cuts[ntk.node_to_index( ntk.get_node( ntk.get_constant( false ) ) )].push_back( constant );
+    ntk.foreach_pi( [&]( auto const& n ) {
+      cuts[ntk.node_to_index( n )].push_back( trivial_cut( ntk.node_to_index( n ) ) );
+      live( 1u );
+    } );
+
+    topo.foreach_gate( [&]( auto const& n ) {
+      auto const index = ntk.node_to_index( n );
+      compute_cuts( n, cuts[index] );
+      live( static_cast<uint32_t>( cuts[index].size() ) );
+      st.num_cuts += cuts[index].size();
+
+      fn( n, static_cast<cut_set const&>( cuts[index] ) );
+
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        auto const c = ntk.node_to_index( ntk.get_node( fi ) );
+        if ( !ntk.is_constant( ntk.get_node( fi ) ) && --refs[c] == 0u )
+        {
+          release( c );
+        }
+      } );
+      if ( refs[index] == 0u )
+      {
+        release( index );
+      }
+    } );
+  }
+
+private:
+  static streaming_cut trivial_cut( uint32_t index )
+  {
+    streaming_cut cut;
+    cut.leaves[0] = index;
+    cut.num_leaves = 1u;
+    cut.signature = uint64_t( 1 ) << ( index % 64u );
+    cut.function = 0x2;
+    return cut;
+  }
+
+  void live( uint32_t num_cuts )
+  {
+    ++live_nodes;
+    live_cuts += num_cuts;
+    st.peak_live_nodes = std::max( st.peak_live_nodes, live_nodes );
+    st.peak_live_cuts = std::max( st.peak_live_cuts, live_cuts );
+  }
+
+  void release( uint32_t index )
+  {
+    --live_nodes;
+    live_cuts -= cuts[index].size();
+    cut_set().swap( cuts[index] );
+  }
+
+  void compute_cuts( node const& n, cut_set& result )
+  {
+    fanin_sets.clear();
+    fanin_complements.clear();
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      fanin_sets.push_back( &cuts[ntk.node_to_index( ntk.get_node( fi ) )] );
+      fanin_complements.push_back( ntk.is_complemented( fi ) );
+    } );
+    gate_function = *ntk.node_function( n ).cbegin();
+
+    result.clear();
+    selection.assign( fanin_sets.size(), 0u );
+    enumerate( 0u, result );
+
+    std::stable_sort( result.begin(), result.end(), []( auto const& a, auto const& b ) { return a.num_leaves < b.num_leaves; } );
+    if ( result.size() + 1u > ps.cut_limit )
+    {
+      result.resize( ps.cut_limit - 1u );
+    }
+    result.push_back( trivial_cut( ntk.node_to_index( n ) ) );
+  }
+
+  /* all combinations of one cut per fanin */
+  void enumerate( uint32_t fanin, cut_set& result )
+  {
+    if ( fanin == fanin_sets.size() )
+    {
+      streaming_cut cut;
+      if ( merge( cut ) )
+      {
+        insert( cut, result );
+      }
+      return;
+    }
+    for ( auto i = 0u; i < fanin_sets[fanin]->size(); ++i )
+    {
+      selection[fanin] = i;
+      enumerate( fanin + 1u, result );
+    }
+  }
+
+  bool merge( streaming_cut& cut )
+  {
+    for ( auto i = 0u; i < fanin_sets.size(); ++i )
+    {
+      auto const& c = ( *fanin_sets[i] )[selection[i]];
+      std::array<uint32_t, 12> merged;
+      auto const end = std::set_union( cut.begin(), cut.end(), c.begin(), c.end(), merged.begin() );
+      auto const size = static_cast<uint32_t>( end - merged.begin() );
+      if ( size > ps.cut_size )
+      {
+        return false;
+      }
+      std::copy( merged.begin(), end, cut.leaves.begin() );
+      cut.num_leaves = size;
+      cut.signature |= c.signature;
+    }
+
+    /* compose the gate function with the expanded fanin functions */
+    std::array<uint64_t, 6> fanin_functions{};
+    for ( auto i = 0u; i < fanin_sets.size(); ++i )
+    {
+      auto const& c = ( *fanin_sets[i] )[selection[i]];
+      auto const f = expand( c, cut );
+      fanin_functions[i] = fanin_complements[i] ? ~f : f;
+    }
+
+    auto const mask = cut_function_mask( cut.num_leaves );
+    uint64_t function{0u};
+    for ( auto m = 0u; m < ( 1u << fanin_sets.size() ); ++m )
+    {
+      if ( ( ( gate_function >> m ) & 1u ) == 0u )
+      {
+        continue;
+      }
+      uint64_t term = mask;
+      for ( auto i = 0u; i < fanin_sets.size(); ++i )
+      {
+        term &= ( ( m >> i ) & 1u ) ? fanin_functions[i] : ~fanin_functions[i];
+      }
+      function |= term;
+    }
+    cut.function = function & mask;
+
+    if ( ps.minimize_truth_table )
+    {
+      minimize( cut );
+    }
+    return true;
+  }
+
+  /* function of `c` over the leaves of `cut` (a superset) */
+  static uint64_t expand( streaming_cut const& c, streaming_cut const& cut )
+  {
+    if ( c.num_leaves == 0u )
+    {
+      return c.function ? ~uint64_t( 0 ) : uint64_t( 0 );
+    }
+
+    std::array<uint32_t, 6> position{};
+    for ( auto j = 0u, k = 0u; j < c.num_leaves; ++j )
+    {
+      while ( cut.leaves[k] != c.leaves[j] )
+      {
+        ++k;
+      }
+      position[j] = k;
+    }
+
+    uint64_t result{0u};
+    for ( auto m = 0u; m < ( 1u << cut.num_leaves ); ++m )
+    {
+      uint32_t index{0u};
+      for ( auto j = 0u; j < c.num_leaves; ++j )
+      {
+        index |= ( ( m >> position[j] ) & 1u ) << j;
+      }
+      result |= ( ( c.function >> index ) & 1u ) << m;
+    }
+    return result;
+  }
+
+  static void minimize( streaming_cut& cut )
+  {
+    /* minterms with variable i = 0 */
+    static constexpr uint64_t negative[] = {0x5555555555555555, 0x3333333333333333, 0x0f0f0f0f0f0f0f0f,
+                                            0x00ff00ff00ff00ff, 0x0000ffff0000ffff, 0x00000000ffffffff};
+    for ( auto i = 0u; i < cut.num_leaves; )
+    {
+      auto const shift = 1u << i;
+      auto const mask = cut_function_mask( cut.num_leaves );
+      if ( ( ( cut.function ^ ( cut.function >> shift ) ) & negative[i] & mask ) != 0u )
+      {
+        ++i;
+        continue;
+      }
+
+      /* drop variable i */
+      uint64_t function{0u};
+      for ( auto m = 0u; m < ( 1u << ( cut.num_leaves - 1u ) ); ++m )
+      {
+        auto const low = m & ( shift - 1u );
+        auto const high = ( m & ~( shift - 1u ) ) << 1u;
+        function |= ( ( cut.function >> ( low | high ) ) & 1u ) << m;
+      }
+      cut.function = function;
+      std::copy( cut.leaves.begin() + i + 1u, cut.leaves.begin() + cut.num_leaves, cut.leaves.begin() + i );
+      --cut.num_leaves;
+      cut.signature = 0u;
+      for ( auto j = 0u; j < cut.num_leaves; ++j )
+      {
+        cut.signature |= uint64_t( 1 ) << ( cut.leaves[j] % 64u );
+      }
+    }
+  }
+
+  static void insert( streaming_cut const& cut, cut_set& result )
+  {
+    for ( auto const& other : result )
+    {
+      if ( other.dominates( cut ) )
+      {
+        return;
+      }
+    }
+    result.erase( std::remove_if( result.begin(), result.end(), [&]( auto const& other ) { return cut.dominates( other ); } ), result.end() );
+    result.push_back( cut );
+  }
+
+private:
+  Ntk const& ntk;
+  Fn& fn;
+  streaming_cut_enumeration_params const& ps;
+  streaming_cut_enumeration_stats& st;
+
+  std::vector<cut_set> cuts;
+  std::vector<uint32_t> refs;
+  uint32_t live_nodes{0u};
+  uint64_t live_cuts{0u};
+
+  /* state of the current node */
+  std::vector<cut_set const*> fanin_sets;
+  std::vector<bool> fanin_complements;
+  std::vector<uint32_t> selection;
+  uint64_t gate_function{0u};
+};
+
+} /* namespace detail */
+
+/*! \brief Enumerates cuts in topological order and releases them early
+ *
+ * Calls `fn( n, cuts )` for every gate `n` with its cuts (a
+ * `std::vector<streaming_cut>`, the trivial cut last).  The cuts of a node
+ * are valid until its last fanout gate has been visited; `fn` must not keep
+ * references beyond the call.
+ */
+template<class Ntk, class Fn>
+void streaming_cut_enumeration( Ntk const& ntk, Fn&& fn, streaming_cut_enumeration_params const& ps = {}, streaming_cut_enumeration_stats* pst = nullptr )
+{
+  streaming_cut_enumeration_stats st;
+  detail::streaming_cut_enumeration_impl<Ntk, Fn> p( ntk, fn, ps, st );
+  p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+}
+
+} /* namespace mockturtle */
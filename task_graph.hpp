@@ -0,0 +1,205 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file task_graph.hpp
+  \brief Execution of small task DAGs on a fixed number of threads
+
+  A benchmark flow is modeled as tasks with dependencies on earlier tasks,
+  e.g., reading, mapping, optimization, scoring, and verification of each
+  benchmark.  Tasks whose dependencies are finished run concurrently; among
+  ready tasks the one added first is started first, so that earlier
+  benchmarks are finished before later ones are started where possible.
+  With one thread the tasks run in the order in which they were added.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace experiments
+{
+
+struct task_graph_stats
+{
+  uint32_t num_threads{0u};
+  uint32_t num_tasks{0u};
+
+  /*! \brief Largest number of tasks that ran at the same time. */
+  uint32_t max_concurrency{0u};
+
+  void report() const
+  {
+    fmt::print( "[i] tasks = {} on {} threads, max. concurrency = {}\n", num_tasks, num_threads, max_concurrency );
+  }
+};
+
+class task_graph
+{
+public:
+  using task_id = uint32_t;
+
+  /*! \brief Adds a task that runs after all `dependencies` have finished */
+  task_id add( std::function<void()> fn, std::vector<task_id> const& dependencies = {} )
+  {
+    auto const id = static_cast<task_id>( tasks.size() );
+    tasks.push_back( {std::move( fn ), 0u, {}} );
+    for ( auto const& d : dependencies )
+    {
+      if ( d >= id )
+      {
+        throw std::invalid_argument( "task_graph: dependencies must be added before their successors" );
+      }
+      tasks[d].successors.push_back( id );
+      ++tasks[id].num_open;
+    }
+    return id;
+  }
+
+  /*! \brief Runs all tasks on `num_threads` threads (0: hardware concurrency)
+   *
+   * No new tasks are started once a task has thrown; the first exception is
+   * rethrown after the running tasks have finished.
+   */
+  void run( uint32_t num_threads = 0u )
+  {
+    st = {};
+    st.num_tasks = static_cast<uint32_t>( tasks.size() );
+    num_threads = num_threads != 0u ? num_threads : std::max( std::thread::hardware_concurrency(), 1u );
+    st.num_threads = std::min<uint32_t>( num_threads, std::max<uint32_t>( st.num_tasks, 1u ) );
+
+    for ( auto i = 0u; i < tasks.size(); ++i )
+    {
+      if ( tasks[i].num_open == 0u )
+      {
+        ready.push( i );
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for ( auto t = 1u; t < st.num_threads; ++t )
+    {
+      threads.emplace_back( [this]() { work(); } );
+    }
+    work();
+    for ( auto& t : threads )
+    {
+      t.join();
+    }
+
+    tasks.clear();
+    if ( error )
+    {
+      std::rethrow_exception( std::exchange( error, nullptr ) );
+    }
+  }
+
+  task_graph_stats const& stats() const
+  {
+    return st;
+  }
+
+private:
+  void work()
+  {
+    std::unique_lock lock( mutex );
+    while ( true )
+    {
+      cv.wait( lock, [&]() { return !ready.empty() || num_running == 0u || error; } );
+      if ( ready.empty() || error )
+      {
+        /* nothing can become ready anymore */
+        if ( num_running == 0u || error )
+        {
+          cv.notify_all();
+          return;
+        }
+        continue;
+      }
+
+      auto const id = ready.top();
+      ready.pop();
+      ++num_running;
+      st.max_concurrency = std::max( st.max_concurrency, num_running );
+
+      lock.unlock();
+      std::exception_ptr e;
+      try
+      {
+        tasks[id].fn();
+      }
+      catch ( ... )
+      {
+        e = std::current_exception();
+      }
+      lock.lock();
+
+      --num_running;
+      if ( e && !error )
+      {
+        error = e;
+      }
+      for ( auto const& s : tasks[id].successors )
+      {
+        if ( --tasks[s].num_open == 0u )
+        {
+          ready.push( s );
+        }
+      }
+      cv.notify_all();
+    }
+  }
+
+private:
+  struct task
+  {
+    std::function<void()> fn;
+    uint32_t num_open;
+    std::vector<task_id> successors;
+  };
+
+  std::vector<task> tasks;
+  std::priority_queue<task_id, std::vector<task_id>, std::greater<task_id>> ready;
+  uint32_t num_running{0u};
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable cv;
+  task_graph_stats st;
+};
+
+} // namespace experiments
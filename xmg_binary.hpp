@@ -0,0 +1,242 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_binary.hpp
+  \brief Compact binary format for XMGs
+
+  The format follows the binary AIGER encoding.  Nodes are numbered in
+  topological order (constant, primary inputs, gates) and literals are
+  `2 * index + complement`.  A gate with index `i` stores the differences
+  `2 * i - lit` of its three fanin literals as variable-length integers; the
+  first difference is shifted by one bit to hold the gate type (0 for MAJ, 1
+  for XOR3).  Outputs are stored as plain literals.
+
+  \verbatim
+  "XMGB" <version> <#PIs> <#gates> <#POs>
+  (<delta0 << 1 | is_xor3> <delta1> <delta2>)*   one triple per gate
+  <lit>*                                          one literal per output
+  \endverbatim
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+namespace mockturtle
+{
+
+namespace detail
+{
+
+static constexpr char xmg_binary_magic[4] = {'X', 'M', 'G', 'B'};
+static constexpr uint8_t xmg_binary_version = 1u;
+
+inline void write_varint( std::ostream& os, uint64_t value )
+{
+  while ( value >= 0x80 )
+  {
+    os.put( static_cast<char>( ( value & 0x7f ) | 0x80 ) );
+    value >>= 7;
+  }
+  os.put( static_cast<char>( value ) );
+}
+
+inline bool read_varint( std::istream& is, uint64_t& value )
+{
+  value = 0u;
+  for ( auto shift = 0u; shift < 64u; shift += 7u )
+  {
+    auto const c = is.get();
+    if ( c == std::istream::traits_type::eof() )
+    {
+      return false;
+    }
+    value |= uint64_t( c & 0x7f ) << shift;
+    if ( ( c & 0x80 ) == 0 )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace detail
+
+/*! \brief Writes an XMG in binary format
+ *
+ * Only gates in the transitive fanin of the outputs are written.
+ */
+template<class Ntk>
+void write_xmg_binary( Ntk const& ntk, std::ostream& os )
+{
+  static_assert( is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( has_is_maj_v<Ntk>, "Ntk does not implement the is_maj method" );
+  static_assert( has_is_xor3_v<Ntk>, "Ntk does not implement the is_xor3 method" );
+
+  std::vector<node<Ntk>> gates;
+  topo_view<Ntk>{ntk}.foreach_gate( [&]( auto const& n ) {
+    gates.push_back( n );
+  } );
+
+  node_map<uint64_t, Ntk> index( ntk );
+  uint64_t next_index = 0u;
+  index[ntk.get_node( ntk.get_constant( false ) )] = next_index++;
+  ntk.foreach_pi( [&]( auto const& n ) {
+    index[n] = next_index++;
+  } );
+
+  auto const literal = [&]( auto const& f ) {
+    return 2u * index[ntk.get_node( f )] + ( ntk.is_complemented( f ) ? 1u : 0u );
+  };
+
+  os.write( detail::xmg_binary_magic, sizeof( detail::xmg_binary_magic ) );
+  os.put( static_cast<char>( detail::xmg_binary_version ) );
+  detail::write_varint( os, ntk.num_pis() );
+  detail::write_varint( os, gates.size() );
+  detail::write_varint( os, ntk.num_pos() );
+
+  for ( auto const& n : gates )
+  {
+    auto const i = next_index++;
+    ntk.foreach_fanin( n, [&]( auto const& f, auto j ) {
+      auto const delta = 2u * i - literal( f );
+      detail::write_varint( os, j == 0 ? ( delta << 1 ) | ( ntk.is_xor3( n ) ? 1u : 0u ) : delta );
+    } );
+    index[n] = i;
+  }
+
+  ntk.foreach_po( [&]( auto const& f ) {
+    detail::write_varint( os, literal( f ) );
+  } );
+}
+
+/*! \brief Writes an XMG in binary format into a file */
+template<class Ntk>
+void write_xmg_binary( Ntk const& ntk, std::string const& filename )
+{
+  std::ofstream os( filename, std::ofstream::out | std::ofstream::binary );
+  write_xmg_binary( ntk, os );
+}
+
+/*! \brief Reads an XMG in binary format into an empty network
+ *
+ * Returns false if the input is not a well-formed XMG in binary format; the
+ * network is then in an unspecified state.
+ */
+template<class Ntk>
+bool read_xmg_binary( std::istream& is, Ntk& ntk )
+{
+  static_assert( is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( has_create_pi_v<Ntk>, "Ntk does not implement the create_pi method" );
+  static_assert( has_create_po_v<Ntk>, "Ntk does not implement the create_po method" );
+  static_assert( has_create_maj_v<Ntk>, "Ntk does not implement the create_maj method" );
+  static_assert( has_create_xor3_v<Ntk>, "Ntk does not implement the create_xor3 method" );
+
+  char magic[sizeof( detail::xmg_binary_magic )];
+  if ( !is.read( magic, sizeof( magic ) ) || !std::equal( magic, magic + sizeof( magic ), detail::xmg_binary_magic ) ||
+       is.get() != detail::xmg_binary_version )
+  {
+    return false;
+  }
+
+  uint64_t num_pis, num_gates, num_pos;
+  if ( !detail::read_varint( is, num_pis ) || !detail::read_varint( is, num_gates ) || !detail::read_varint( is, num_pos ) )
+  {
+    return false;
+  }
+
+  std::vector<signal<Ntk>> signals;
+  signals.reserve( 1u + num_pis + num_gates );
+  signals.push_back( ntk.get_constant( false ) );
+  for ( auto i = 0u; i < num_pis; ++i )
+  {
+    signals.push_back( ntk.create_pi() );
+  }
+
+  auto const to_signal = [&]( uint64_t lit ) {
+    auto const& s = signals[lit >> 1];
+    return ( lit & 1 ) ? ntk.create_not( s ) : s;
+  };
+
+  for ( auto g = 0u; g < num_gates; ++g )
+  {
+    uint64_t const i = signals.size();
+    std::array<uint64_t, 3u> deltas;
+    for ( auto& d : deltas )
+    {
+      if ( !detail::read_varint( is, d ) )
+      {
+        return false;
+      }
+    }
+    bool const is_xor3 = deltas[0] & 1;
+    deltas[0] >>= 1;
+
+    std::array<signal<Ntk>, 3u> fanins;
+    for ( auto j = 0u; j < 3u; ++j )
+    {
+      if ( deltas[j] == 0u || deltas[j] > 2u * i )
+      {
+        return false;
+      }
+      fanins[j] = to_signal( 2u * i - deltas[j] );
+    }
+    signals.push_back( is_xor3 ? ntk.create_xor3( fanins[0], fanins[1], fanins[2] ) : ntk.create_maj( fanins[0], fanins[1], fanins[2] ) );
+  }
+
+  for ( auto o = 0u; o < num_pos; ++o )
+  {
+    uint64_t lit;
+    if ( !detail::read_varint( is, lit ) || ( lit >> 1 ) >= signals.size() )
+    {
+      return false;
+    }
+    ntk.create_po( to_signal( lit ) );
+  }
+
+  return true;
+}
+
+/*! \brief Reads an XMG in binary format from a file */
+template<class Ntk>
+bool read_xmg_binary( std::string const& filename, Ntk& ntk )
+{
+  std::ifstream is( filename, std::ifstream::in | std::ifstream::binary );
+  return is.good() && read_xmg_binary( is, ntk );
+}
+
+} // namespace mockturtle
@@ -0,0 +1,304 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file xmg_choice.hpp
+  \brief XMGs with structural choices
+
+  An `xmg_choice_network` collects several functionally equivalent snapshots
+  of an XMG, e.g., the networks after every rewriting and resubstitution
+  pass or the results of different resynthesis databases, in one structurally
+  hashed XMG over shared primary inputs.  `compute_choices` proves
+  equivalences between nodes with SAT sweeping and links every proved node
+  as a choice to the representative of its class, i.e., the class member
+  that comes first in topological order.  A choice is only added if it does
+  not create a cycle, i.e., if the representative is not in the transitive
+  fanin of the choice when classes are seen as single nodes.
+
+  The primary outputs are the ones of the first snapshot.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+#include "xmg_fraig.hpp"
+
+namespace mockturtle
+{
+
+struct xmg_choice_params
+{
+  /*! \brief Parameters of SAT sweeping. */
+  xmg_fraig_params fraig_ps{};
+
+  /*! \brief Maximum number of classes visited by the cycle check of one choice. */
+  uint32_t max_visits{1000u};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct xmg_choice_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Statistics of SAT sweeping. */
+  xmg_fraig_stats fraig_st{};
+
+  uint32_t num_snapshots{0u};
+  uint32_t num_nodes{0u};
+  uint32_t num_classes{0u};
+  uint32_t num_choices{0u};
+  uint32_t num_rejected{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] snapshots = {}, nodes = {}, classes with choices = {}, choices = {} ({} rejected)\n", num_snapshots, num_nodes, num_classes, num_choices, num_rejected );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs (simulation: {:>5.2f} secs, SAT: {:>5.2f} secs)\n", to_seconds( time_total ), to_seconds( fraig_st.time_simulation ), to_seconds( fraig_st.time_sat ) );
+  }
+};
+
+class xmg_choice_network
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  explicit xmg_choice_network( xmg_network const& ntk )
+  {
+    for ( auto i = 0u; i < ntk.num_pis(); ++i )
+    {
+      ntk_.create_pi();
+    }
+    for ( auto const& f : copy( ntk ) )
+    {
+      ntk_.create_po( f );
+    }
+    reset_choices();
+  }
+
+  /*! \brief Adds a snapshot that is functionally equivalent to the first one */
+  void add( xmg_network const& ntk )
+  {
+    assert( ntk.num_pis() == ntk_.num_pis() && ntk.num_pos() == ntk_.num_pos() );
+    copy( ntk );
+    reset_choices();
+  }
+
+  /*! \brief Links the proved equivalences as choices (previous choices are discarded) */
+  void compute_choices( xmg_choice_params const& ps = {}, xmg_choice_stats* pst = nullptr )
+  {
+    xmg_choice_stats st;
+    {
+      stopwatch t( st.time_total );
+      reset_choices();
+
+      detail::xmg_fraig_impl fraig( ntk_, ps.fraig_ps, st.fraig_st );
+      fraig.sweep();
+
+      /* nodes are stored in topological order, so members are linked after their representatives */
+      ntk_.foreach_gate( [&]( auto const& n ) {
+        auto const r = fraig.representative( n );
+        if ( r == UINT32_MAX )
+        {
+          return;
+        }
+        if ( creates_cycle( n, r, ps.max_visits ) )
+        {
+          ++st.num_rejected;
+          return;
+        }
+
+        auto const index = ntk_.node_to_index( n );
+        st.num_classes += next_[r] == UINT32_MAX ? 1u : 0u;
+        ++st.num_choices;
+        repr_[index] = r;
+        phase_[index] = fraig.complemented( n );
+        next_[index] = next_[r];
+        next_[r] = index;
+      } );
+    }
+
+    st.num_snapshots = num_snapshots_;
+    st.num_nodes = ntk_.size();
+    if ( ps.verbose )
+    {
+      st.report();
+    }
+    if ( pst )
+    {
+      *pst = st;
+    }
+  }
+
+  /*! \brief The XMG with all snapshots */
+  xmg_network const& network() const
+  {
+    return ntk_;
+  }
+
+  uint32_t num_snapshots() const
+  {
+    return num_snapshots_;
+  }
+
+  /*! \brief Whether a node is the representative of its class (also true for nodes without choices) */
+  bool is_representative( node const& n ) const
+  {
+    return repr_[ntk_.node_to_index( n )] == UINT32_MAX;
+  }
+
+  node get_representative( node const& n ) const
+  {
+    auto const r = repr_[ntk_.node_to_index( n )];
+    return r == UINT32_MAX ? n : ntk_.index_to_node( r );
+  }
+
+  /*! \brief Whether a node is equivalent to the complement of its representative */
+  bool is_complemented_choice( node const& n ) const
+  {
+    return phase_[ntk_.node_to_index( n )];
+  }
+
+  /*! \brief Calls `fn( member, complemented )` for all members of the class of a representative, starting with it */
+  template<typename Fn>
+  void foreach_choice( node const& r, Fn&& fn ) const
+  {
+    for ( auto index = ntk_.node_to_index( r ); index != UINT32_MAX; index = next_[index] )
+    {
+      fn( ntk_.index_to_node( index ), static_cast<bool>( phase_[index] ) );
+    }
+  }
+
+private:
+  std::vector<signal> copy( xmg_network const& ntk )
+  {
+    ++num_snapshots_;
+
+    node_map<signal, xmg_network> old2new( ntk );
+    old2new[ntk.get_node( ntk.get_constant( false ) )] = ntk_.get_constant( false );
+    ntk.foreach_pi( [&]( auto const& n, auto i ) {
+      old2new[n] = ntk_.make_signal( ntk_.pi_at( i ) );
+    } );
+
+    topo_view<xmg_network>{ntk}.foreach_gate( [&]( auto const& n ) {
+      std::array<signal, 3> children;
+      ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+        children[i] = old2new[ntk.get_node( fi )] ^ ntk.is_complemented( fi );
+      } );
+      old2new[n] = ntk.is_xor3( n ) ? ntk_.create_xor3( children[0], children[1], children[2] ) : ntk_.create_maj( children[0], children[1], children[2] );
+    } );
+
+    std::vector<signal> outputs;
+    ntk.foreach_po( [&]( auto const& f ) {
+      outputs.push_back( old2new[ntk.get_node( f )] ^ ntk.is_complemented( f ) );
+    } );
+    return outputs;
+  }
+
+  void reset_choices()
+  {
+    repr_.assign( ntk_.size(), UINT32_MAX );
+    phase_.assign( ntk_.size(), 0u );
+    next_.assign( ntk_.size(), UINT32_MAX );
+  }
+
+  /* whether class r is reachable from the fanins of n, classes being single nodes */
+  bool creates_cycle( node const& n, uint32_t r, uint32_t max_visits )
+  {
+    ++trav_id_;
+    visited_.resize( ntk_.size(), 0u );
+    stack_.clear();
+    stack_.push_back( ntk_.node_to_index( n ) );
+
+    uint32_t num_visits{0u};
+    while ( !stack_.empty() )
+    {
+      auto const index = stack_.back();
+      stack_.pop_back();
+
+      bool found{false};
+      ntk_.foreach_fanin( ntk_.index_to_node( index ), [&]( auto const& fi ) {
+        auto const c = get_representative( ntk_.get_node( fi ) );
+        auto const ci = ntk_.node_to_index( c );
+        if ( ci == r )
+        {
+          found = true;
+          return false;
+        }
+        if ( visited_[ci] == trav_id_ )
+        {
+          return true;
+        }
+        visited_[ci] = trav_id_;
+        ++num_visits;
+
+        /* classes of inputs and constants may have gates as choices */
+        for ( auto m = ci; m != UINT32_MAX; m = next_[m] )
+        {
+          auto const member = ntk_.index_to_node( m );
+          if ( !ntk_.is_constant( member ) && !ntk_.is_pi( member ) )
+          {
+            stack_.push_back( m );
+          }
+        }
+        return true;
+      } );
+
+      /* too large cones are treated like cycles */
+      if ( found || num_visits > max_visits )
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  xmg_network ntk_;
+  uint32_t num_snapshots_{0u};
+
+  std::vector<uint32_t> repr_;
+  std::vector<uint8_t> phase_;
+  std::vector<uint32_t> next_;
+
+  uint32_t trav_id_{0u};
+  std::vector<uint32_t> visited_;
+  std::vector<uint32_t> stack_;
+};
+
+} /* namespace mockturtle */
@@ -0,0 +1,647 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file xmg_choice_mapping.hpp
+  \brief Area-oriented genlib mapping of XMGs with structural choices
+
+  Classes of an `xmg_choice_network` are mapped as single nodes: the cuts
+  of a class are the cuts of all its members (with truth tables in the phase
+  of the representative), and cut leaves are always representatives.  Every
+  cut is matched against the library; cuts with up to three leaves cost the
+  area of the cheapest realization according to `xmg_genlib_cost`, cuts with
+  four leaves the area of a four-input gate under input permutation and
+  negation.  Inverters at gate inputs and outputs are charged with the area
+  of the cheapest inverter.
+
+  The first pass selects cuts by area flow with structural fanout
+  estimates, later passes use the fanout of the current cover.  The final
+  cover can be emitted as a k-LUT network with one node per selected cut
+  (and one per output inverter), e.g., to verify it or to write it as BLIF.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/networks/klut.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include "xmg_choice.hpp"
+#include "xmg_genlib_cost.hpp"
+
+namespace mockturtle
+{
+
+struct choice_mapping_params
+{
+  /*! \brief Maximum number of cut leaves (3 or 4). */
+  uint32_t cut_size{4u};
+
+  /*! \brief Maximum number of cuts per class. */
+  uint32_t cut_limit{8u};
+
+  /*! \brief Number of area flow passes after the first one. */
+  uint32_t area_iterations{2u};
+
+  /*! \brief Consider the choices of a class (only representatives otherwise). */
+  bool use_choices{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct choice_mapping_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  double area{0.0};
+  uint32_t num_gates{0u};
+
+  /*! \brief Number of inverters at primary outputs (input inverters are part of the gate areas). */
+  uint32_t num_inverters{0u};
+
+  /*! \brief Number of mapped classes whose cut comes from a choice. */
+  uint32_t num_choice_cuts{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] area = {:.2f}, gates = {} (inverters: {}), cuts from choices = {}\n", area, num_gates, num_inverters, num_choice_cuts );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", to_seconds( time_total ) );
+  }
+};
+
+/*! \brief Areas of cut functions with up to four leaves */
+class genlib_cut_library
+{
+public:
+  explicit genlib_cut_library( std::vector<genlib_gate> const& gates )
+      : cost_( gates, 1.0 )
+  {
+    std::vector<std::array<uint32_t, 4>> permutations;
+    std::array<uint32_t, 4> p{0u, 1u, 2u, 3u};
+    do
+    {
+      permutations.push_back( p );
+    } while ( std::next_permutation( p.begin(), p.end() ) );
+
+    for ( auto const& g : gates )
+    {
+      if ( g.inputs.size() != 4u )
+      {
+        continue;
+      }
+      for ( auto const& perm : permutations )
+      {
+        for ( auto neg = 0u; neg < 16u; ++neg )
+        {
+          uint32_t function{0u};
+          for ( auto m = 0u; m < 16u; ++m )
+          {
+            uint32_t index{0u};
+            for ( auto i = 0u; i < 4u; ++i )
+            {
+              index |= ( ( ( m >> perm[i] ) ^ ( neg >> i ) ) & 1u ) << i;
+            }
+            function |= ( ( g.function >> index ) & 1u ) << m;
+          }
+          auto const area = g.area + __builtin_popcount( neg ) * cost_.inverter();
+          update( static_cast<uint16_t>( function ), area );
+          update( static_cast<uint16_t>( ~function ), area + cost_.inverter() );
+        }
+      }
+    }
+  }
+
+  /*! \brief Area of a cut function over `size` leaves (infinity if there is no match) */
+  double area( uint16_t function, uint32_t size ) const
+  {
+    switch ( size )
+    {
+    case 0u:
+      return 0.0;
+    case 1u:
+      return ( function & 3u ) == 2u ? 0.0 : cost_.inverter();
+    case 2u:
+    case 3u:
+      return cost_.function_area( static_cast<uint8_t>( function ) );
+    default:
+    {
+      auto const it = four_input_.find( function );
+      return it == four_input_.end() ? std::numeric_limits<double>::infinity() : it->second;
+    }
+    }
+  }
+
+  double inverter() const
+  {
+    return cost_.inverter();
+  }
+
+private:
+  void update( uint16_t function, double area )
+  {
+    auto const it = four_input_.find( function );
+    if ( it == four_input_.end() || area < it->second )
+    {
+      four_input_[function] = area;
+    }
+  }
+
+private:
+  xmg_genlib_cost cost_;
+  std::unordered_map<uint16_t, double> four_input_;
+};
+
+namespace detail
+{
+
+class choice_mapping_impl
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  struct cut
+  {
+    std::array<uint32_t, 4> leaves{};
+    uint32_t size{0u};
+    uint16_t function{0u};
+    bool choice{false};
+    double area{0.0};
+    double flow{0.0};
+  };
+
+  choice_mapping_impl( xmg_choice_network const& cntk, genlib_cut_library const& library, choice_mapping_params const& ps, choice_mapping_stats& st )
+      : cntk( cntk ), ntk( cntk.network() ), library( library ), ps( ps ), st( st ),
+        cuts( ntk.size() ), best( ntk.size(), 0u ), flow( ntk.size(), 0.0 ), estimate( ntk.size(), 0.0 ), refs( ntk.size(), 0u )
+  {
+  }
+
+  void run()
+  {
+    stopwatch t( st.time_total );
+
+    compute_order();
+    for ( auto const& r : order )
+    {
+      for ( auto const& c : nodes_of( r ) )
+      {
+        ntk.foreach_fanin( c.first, [&]( auto const& fi ) {
+          estimate[ntk.node_to_index( representative( ntk.get_node( fi ) ) )] += 1.0;
+        } );
+      }
+    }
+
+    for ( auto const& r : order )
+    {
+      enumerate_cuts( r );
+      select( r );
+    }
+    compute_cover();
+
+    for ( auto i = 0u; i < ps.area_iterations; ++i )
+    {
+      for ( auto const& r : order )
+      {
+        estimate[ntk.node_to_index( r )] = std::max<double>( 1.0, refs[ntk.node_to_index( r )] );
+      }
+      for ( auto const& r : order )
+      {
+        select( r );
+      }
+      compute_cover();
+    }
+  }
+
+  /* the cover as k-LUT network, classes are visited in topological order */
+  void build_netlist( klut_network& mapped ) const
+  {
+    std::vector<klut_network::signal> signals( ntk.size() );
+    signals[ntk.node_to_index( ntk.get_node( ntk.get_constant( false ) ) )] = mapped.get_constant( false );
+    ntk.foreach_pi( [&]( auto const& n ) {
+      signals[ntk.node_to_index( n )] = mapped.create_pi();
+    } );
+
+    for ( auto const& r : order )
+    {
+      auto const index = ntk.node_to_index( r );
+      if ( refs[index] == 0u )
+      {
+        continue;
+      }
+
+      auto const& c = cuts[index][best[index]];
+      if ( c.size == 0u )
+      {
+        signals[index] = mapped.get_constant( ( c.function & 1u ) != 0u );
+        continue;
+      }
+
+      std::vector<klut_network::signal> children;
+      for ( auto i = 0u; i < c.size; ++i )
+      {
+        children.push_back( signals[c.leaves[i]] );
+      }
+      /* cut functions are replicated over 4 variables, the node function only has the bits of its fanins */
+      uint64_t const word = c.function & ( ( uint64_t( 1 ) << ( 1u << c.size ) ) - 1u );
+      kitty::dynamic_truth_table function( c.size );
+      kitty::create_from_words( function, &word, &word + 1 );
+      signals[index] = mapped.create_node( children, function );
+    }
+
+    std::unordered_map<uint32_t, klut_network::signal> inverters;
+    ntk.foreach_po( [&]( auto const& f ) {
+      auto const n = ntk.get_node( f );
+      if ( ntk.is_constant( n ) )
+      {
+        mapped.create_po( mapped.get_constant( ntk.is_complemented( f ) ) );
+        return;
+      }
+
+      auto const r = ntk.node_to_index( representative( n ) );
+      bool const phase = ps.use_choices && cntk.is_complemented_choice( n );
+      if ( ntk.is_complemented( f ) == phase )
+      {
+        mapped.create_po( signals[r] );
+        return;
+      }
+      auto it = inverters.find( r );
+      if ( it == inverters.end() )
+      {
+        it = inverters.emplace( r, mapped.create_not( signals[r] ) ).first;
+      }
+      mapped.create_po( it->second );
+    } );
+  }
+
+private:
+  node representative( node const& n ) const
+  {
+    return ps.use_choices ? cntk.get_representative( n ) : n;
+  }
+
+  /* members of the class of r with their phase */
+  std::vector<std::pair<node, bool>> nodes_of( node const& r ) const
+  {
+    std::vector<std::pair<node, bool>> members;
+    if ( !ps.use_choices )
+    {
+      members.emplace_back( r, false );
+      return members;
+    }
+    cntk.foreach_choice( r, [&]( auto const& m, auto complemented ) {
+      if ( !ntk.is_constant( m ) && !ntk.is_pi( m ) )
+      {
+        members.emplace_back( m, complemented );
+      }
+    } );
+    return members;
+  }
+
+  bool is_leaf( node const& n ) const
+  {
+    return ntk.is_constant( n ) || ntk.is_pi( n );
+  }
+
+  /* classes in the transitive fanin of the outputs in topological order */
+  void compute_order()
+  {
+    std::vector<uint8_t> visited( ntk.size(), 0u );
+    std::vector<std::pair<node, bool>> stack;
+    ntk.foreach_po( [&]( auto const& f ) {
+      stack.emplace_back( representative( ntk.get_node( f ) ), false );
+      while ( !stack.empty() )
+      {
+        auto const [n, expanded] = stack.back();
+        stack.pop_back();
+        if ( expanded )
+        {
+          order.push_back( n );
+          continue;
+        }
+        auto const index = ntk.node_to_index( n );
+        if ( visited[index] || is_leaf( n ) )
+        {
+          continue;
+        }
+        visited[index] = 1u;
+        stack.emplace_back( n, true );
+        for ( auto const& m : nodes_of( n ) )
+        {
+          ntk.foreach_fanin( m.first, [&]( auto const& fi ) {
+            stack.emplace_back( representative( ntk.get_node( fi ) ), false );
+          } );
+        }
+      }
+    } );
+  }
+
+  /* cut sets of a fanin class including the trivial cut */
+  std::vector<cut> fanin_cuts( node const& r ) const
+  {
+    std::vector<cut> result;
+    if ( ntk.is_constant( r ) )
+    {
+      result.emplace_back();
+      return result;
+    }
+
+    cut trivial;
+    trivial.leaves[0] = ntk.node_to_index( r );
+    trivial.size = 1u;
+    trivial.function = 0xaaaa;
+    result.push_back( trivial );
+    if ( !is_leaf( r ) )
+    {
+      auto const& cs = cuts[ntk.node_to_index( r )];
+      result.insert( result.end(), cs.begin(), cs.end() );
+    }
+    return result;
+  }
+
+  /* truth table of a cut expanded to the leaves of a superset */
+  static uint16_t expand( cut const& c, cut const& target )
+  {
+    std::array<uint32_t, 4> position{};
+    for ( auto i = 0u; i < c.size; ++i )
+    {
+      position[i] = static_cast<uint32_t>( std::find( target.leaves.begin(), target.leaves.begin() + target.size, c.leaves[i] ) - target.leaves.begin() );
+    }
+
+    uint32_t function{0u};
+    for ( auto m = 0u; m < 16u; ++m )
+    {
+      uint32_t index{0u};
+      for ( auto i = 0u; i < c.size; ++i )
+      {
+        index |= ( ( m >> position[i] ) & 1u ) << i;
+      }
+      function |= ( ( c.function >> index ) & 1u ) << m;
+    }
+    return static_cast<uint16_t>( function );
+  }
+
+  static bool merge_leaves( cut const& a, cut const& b, cut& result, uint32_t cut_size )
+  {
+    std::array<uint32_t, 8> leaves;
+    auto const end = std::set_union( a.leaves.begin(), a.leaves.begin() + a.size, b.leaves.begin(), b.leaves.begin() + b.size, leaves.begin() );
+    auto const size = static_cast<uint32_t>( end - leaves.begin() );
+    if ( size > cut_size )
+    {
+      return false;
+    }
+    std::copy( leaves.begin(), end, result.leaves.begin() );
+    result.size = size;
+    return true;
+  }
+
+  void enumerate_cuts( node const& r )
+  {
+    /* the cut of the fanins must always fit */
+    auto const cut_size = std::clamp( ps.cut_size, 3u, 4u );
+    auto& cs = cuts[ntk.node_to_index( r )];
+
+    for ( auto const& [m, complemented] : nodes_of( r ) )
+    {
+      std::array<std::vector<cut>, 3> fanins;
+      std::array<uint16_t, 3> masks{};
+      ntk.foreach_fanin( m, [&]( auto const& fi, auto i ) {
+        auto const c = ntk.get_node( fi );
+        fanins[i] = fanin_cuts( representative( c ) );
+        bool const phase = ps.use_choices && cntk.is_complemented_choice( c );
+        masks[i] = ( ntk.is_complemented( fi ) != phase ) ? 0xffff : 0x0000;
+      } );
+      uint16_t const output_mask = complemented ? 0xffff : 0x0000;
+
+      for ( auto const& c0 : fanins[0] )
+      {
+        for ( auto const& c1 : fanins[1] )
+        {
+          cut c01;
+          if ( !merge_leaves( c0, c1, c01, cut_size ) )
+          {
+            continue;
+          }
+          for ( auto const& c2 : fanins[2] )
+          {
+            cut c;
+            if ( !merge_leaves( c01, c2, c, cut_size ) )
+            {
+              continue;
+            }
+
+            auto const a = expand( c0, c ) ^ masks[0];
+            auto const b = expand( c1, c ) ^ masks[1];
+            auto const d = expand( c2, c ) ^ masks[2];
+            c.function = ( ntk.is_xor3( m ) ? ( a ^ b ^ d ) : ( ( a & b ) | ( a & d ) | ( b & d ) ) ) ^ output_mask;
+            c.choice = m != r;
+            c.area = library.area( c.function, c.size );
+            if ( c.area == std::numeric_limits<double>::infinity() )
+            {
+              continue;
+            }
+
+            auto const it = std::find_if( cs.begin(), cs.end(), [&]( auto const& other ) {
+              return other.size == c.size && std::equal( other.leaves.begin(), other.leaves.begin() + c.size, c.leaves.begin() );
+            } );
+            if ( it == cs.end() )
+            {
+              cs.push_back( c );
+            }
+            else if ( c.area < it->area )
+            {
+              *it = c;
+            }
+          }
+        }
+      }
+    }
+
+    /* keep the cuts with the best area flow */
+    for ( auto& c : cs )
+    {
+      c.flow = cut_flow( c );
+    }
+    std::stable_sort( cs.begin(), cs.end(), []( auto const& a, auto const& b ) { return a.flow < b.flow; } );
+    if ( cs.size() > ps.cut_limit )
+    {
+      cs.resize( std::max( ps.cut_limit, 1u ) );
+    }
+  }
+
+  double cut_flow( cut const& c ) const
+  {
+    auto result = c.area;
+    for ( auto i = 0u; i < c.size; ++i )
+    {
+      result += flow[c.leaves[i]] / std::max( estimate[c.leaves[i]], 1.0 );
+    }
+    return result;
+  }
+
+  void select( node const& r )
+  {
+    auto const index = ntk.node_to_index( r );
+    auto& cs = cuts[index];
+    best[index] = 0u;
+    for ( auto i = 0u; i < cs.size(); ++i )
+    {
+      cs[i].flow = cut_flow( cs[i] );
+      if ( cs[i].flow < cs[best[index]].flow )
+      {
+        best[index] = i;
+      }
+    }
+    flow[index] = cs.empty() ? 0.0 : cs[best[index]].flow;
+  }
+
+  void compute_cover()
+  {
+    std::fill( refs.begin(), refs.end(), 0u );
+    st.area = 0.0;
+    st.num_gates = 0u;
+    st.num_inverters = 0u;
+    st.num_choice_cuts = 0u;
+
+    std::vector<uint32_t> stack;
+    auto const reference = [&]( uint32_t index ) {
+      if ( refs[index]++ == 0u && !is_leaf( ntk.index_to_node( index ) ) )
+      {
+        stack.push_back( index );
+      }
+    };
+
+    std::vector<uint8_t> inverted( ntk.size(), 0u );
+    ntk.foreach_po( [&]( auto const& f ) {
+      auto const n = ntk.get_node( f );
+      auto const r = ntk.node_to_index( representative( n ) );
+      bool const phase = ps.use_choices && cntk.is_complemented_choice( n );
+      if ( ntk.is_complemented( f ) != phase && !ntk.is_constant( n ) && !inverted[r] )
+      {
+        inverted[r] = 1u;
+        ++st.num_inverters;
+        st.area += library.inverter();
+      }
+      reference( r );
+    } );
+
+    while ( !stack.empty() )
+    {
+      auto const index = stack.back();
+      stack.pop_back();
+
+      auto const& c = cuts[index][best[index]];
+      st.area += c.area;
+      ++st.num_gates;
+      st.num_choice_cuts += c.choice ? 1u : 0u;
+      for ( auto i = 0u; i < c.size; ++i )
+      {
+        reference( c.leaves[i] );
+      }
+    }
+    st.num_gates += st.num_inverters;
+  }
+
+private:
+  xmg_choice_network const& cntk;
+  xmg_network const& ntk;
+  genlib_cut_library const& library;
+  choice_mapping_params const& ps;
+  choice_mapping_stats& st;
+
+  std::vector<node> order;
+  std::vector<std::vector<cut>> cuts;
+  std::vector<uint32_t> best;
+  std::vector<double> flow;
+  std::vector<double> estimate;
+  std::vector<uint32_t> refs;
+};
+
+} /* namespace detail */
+
+/*! \brief Maps an XMG with choices to a genlib library and returns the area
+ *
+ * Only the area of the cover is computed, the overload below also builds
+ * the mapped netlist.  Without computed choices (or with `use_choices`
+ * false) the XMG is mapped as it is.
+ */
+inline double map_with_choices( xmg_choice_network const& ntk, genlib_cut_library const& library, choice_mapping_params const& ps = {}, choice_mapping_stats* pst = nullptr )
+{
+  choice_mapping_stats st;
+  detail::choice_mapping_impl p( ntk, library, ps, st );
+  p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return st.area;
+}
+
+/*! \brief Maps an XMG with choices, returns the area, and stores the cover as k-LUT network in `mapped`
+ *
+ * Every node of `mapped` is a gate of the cover (with the function of its
+ * cut) or an inverter at an output, and the primary inputs and outputs are
+ * in the same order as in the XMG.
+ */
+inline double map_with_choices( xmg_choice_network const& ntk, genlib_cut_library const& library, klut_network& mapped, choice_mapping_params const& ps = {}, choice_mapping_stats* pst = nullptr )
+{
+  choice_mapping_stats st;
+  detail::choice_mapping_impl p( ntk, library, ps, st );
+  p.run();
+  p.build_netlist( mapped );
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return st.area;
+}
+
+} /* namespace mockturtle */
@@ -0,0 +1,723 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_delay_rewriting.hpp
+  \brief Delay-aware cut rewriting with incrementally maintained levels
+
+  Unlike `cut_rewriting`, which only minimizes size, the gain of a
+  replacement combines a node cost (e.g., area), a penalty for gates that are
+  not self-dual, and the change of the arrival level.  Replacements that
+  would violate the required time of the root are rejected.  Arrival levels
+  and required times are kept up to date after every replacement by only
+  visiting the affected transitive fanout (levels) and the new cone
+  (required times).
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/algorithms/cut_enumeration.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/progress_bar.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+namespace mockturtle
+{
+
+/*! \brief Arrival levels and required times that are updated per replacement
+ *
+ * Levels of new nodes are computed when they are registered with
+ * `add_nodes`.  After a node has been substituted, `substitute` moves its
+ * fanouts to the new node and propagates level changes forward until they
+ * vanish.  Required times are only tightened incrementally (never relaxed),
+ * which keeps them safe but possibly pessimistic until `update` is called.
+ */
+class incremental_depth
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  explicit incremental_depth( xmg_network const& ntk, uint32_t required_depth = 0u )
+      : ntk_( ntk ), required_depth_( required_depth )
+  {
+    update();
+  }
+
+  /*! \brief Recomputes all levels, fanouts, and required times from scratch */
+  void update()
+  {
+    levels_.assign( ntk_.size(), 0u );
+    fanouts_.assign( ntk_.size(), {} );
+    compute_topological_order();
+    for ( auto const& n : topo_order_ )
+    {
+      compute_level( n );
+      ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+        fanouts_[ntk_.node_to_index( ntk_.get_node( fi ) )].push_back( n );
+      } );
+    }
+
+    depth_ = 0u;
+    ntk_.foreach_po( [&]( auto const& f ) {
+      depth_ = std::max( depth_, level( ntk_.get_node( f ) ) );
+    } );
+    if ( required_depth_ == 0u )
+    {
+      required_depth_ = depth_;
+    }
+
+    compute_required();
+  }
+
+  uint32_t level( node const& n ) const
+  {
+    return levels_[ntk_.node_to_index( n )];
+  }
+
+  uint32_t required( node const& n ) const
+  {
+    return required_[ntk_.node_to_index( n )];
+  }
+
+  int32_t slack( node const& n ) const
+  {
+    return static_cast<int32_t>( required( n ) ) - static_cast<int32_t>( level( n ) );
+  }
+
+  uint32_t depth() const
+  {
+    return depth_;
+  }
+
+  uint32_t required_depth() const
+  {
+    return required_depth_;
+  }
+
+  /*! \brief Registers all nodes with index at least `first_index` that have been created since
+   *
+   * Nodes that have already been registered by an earlier call are skipped,
+   * such that calling it once per candidate adds every fanout only once.
+   */
+  void add_nodes( uint32_t first_index )
+  {
+    auto const size = ntk_.size();
+    auto const num_registered = static_cast<uint32_t>( levels_.size() );
+    if ( size <= num_registered )
+    {
+      return;
+    }
+
+    levels_.resize( size, 0u );
+    required_.resize( size, std::numeric_limits<uint32_t>::max() );
+    fanouts_.resize( size );
+    for ( auto index = std::max( first_index, num_registered ); index < size; ++index )
+    {
+      auto const n = ntk_.index_to_node( index );
+      if ( ntk_.is_constant( n ) || ntk_.is_pi( n ) )
+      {
+        continue;
+      }
+      compute_level( n );
+      ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+        fanouts_[ntk_.node_to_index( ntk_.get_node( fi ) )].push_back( n );
+      } );
+    }
+  }
+
+  /*! \brief Updates the data after `old_node` has been substituted by `new_signal`
+   *
+   * Must be called after `ntk.substitute_node( old_node, new_signal )` and
+   * after all nodes of the new cone have been registered with `add_nodes`.
+   */
+  void substitute( node const& old_node, signal const& new_signal )
+  {
+    auto const new_node = ntk_.get_node( new_signal );
+    auto const old_index = ntk_.node_to_index( old_node );
+    auto const new_index = ntk_.node_to_index( new_node );
+
+    /* tighten required times in the new cone */
+    tighten_required( new_node, required_[old_index] );
+
+    /* move fanouts and propagate levels */
+    std::vector<node> worklist;
+    for ( auto const& p : fanouts_[old_index] )
+    {
+      fanouts_[new_index].push_back( p );
+      worklist.push_back( p );
+    }
+    fanouts_[old_index].clear();
+    propagate_levels( worklist );
+
+    /* the depth can only grow through the new node */
+    ntk_.foreach_po( [&]( auto const& f ) {
+      if ( ntk_.get_node( f ) == new_node )
+      {
+        depth_ = std::max( depth_, level( new_node ) );
+      }
+    } );
+  }
+
+private:
+  void compute_level( node const& n )
+  {
+    uint32_t level{0u};
+    ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+      level = std::max( level, levels_[ntk_.node_to_index( ntk_.get_node( fi ) )] );
+    } );
+    levels_[ntk_.node_to_index( n )] = level + 1u;
+  }
+
+  /* storage order is not topological after in-place substitutions */
+  void compute_topological_order()
+  {
+    topo_order_.clear();
+    std::vector<uint8_t> visited( ntk_.size(), 0u );
+    std::vector<std::pair<node, bool>> stack;
+    ntk_.foreach_gate( [&]( auto const& g ) {
+      stack.emplace_back( g, false );
+      while ( !stack.empty() )
+      {
+        auto const [n, expanded] = stack.back();
+        stack.pop_back();
+        auto const index = ntk_.node_to_index( n );
+        if ( expanded )
+        {
+          topo_order_.push_back( n );
+          continue;
+        }
+        if ( visited[index] || ntk_.is_constant( n ) || ntk_.is_pi( n ) )
+        {
+          continue;
+        }
+        visited[index] = 1u;
+        stack.emplace_back( n, true );
+        ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+          if ( !visited[ntk_.node_to_index( ntk_.get_node( fi ) )] )
+          {
+            stack.emplace_back( ntk_.get_node( fi ), false );
+          }
+        } );
+      }
+    } );
+  }
+
+  void compute_required()
+  {
+    required_.assign( ntk_.size(), std::numeric_limits<uint32_t>::max() );
+    ntk_.foreach_po( [&]( auto const& f ) {
+      required_[ntk_.node_to_index( ntk_.get_node( f ) )] = required_depth_;
+    } );
+
+    for ( auto it = topo_order_.rbegin(); it != topo_order_.rend(); ++it )
+    {
+      auto const n = *it;
+      auto const r = required_[ntk_.node_to_index( n )];
+      if ( r == std::numeric_limits<uint32_t>::max() || r == 0u )
+      {
+        continue;
+      }
+      ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+        auto& rf = required_[ntk_.node_to_index( ntk_.get_node( fi ) )];
+        rf = std::min( rf, r - 1u );
+      } );
+    }
+  }
+
+  void tighten_required( node const& root, uint32_t required )
+  {
+    std::vector<std::pair<node, uint32_t>> stack{{root, required}};
+    while ( !stack.empty() )
+    {
+      auto const [n, r] = stack.back();
+      stack.pop_back();
+
+      auto& rn = required_[ntk_.node_to_index( n )];
+      if ( r >= rn )
+      {
+        continue;
+      }
+      rn = r;
+      if ( r == 0u )
+      {
+        continue;
+      }
+      ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+        stack.emplace_back( ntk_.get_node( fi ), r - 1u );
+      } );
+    }
+  }
+
+  void propagate_levels( std::vector<node>& worklist )
+  {
+    while ( !worklist.empty() )
+    {
+      auto const n = worklist.back();
+      worklist.pop_back();
+      if ( ntk_.fanout_size( n ) == 0u )
+      {
+        continue;
+      }
+
+      auto const index = ntk_.node_to_index( n );
+      auto const before = levels_[index];
+      compute_level( n );
+      if ( levels_[index] == before )
+      {
+        continue;
+      }
+      for ( auto const& p : fanouts_[index] )
+      {
+        worklist.push_back( p );
+      }
+    }
+  }
+
+private:
+  xmg_network const& ntk_;
+  uint32_t required_depth_;
+  uint32_t depth_{0u};
+  std::vector<uint32_t> levels_;
+  std::vector<uint32_t> required_;
+  std::vector<std::vector<node>> fanouts_;
+  std::vector<node> topo_order_;
+};
+
+struct xmg_delay_rewriting_params
+{
+  xmg_delay_rewriting_params()
+  {
+    cut_enumeration_ps.cut_size = 4;
+    cut_enumeration_ps.cut_limit = 8;
+  }
+
+  /*! \brief Cut enumeration parameters. */
+  cut_enumeration_params cut_enumeration_ps{};
+
+  /*! \brief Required depth (0 keeps the initial depth). */
+  uint32_t required_depth{0u};
+
+  /*! \brief Cost added for every gate that is not self-dual (MAJ/XOR3 with a constant fanin). */
+  double non_self_dual_weight{1.0};
+
+  /*! \brief Weight of the node cost function (e.g., unit cost or genlib area). */
+  double area_weight{1.0};
+
+  /*! \brief Weight of every level by which the arrival level of the root decreases. */
+  double level_weight{0.5};
+
+  /*! \brief Accept replacements with zero gain. */
+  bool allow_zero_gain{false};
+
+  /*! \brief Show progress. */
+  bool progress{false};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct xmg_delay_rewriting_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime for cut enumeration. */
+  stopwatch<>::duration time_cuts{0};
+
+  /*! \brief Runtime for updating levels and required times. */
+  stopwatch<>::duration time_depth{0};
+
+  uint32_t num_replacements{0u};
+  uint32_t num_rejected_by_timing{0u};
+  uint32_t depth_before{0u};
+  uint32_t depth_after{0u};
+  double total_gain{0.0};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] replacements = {} (rejected by timing: {}), gain = {:.2f}\n", num_replacements, num_rejected_by_timing, total_gain );
+    std::cout << fmt::format( "[i] depth        = {} -> {}\n", depth_before, depth_after );
+    std::cout << fmt::format( "[i] total time   = {:>5.2f} secs (cuts: {:>5.2f} secs, depth: {:>5.2f} secs)\n", to_seconds( time_total ), to_seconds( time_cuts ), to_seconds( time_depth ) );
+  }
+};
+
+/*! \brief Unit cost for every gate */
+struct xmg_unit_cost
+{
+  uint32_t operator()( xmg_network const& ntk, xmg_network::node const& n ) const
+  {
+    (void)ntk;
+    (void)n;
+    return 1u;
+  }
+};
+
+namespace detail
+{
+
+template<class RewritingFn, class NodeCostFn>
+class xmg_delay_rewriting_impl
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  xmg_delay_rewriting_impl( xmg_network& ntk, RewritingFn& rewriting_fn, xmg_delay_rewriting_params const& ps, xmg_delay_rewriting_stats& st, NodeCostFn const& cost_fn )
+      : ntk( ntk ), rewriting_fn( rewriting_fn ), ps( ps ), st( st ), cost_fn( cost_fn )
+  {
+  }
+
+  void run()
+  {
+    stopwatch t( st.time_total );
+
+    incremental_depth depth( ntk, ps.required_depth );
+    st.depth_before = depth.depth();
+    init_references();
+
+    auto const cuts = call_with_stopwatch( st.time_cuts, [&]() {
+      return cut_enumeration<xmg_network, true>( ntk, ps.cut_enumeration_ps );
+    } );
+
+    /* only nodes of the initial network are visited */
+    std::vector<node> gates;
+    ntk.foreach_gate( [&]( auto const& n ) {
+      gates.push_back( n );
+    } );
+
+    progress_bar pbar{static_cast<uint32_t>( gates.size() ), "delay rewriting |{0}| node = {1:>4} / " + std::to_string( gates.size() ) + "   replacements = {2}", ps.progress};
+    for ( auto i = 0u; i < gates.size(); ++i )
+    {
+      auto const n = gates[i];
+      pbar( i, i, st.num_replacements );
+
+      if ( live_references( n ) == 0u )
+      {
+        continue;
+      }
+
+      signal best_signal{};
+      double best_gain{-1.0};
+      bool has_best{false};
+
+      for ( auto const& cut : cuts.cuts( ntk.node_to_index( n ) ) )
+      {
+        /* skip trivial cuts and cuts with nodes that have been removed */
+        if ( cut->size() < 2u )
+        {
+          continue;
+        }
+
+        std::vector<signal> leaves;
+        bool valid{true};
+        for ( auto const leaf : *cut )
+        {
+          auto const l = ntk.index_to_node( leaf );
+          valid &= ntk.is_constant( l ) || ntk.is_pi( l ) || live_references( l ) > 0u;
+          leaves.push_back( ntk.make_signal( l ) );
+        }
+        if ( !valid )
+        {
+          continue;
+        }
+
+        auto const mffc_cost = dereferenced_cost( n, leaves );
+
+        auto const first_new = ntk.size();
+        rewriting_fn( ntk, cuts.truth_table( *cut ), leaves.begin(), leaves.end(), [&]( auto const& candidate ) {
+          auto const c = ntk.get_node( candidate );
+          if ( c == n )
+          {
+            return true;
+          }
+
+          call_with_stopwatch( st.time_depth, [&]() { depth.add_nodes( first_new ); } );
+          register_new_nodes();
+          if ( depth.level( c ) > depth.required( n ) )
+          {
+            ++st.num_rejected_by_timing;
+            return true;
+          }
+
+          auto const gain = mffc_cost - referenced_cost( c, leaves ) +
+                            ps.level_weight * ( static_cast<double>( depth.level( n ) ) - depth.level( c ) );
+          if ( gain > best_gain )
+          {
+            best_gain = gain;
+            best_signal = candidate;
+            has_best = true;
+          }
+          return true;
+        } );
+      }
+
+      if ( !has_best || best_gain < 0.0 || ( best_gain == 0.0 && !ps.allow_zero_gain ) )
+      {
+        continue;
+      }
+
+      register_new_nodes();
+      adopt( ntk.get_node( best_signal ) );
+      ntk.substitute_node( n, best_signal );
+      call_with_stopwatch( st.time_depth, [&]() { depth.substitute( n, best_signal ); } );
+      ++st.num_replacements;
+      st.total_gain += best_gain;
+    }
+
+    call_with_stopwatch( st.time_depth, [&]() { depth.update(); } );
+    st.depth_after = depth.depth();
+  }
+
+private:
+  double node_cost( node const& n ) const
+  {
+    bool has_constant{false};
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      has_constant |= ntk.is_constant( ntk.get_node( fi ) );
+    } );
+    return ps.area_weight * cost_fn( ntk, n ) + ( has_constant ? ps.non_self_dual_weight : 0.0 );
+  }
+
+  bool is_leaf( node const& n, std::vector<signal> const& leaves ) const
+  {
+    return ntk.is_constant( n ) || ntk.is_pi( n ) ||
+           std::find_if( leaves.begin(), leaves.end(), [&]( auto const& l ) { return ntk.get_node( l ) == n; } ) != leaves.end();
+  }
+
+  /* fanouts from live gates and outputs: `fanout_size` also counts the fanouts
+     from candidates, which stay dangling unless they are adopted */
+  uint32_t live_references( node const& n ) const
+  {
+    auto const index = ntk.node_to_index( n );
+    if ( ntk.is_dead( n ) || index >= dangling.size() || dangling[index] )
+    {
+      return 0u;
+    }
+    auto const fanouts = ntk.fanout_size( n );
+    return fanouts > dangling_refs[index] ? fanouts - dangling_refs[index] : 0u;
+  }
+
+  /* marks the nodes that do not reach an output as dangling */
+  void init_references()
+  {
+    dangling.assign( ntk.size(), true );
+    dangling_refs.assign( ntk.size(), 0u );
+    ntk.foreach_node( [&]( auto const& n ) {
+      if ( ntk.is_constant( n ) || ntk.is_pi( n ) )
+      {
+        dangling[ntk.node_to_index( n )] = false;
+      }
+    } );
+
+    std::vector<node> stack;
+    ntk.foreach_po( [&]( auto const& f ) {
+      stack.push_back( ntk.get_node( f ) );
+    } );
+    while ( !stack.empty() )
+    {
+      auto const n = stack.back();
+      stack.pop_back();
+      if ( !dangling[ntk.node_to_index( n )] )
+      {
+        continue;
+      }
+      dangling[ntk.node_to_index( n )] = false;
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        stack.push_back( ntk.get_node( fi ) );
+      } );
+    }
+
+    ntk.foreach_gate( [&]( auto const& n ) {
+      if ( dangling[ntk.node_to_index( n )] )
+      {
+        ntk.foreach_fanin( n, [&]( auto const& fi ) {
+          ++dangling_refs[ntk.node_to_index( ntk.get_node( fi ) )];
+        } );
+      }
+    } );
+  }
+
+  /* new nodes are candidates and have no live references until they are adopted */
+  void register_new_nodes()
+  {
+    auto const first = dangling.size();
+    dangling.resize( ntk.size(), true );
+    dangling_refs.resize( ntk.size(), 0u );
+    for ( auto i = first; i < ntk.size(); ++i )
+    {
+      ntk.foreach_fanin( ntk.index_to_node( static_cast<uint32_t>( i ) ), [&]( auto const& fi ) {
+        ++dangling_refs[ntk.node_to_index( ntk.get_node( fi ) )];
+      } );
+    }
+  }
+
+  /* makes the dangling nodes in the cone of `root` live */
+  void adopt( node const& root )
+  {
+    std::vector<node> stack{root};
+    while ( !stack.empty() )
+    {
+      auto const n = stack.back();
+      stack.pop_back();
+      if ( !dangling[ntk.node_to_index( n )] )
+      {
+        continue;
+      }
+      dangling[ntk.node_to_index( n )] = false;
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        --dangling_refs[ntk.node_to_index( ntk.get_node( fi ) )];
+        stack.push_back( ntk.get_node( fi ) );
+      } );
+    }
+  }
+
+  uint32_t references( node const& n ) const
+  {
+    auto const it = refs.find( n );
+    return it == refs.end() ? live_references( n ) : it->second;
+  }
+
+  /* cost of the MFFC of `root` bounded by `leaves` */
+  double dereferenced_cost( node const& root, std::vector<signal> const& leaves )
+  {
+    refs.clear();
+    double cost = node_cost( root );
+    std::vector<node> stack{root};
+    while ( !stack.empty() )
+    {
+      auto const n = stack.back();
+      stack.pop_back();
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        auto const c = ntk.get_node( fi );
+        if ( is_leaf( c, leaves ) )
+        {
+          return;
+        }
+        auto const r = references( c ) - 1u;
+        refs[c] = r;
+        if ( r == 0u )
+        {
+          cost += node_cost( c );
+          stack.push_back( c );
+        }
+      } );
+    }
+    return cost;
+  }
+
+  /* cost of the nodes in the cone of `root` that are not referenced after dereferencing the MFFC */
+  double referenced_cost( node const& root, std::vector<signal> const& leaves )
+  {
+    auto const saved = refs;
+    double cost{0.0};
+    if ( !is_leaf( root, leaves ) && references( root ) == 0u )
+    {
+      cost += node_cost( root );
+      std::vector<node> stack{root};
+      while ( !stack.empty() )
+      {
+        auto const n = stack.back();
+        stack.pop_back();
+        ntk.foreach_fanin( n, [&]( auto const& fi ) {
+          auto const c = ntk.get_node( fi );
+          if ( is_leaf( c, leaves ) )
+          {
+            return;
+          }
+          auto const r = references( c );
+          refs[c] = r + 1u;
+          if ( r == 0u )
+          {
+            cost += node_cost( c );
+            stack.push_back( c );
+          }
+        } );
+      }
+    }
+    refs = saved;
+    return cost;
+  }
+
+private:
+  xmg_network& ntk;
+  RewritingFn& rewriting_fn;
+  xmg_delay_rewriting_params const& ps;
+  xmg_delay_rewriting_stats& st;
+  NodeCostFn const& cost_fn;
+
+  /* nodes that do not reach an output, and fanouts of every node from such nodes */
+  std::vector<bool> dangling;
+  std::vector<uint32_t> dangling_refs;
+
+  /* reference counts changed while evaluating one cut */
+  std::unordered_map<node, uint32_t> refs;
+};
+
+} /* namespace detail */
+
+/*! \brief Delay-aware cut rewriting for XMGs
+ *
+ * The interface of `rewriting_fn` is the same as for `cut_rewriting` (e.g.,
+ * `xmg3_npn_resynthesis`), and `cost_fn` is a node cost function such as
+ * `xmg_unit_cost`.  For every gate, all candidates of all cuts are created in
+ * the network; a candidate is feasible if its arrival level does not exceed
+ * the required time of the gate, and the feasible candidate with the largest
+ * gain
+ *
+ *   area_weight * (cost(MFFC) - cost(new nodes))
+ *   + non_self_dual_weight * (#non-self-dual(MFFC) - #non-self-dual(new nodes))
+ *   + level_weight * (level(gate) - level(candidate))
+ *
+ * replaces the gate.  Rejected candidates remain dangling in the network, so
+ * call `cleanup_dangling` afterwards.
+ */
+template<class RewritingFn, class NodeCostFn = xmg_unit_cost>
+void xmg_delay_rewriting( xmg_network& ntk, RewritingFn&& rewriting_fn, xmg_delay_rewriting_params const& ps = {}, xmg_delay_rewriting_stats* pst = nullptr, NodeCostFn const& cost_fn = {} )
+{
+  xmg_delay_rewriting_stats st;
+  detail::xmg_delay_rewriting_impl<RewritingFn, NodeCostFn> p( ntk, rewriting_fn, ps, st, cost_fn );
+  p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+}
+
+} /* namespace mockturtle */
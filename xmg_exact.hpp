@@ -0,0 +1,854 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_exact.hpp
+  \brief SAT-based exact synthesis of minimum self-dual XMGs
+
+  `exact_xmg_synthesis` finds an XMG with the minimum number of MAJ3/XOR3
+  gates for a small function.  Self-dual functions are realized without
+  constant fanins, i.e., with self-dual gates only; for other functions the
+  number of gates with a constant fanin (AND/OR/XOR2) is minimized in a second
+  step.  One solver instance is used per function, gates are added
+  incrementally, and the output constraint for every gate count is guarded by
+  an activation literal.
+
+  `exact_xmg_cache` stores solutions of NPN representatives in a text file
+  that can be shared between runs and experiments.  `exact_xmg_resynthesis`
+  has the interface of a resynthesis function for `cut_rewriting` and
+  `node_resynthesis`.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <bill/sat/solver.hpp>
+#include <fmt/format.h>
+#include <kitty/kitty.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+namespace mockturtle
+{
+
+/*! \brief A chain of MAJ3/XOR3 steps
+ *
+ * Fanins and the output are literals `2 * node + complement`, where node 0 is
+ * the constant 0, nodes 1 to `num_inputs` are the inputs, and the following
+ * nodes are the steps.
+ */
+struct xmg_chain
+{
+  struct step
+  {
+    bool is_xor3{false};
+    std::array<uint32_t, 3> fanins{};
+  };
+
+  uint32_t num_inputs{0u};
+  std::vector<step> steps;
+  uint32_t output{0u};
+
+  uint32_t num_gates() const
+  {
+    return static_cast<uint32_t>( steps.size() );
+  }
+
+  /*! \brief Number of steps with a constant fanin */
+  uint32_t num_non_self_dual() const
+  {
+    uint32_t count{0u};
+    for ( auto const& s : steps )
+    {
+      count += ( s.fanins[0] >> 1 ) == 0u ? 1u : 0u;
+    }
+    return count;
+  }
+
+  kitty::dynamic_truth_table simulate() const
+  {
+    std::vector<kitty::dynamic_truth_table> values( 1u + num_inputs + steps.size(), kitty::dynamic_truth_table( num_inputs ) );
+    for ( auto i = 0u; i < num_inputs; ++i )
+    {
+      kitty::create_nth_var( values[1u + i], i );
+    }
+    auto const literal = [&]( uint32_t l ) {
+      return ( l & 1 ) ? ~values[l >> 1] : values[l >> 1];
+    };
+    for ( auto i = 0u; i < steps.size(); ++i )
+    {
+      auto const& s = steps[i];
+      auto const a = literal( s.fanins[0] ), b = literal( s.fanins[1] ), c = literal( s.fanins[2] );
+      values[1u + num_inputs + i] = s.is_xor3 ? a ^ b ^ c : kitty::ternary_majority( a, b, c );
+    }
+    return literal( output );
+  }
+
+  template<class Ntk>
+  signal<Ntk> instantiate( Ntk& ntk, std::vector<signal<Ntk>> const& inputs ) const
+  {
+    std::vector<signal<Ntk>> nodes( 1u, ntk.get_constant( false ) );
+    nodes.insert( nodes.end(), inputs.begin(), inputs.begin() + num_inputs );
+    auto const literal = [&]( uint32_t l ) {
+      return ( l & 1 ) ? ntk.create_not( nodes[l >> 1] ) : nodes[l >> 1];
+    };
+    for ( auto const& s : steps )
+    {
+      auto const a = literal( s.fanins[0] ), b = literal( s.fanins[1] ), c = literal( s.fanins[2] );
+      nodes.push_back( s.is_xor3 ? ntk.create_xor3( a, b, c ) : ntk.create_maj( a, b, c ) );
+    }
+    return literal( output );
+  }
+
+  /*! \brief Serializes as `<output> <M|X><a>,<b>,<c> ...` */
+  std::string to_string() const
+  {
+    std::string s = std::to_string( output );
+    for ( auto const& st : steps )
+    {
+      s += fmt::format( " {}{},{},{}", st.is_xor3 ? 'X' : 'M', st.fanins[0], st.fanins[1], st.fanins[2] );
+    }
+    return s;
+  }
+
+  static std::optional<xmg_chain> from_string( uint32_t num_inputs, std::string const& s )
+  {
+    xmg_chain chain;
+    chain.num_inputs = num_inputs;
+
+    std::istringstream in( s );
+    if ( !( in >> chain.output ) )
+    {
+      return std::nullopt;
+    }
+    std::string token;
+    while ( in >> token )
+    {
+      step st;
+      char type{};
+      char comma1{}, comma2{};
+      std::istringstream ts( token );
+      if ( !( ts >> type >> st.fanins[0] >> comma1 >> st.fanins[1] >> comma2 >> st.fanins[2] ) || ( type != 'M' && type != 'X' ) )
+      {
+        return std::nullopt;
+      }
+      st.is_xor3 = type == 'X';
+      chain.steps.push_back( st );
+    }
+    return chain;
+  }
+};
+
+struct exact_xmg_params
+{
+  /*! \brief Maximum number of gates. */
+  uint32_t max_gates{7u};
+
+  /*! \brief Conflict limit per SAT call (0 means no limit). */
+  uint32_t conflict_limit{0u};
+
+  /*! \brief Minimize gates with constant fanins after minimizing the gate count (only for functions that are not self-dual). */
+  bool minimize_non_self_dual{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct exact_xmg_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime of SAT calls. */
+  stopwatch<>::duration time_sat{0};
+
+  /*! \brief Runtime for NPN canonization. */
+  stopwatch<>::duration time_npn{0};
+
+  uint32_t num_sat_calls{0u};
+  uint32_t num_solved{0u};
+  uint32_t num_failed{0u};
+  uint32_t num_cache_hits{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] solved = {}, failed = {}, cache hits = {}, SAT calls = {}\n", num_solved, num_failed, num_cache_hits, num_sat_calls );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs (SAT: {:>5.2f} secs, NPN: {:>5.2f} secs)\n", to_seconds( time_total ), to_seconds( time_sat ), to_seconds( time_npn ) );
+  }
+};
+
+namespace detail
+{
+
+class exact_xmg_impl
+{
+public:
+  using solver_t = bill::solver<bill::solvers::ghack>;
+
+  exact_xmg_impl( kitty::dynamic_truth_table const& function, exact_xmg_params const& ps, exact_xmg_stats& st )
+      : function( function ), ps( ps ), st( st ),
+        num_inputs( function.num_vars() ), num_rows( uint32_t( 1 ) << function.num_vars() ),
+        allow_constants( !kitty::is_selfdual( function ) )
+  {
+  }
+
+  std::optional<xmg_chain> run()
+  {
+    if ( auto trivial = trivial_chain() )
+    {
+      return trivial;
+    }
+
+    for ( auto k = 1u; k <= ps.max_gates; ++k )
+    {
+      add_gate();
+
+      auto const activation = add_output_constraint();
+      auto const result = solve( {activation} );
+      if ( result == bill::result::states::undefined )
+      {
+        return std::nullopt;
+      }
+      if ( result == bill::result::states::unsatisfiable )
+      {
+        solver.add_clause( ~activation );
+        continue;
+      }
+
+      auto chain = extract_chain();
+      if ( allow_constants && ps.minimize_non_self_dual )
+      {
+        minimize_constants( activation, chain );
+      }
+      if ( chain.simulate() != function )
+      {
+        return std::nullopt;
+      }
+      return chain;
+    }
+
+    return std::nullopt;
+  }
+
+private:
+  struct gate_vars
+  {
+    bill::var_type is_xor3;
+    std::array<std::vector<bill::var_type>, 3> select; /* indexed by node - first_candidate */
+    std::array<bill::var_type, 3> polarity;
+    std::array<std::vector<bill::var_type>, 3> value;  /* indexed by row */
+    std::vector<bill::var_type> output;                /* indexed by row */
+  };
+
+  static bill::lit_type pos( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::positive );
+  }
+
+  static bill::lit_type neg( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::negative );
+  }
+
+  static bill::lit_type lit( bill::var_type v, bool value )
+  {
+    return value ? pos( v ) : neg( v );
+  }
+
+  bool model_value( bill::var_type v ) const
+  {
+    return model[v] == bill::lbool_type::true_;
+  }
+
+  std::optional<xmg_chain> trivial_chain() const
+  {
+    xmg_chain chain;
+    chain.num_inputs = num_inputs;
+
+    if ( kitty::is_const0( function ) || kitty::is_const0( ~function ) )
+    {
+      chain.output = kitty::is_const0( function ) ? 0u : 1u;
+      return chain;
+    }
+    for ( auto i = 0u; i < num_inputs; ++i )
+    {
+      kitty::dynamic_truth_table var( num_inputs );
+      kitty::create_nth_var( var, i );
+      if ( function == var || function == ~var )
+      {
+        chain.output = 2u * ( i + 1u ) + ( function == var ? 0u : 1u );
+        return chain;
+      }
+    }
+    return std::nullopt;
+  }
+
+  uint32_t first_candidate() const
+  {
+    return allow_constants ? 0u : 1u;
+  }
+
+  void add_gate()
+  {
+    auto const index = static_cast<uint32_t>( gates.size() );
+    auto const num_candidates = 1u + num_inputs + index - first_candidate();
+
+    gate_vars g;
+    g.is_xor3 = solver.add_variable();
+    for ( auto s = 0u; s < 3u; ++s )
+    {
+      g.polarity[s] = solver.add_variable();
+      for ( auto j = 0u; j < num_candidates; ++j )
+      {
+        g.select[s].push_back( solver.add_variable() );
+      }
+      for ( auto t = 0u; t < num_rows; ++t )
+      {
+        g.value[s].push_back( solver.add_variable() );
+      }
+    }
+    for ( auto t = 0u; t < num_rows; ++t )
+    {
+      g.output.push_back( solver.add_variable() );
+    }
+
+    /* exactly one fanin per slot, fanins are ordered */
+    for ( auto s = 0u; s < 3u; ++s )
+    {
+      std::vector<bill::lit_type> at_least_one;
+      for ( auto j = 0u; j < num_candidates; ++j )
+      {
+        at_least_one.push_back( pos( g.select[s][j] ) );
+        for ( auto j2 = j + 1u; j2 < num_candidates; ++j2 )
+        {
+          solver.add_clause( {neg( g.select[s][j] ), neg( g.select[s][j2] )} );
+        }
+      }
+      solver.add_clause( at_least_one );
+    }
+    for ( auto s = 0u; s < 2u; ++s )
+    {
+      for ( auto j = 0u; j < num_candidates; ++j )
+      {
+        for ( auto j2 = 0u; j2 <= j; ++j2 )
+        {
+          solver.add_clause( {neg( g.select[s][j] ), neg( g.select[s + 1u][j2] )} );
+        }
+      }
+    }
+
+    /* symmetry breaking: complemented fanins of XOR3 can be moved to the output,
+       and MAJ3 needs at most one complemented fanin due to self-duality */
+    for ( auto s = 0u; s < 3u; ++s )
+    {
+      solver.add_clause( {neg( g.is_xor3 ), neg( g.polarity[s] )} );
+      for ( auto s2 = s + 1u; s2 < 3u; ++s2 )
+      {
+        solver.add_clause( {pos( g.is_xor3 ), neg( g.polarity[s] ), neg( g.polarity[s2] )} );
+      }
+    }
+
+    for ( auto t = 0u; t < num_rows; ++t )
+    {
+      /* slot values */
+      for ( auto s = 0u; s < 3u; ++s )
+      {
+        auto const v = g.value[s][t];
+        auto const p = g.polarity[s];
+        for ( auto j = 0u; j < num_candidates; ++j )
+        {
+          auto const node = j + first_candidate();
+          auto const sel = neg( g.select[s][j] );
+          if ( node <= num_inputs )
+          {
+            bool const c = node == 0u ? false : ( ( t >> ( node - 1u ) ) & 1 );
+            solver.add_clause( {sel, neg( v ), lit( p, !c )} );
+            solver.add_clause( {sel, pos( v ), lit( p, c )} );
+          }
+          else
+          {
+            auto const x = gates[node - num_inputs - 1u].output[t];
+            solver.add_clause( {sel, neg( v ), pos( x ), pos( p )} );
+            solver.add_clause( {sel, neg( v ), neg( x ), neg( p )} );
+            solver.add_clause( {sel, pos( v ), neg( x ), pos( p )} );
+            solver.add_clause( {sel, pos( v ), pos( x ), neg( p )} );
+          }
+        }
+      }
+
+      /* gate function */
+      auto const a = g.value[0][t], b = g.value[1][t], c = g.value[2][t], x = g.output[t];
+      solver.add_clause( {pos( g.is_xor3 ), neg( a ), neg( b ), pos( x )} );
+      solver.add_clause( {pos( g.is_xor3 ), neg( a ), neg( c ), pos( x )} );
+      solver.add_clause( {pos( g.is_xor3 ), neg( b ), neg( c ), pos( x )} );
+      solver.add_clause( {pos( g.is_xor3 ), pos( a ), pos( b ), neg( x )} );
+      solver.add_clause( {pos( g.is_xor3 ), pos( a ), pos( c ), neg( x )} );
+      solver.add_clause( {pos( g.is_xor3 ), pos( b ), pos( c ), neg( x )} );
+      for ( auto m = 0u; m < 8u; ++m )
+      {
+        bool const va = m & 1, vb = ( m >> 1 ) & 1, vc = ( m >> 2 ) & 1;
+        solver.add_clause( {neg( g.is_xor3 ), lit( a, !va ), lit( b, !vb ), lit( c, !vc ), lit( x, va ^ vb ^ vc )} );
+      }
+    }
+
+    gates.push_back( g );
+  }
+
+  /* the last gate (possibly complemented) realizes the function if the returned literal is assumed */
+  bill::lit_type add_output_constraint()
+  {
+    auto const activation = solver.add_variable();
+    auto const polarity = solver.add_variable();
+    output_polarity = polarity;
+
+    auto const& out = gates.back().output;
+    for ( auto t = 0u; t < num_rows; ++t )
+    {
+      bool const f = kitty::get_bit( function, t );
+      solver.add_clause( {neg( activation ), lit( out[t], f ), pos( polarity )} );
+      solver.add_clause( {neg( activation ), lit( out[t], !f ), neg( polarity )} );
+    }
+    return pos( activation );
+  }
+
+  /* at most `bound` gates use the constant (which can only be selected in slot 0) */
+  bill::lit_type add_cardinality_constraint( uint32_t bound )
+  {
+    auto const activation = solver.add_variable();
+    auto const guard = neg( activation );
+
+    std::vector<bill::lit_type> xs;
+    for ( auto const& g : gates )
+    {
+      xs.push_back( pos( g.select[0][0] ) );
+    }
+
+    if ( bound == 0u )
+    {
+      for ( auto const& x : xs )
+      {
+        solver.add_clause( {guard, ~x} );
+      }
+      return pos( activation );
+    }
+
+    /* sequential counter */
+    std::vector<std::vector<bill::var_type>> s( xs.size(), std::vector<bill::var_type>( bound ) );
+    for ( auto& row : s )
+    {
+      for ( auto& v : row )
+      {
+        v = solver.add_variable();
+      }
+    }
+    solver.add_clause( {guard, ~xs[0], pos( s[0][0] )} );
+    for ( auto j = 1u; j < bound; ++j )
+    {
+      solver.add_clause( {guard, neg( s[0][j] )} );
+    }
+    for ( auto i = 1u; i < xs.size(); ++i )
+    {
+      solver.add_clause( {guard, ~xs[i], pos( s[i][0] )} );
+      solver.add_clause( {guard, neg( s[i - 1u][0] ), pos( s[i][0] )} );
+      for ( auto j = 1u; j < bound; ++j )
+      {
+        solver.add_clause( {guard, ~xs[i], neg( s[i - 1u][j - 1u] ), pos( s[i][j] )} );
+        solver.add_clause( {guard, neg( s[i - 1u][j] ), pos( s[i][j] )} );
+      }
+      solver.add_clause( {guard, ~xs[i], neg( s[i - 1u][bound - 1u] )} );
+    }
+    return pos( activation );
+  }
+
+  void minimize_constants( bill::lit_type const& activation, xmg_chain& chain )
+  {
+    for ( auto bound = chain.num_non_self_dual(); bound > 0u; --bound )
+    {
+      auto const cardinality = add_cardinality_constraint( bound - 1u );
+      if ( solve( {activation, cardinality} ) != bill::result::states::satisfiable )
+      {
+        return;
+      }
+      chain = extract_chain();
+    }
+  }
+
+  bill::result::states solve( std::vector<bill::lit_type> const& assumptions )
+  {
+    ++st.num_sat_calls;
+    auto const result = call_with_stopwatch( st.time_sat, [&]() {
+      return solver.solve( assumptions, ps.conflict_limit );
+    } );
+    if ( result == bill::result::states::satisfiable )
+    {
+      model = solver.get_model().model();
+    }
+    return result;
+  }
+
+  xmg_chain extract_chain() const
+  {
+    xmg_chain chain;
+    chain.num_inputs = num_inputs;
+    for ( auto const& g : gates )
+    {
+      xmg_chain::step step;
+      step.is_xor3 = model_value( g.is_xor3 );
+      for ( auto s = 0u; s < 3u; ++s )
+      {
+        for ( auto j = 0u; j < g.select[s].size(); ++j )
+        {
+          if ( model_value( g.select[s][j] ) )
+          {
+            step.fanins[s] = 2u * ( j + first_candidate() ) + ( model_value( g.polarity[s] ) ? 1u : 0u );
+            break;
+          }
+        }
+      }
+      chain.steps.push_back( step );
+    }
+    chain.output = 2u * ( num_inputs + static_cast<uint32_t>( gates.size() ) ) + ( model_value( output_polarity ) ? 1u : 0u );
+    return chain;
+  }
+
+private:
+  kitty::dynamic_truth_table const& function;
+  exact_xmg_params const& ps;
+  exact_xmg_stats& st;
+
+  uint32_t const num_inputs;
+  uint32_t const num_rows;
+  bool const allow_constants;
+
+  solver_t solver;
+  std::vector<gate_vars> gates;
+  bill::var_type output_polarity{};
+  std::vector<bill::lbool_type> model;
+};
+
+} /* namespace detail */
+
+/*! \brief Finds a minimum XMG for `function`
+ *
+ * Returns `std::nullopt` if no XMG with at most `ps.max_gates` gates exists
+ * or if the conflict limit has been reached.
+ */
+inline std::optional<xmg_chain> exact_xmg_synthesis( kitty::dynamic_truth_table const& function, exact_xmg_params const& ps = {}, exact_xmg_stats* pst = nullptr )
+{
+  exact_xmg_stats st;
+  auto const chain = call_with_stopwatch( st.time_total, [&]() {
+    return detail::exact_xmg_impl( function, ps, st ).run();
+  } );
+  ++( chain ? st.num_solved : st.num_failed );
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return chain;
+}
+
+/*! \brief Persistent cache of exact synthesis results
+ *
+ * Every line of the file is `<num_vars>:<hex> <chain>` or `<num_vars>:<hex> -`
+ * for functions without a solution within the limits of the run that added
+ * them.  `save` merges with the current content of the file and replaces it
+ * atomically, such that several experiments can share one cache.
+ */
+class exact_xmg_cache
+{
+public:
+  explicit exact_xmg_cache( std::string const& filename = {} )
+      : filename_( filename )
+  {
+    if ( !filename_.empty() )
+    {
+      load( filename_, entries_ );
+    }
+  }
+
+  ~exact_xmg_cache()
+  {
+    save();
+  }
+
+  exact_xmg_cache( exact_xmg_cache const& ) = delete;
+  exact_xmg_cache& operator=( exact_xmg_cache const& ) = delete;
+
+  /*! \brief Returns nullptr if `function` has not been solved yet, otherwise the (possibly empty) result */
+  std::optional<xmg_chain> const* find( kitty::dynamic_truth_table const& function ) const
+  {
+    auto const it = entries_.find( key( function ) );
+    return it == entries_.end() ? nullptr : &it->second;
+  }
+
+  void insert( kitty::dynamic_truth_table const& function, std::optional<xmg_chain> const& chain )
+  {
+    entries_[key( function )] = chain;
+    dirty_ = true;
+  }
+
+  uint32_t size() const
+  {
+    return static_cast<uint32_t>( entries_.size() );
+  }
+
+  bool save()
+  {
+    if ( filename_.empty() || !dirty_ )
+    {
+      return true;
+    }
+
+    /* keep entries that other runs have added in the meantime */
+    auto merged = entries_;
+    load( filename_, merged );
+    for ( auto const& [k, v] : entries_ )
+    {
+      if ( v || !merged[k] )
+      {
+        merged[k] = v;
+      }
+    }
+
+    auto const tmp = fmt::format( "{}.{}.tmp", filename_, static_cast<const void*>( this ) );
+    {
+      std::ofstream os( tmp, std::ofstream::out );
+      for ( auto const& [k, v] : merged )
+      {
+        os << k << ' ' << ( v ? v->to_string() : "-" ) << '\n';
+      }
+      if ( !os.good() )
+      {
+        std::remove( tmp.c_str() );
+        return false;
+      }
+    }
+    if ( std::rename( tmp.c_str(), filename_.c_str() ) != 0 )
+    {
+      std::remove( tmp.c_str() );
+      return false;
+    }
+    dirty_ = false;
+    return true;
+  }
+
+private:
+  static std::string key( kitty::dynamic_truth_table const& function )
+  {
+    return fmt::format( "{}:{}", function.num_vars(), kitty::to_hex( function ) );
+  }
+
+  static void load( std::string const& filename, std::unordered_map<std::string, std::optional<xmg_chain>>& entries )
+  {
+    std::ifstream in( filename, std::ifstream::in );
+    std::string line;
+    while ( std::getline( in, line ) )
+    {
+      auto const space = line.find( ' ' );
+      auto const colon = line.find( ':' );
+      if ( space == std::string::npos || colon == std::string::npos || colon > space )
+      {
+        continue;
+      }
+
+      auto const k = line.substr( 0u, space );
+      auto const rest = line.substr( space + 1u );
+      if ( rest == "-" )
+      {
+        entries.emplace( k, std::nullopt );
+      }
+      else if ( auto chain = xmg_chain::from_string( std::stoul( k.substr( 0u, colon ) ), rest ) )
+      {
+        entries[k] = chain;
+      }
+    }
+  }
+
+private:
+  std::string filename_;
+  std::unordered_map<std::string, std::optional<xmg_chain>> entries_;
+  bool dirty_{false};
+};
+
+/*! \brief Resynthesis function based on exact synthesis of NPN representatives
+ *
+ * The NPN transformation of every function is memoized, solutions of NPN
+ * representatives are looked up in and added to `cache`.
+ */
+template<class Ntk = xmg_network>
+class exact_xmg_resynthesis
+{
+public:
+  explicit exact_xmg_resynthesis( exact_xmg_cache& cache, exact_xmg_params const& ps = {} )
+      : cache_( cache ), ps_( ps )
+  {
+  }
+
+  template<typename LeavesIterator, typename Fn>
+  void operator()( Ntk& ntk, kitty::dynamic_truth_table const& function, LeavesIterator begin, LeavesIterator end, Fn&& fn )
+  {
+    stopwatch t( st_.time_total );
+
+    auto const& tf = transformation( function );
+    auto const* entry = cache_.find( tf.representative );
+    if ( entry )
+    {
+      ++st_.num_cache_hits;
+    }
+    else
+    {
+      exact_xmg_stats st;
+      cache_.insert( tf.representative, exact_xmg_synthesis( tf.representative, ps_, &st ) );
+      st_.time_sat += st.time_sat;
+      st_.num_sat_calls += st.num_sat_calls;
+      st_.num_solved += st.num_solved;
+      st_.num_failed += st.num_failed;
+      entry = cache_.find( tf.representative );
+    }
+
+    if ( !*entry )
+    {
+      return;
+    }
+
+    std::vector<signal<Ntk>> leaves( begin, end );
+    std::vector<signal<Ntk>> inputs( function.num_vars() );
+    for ( auto i = 0u; i < inputs.size(); ++i )
+    {
+      inputs[i] = tf.input_complement[i] ? ntk.create_not( leaves[tf.input[i]] ) : leaves[tf.input[i]];
+    }
+    auto const f = ( *entry )->instantiate( ntk, inputs );
+    fn( tf.output_complement ? ntk.create_not( f ) : f );
+  }
+
+  exact_xmg_stats const& stats() const
+  {
+    return st_;
+  }
+
+private:
+  /* function(x) = output_complement ^ representative(y) with y_i = x_{input[i]} ^ input_complement[i] */
+  struct npn_transformation
+  {
+    kitty::dynamic_truth_table representative;
+    std::vector<uint32_t> input;
+    std::vector<bool> input_complement;
+    bool output_complement{false};
+  };
+
+  npn_transformation const& transformation( kitty::dynamic_truth_table const& function )
+  {
+    if ( auto const it = transformations_.find( function ); it != transformations_.end() )
+    {
+      return it->second;
+    }
+
+    stopwatch t( st_.time_npn );
+    auto const num_vars = function.num_vars();
+    auto const config = kitty::exact_npn_canonization( function );
+
+    npn_transformation tf;
+    tf.representative = std::get<0>( config );
+    tf.output_complement = ( std::get<1>( config ) >> num_vars ) & 1;
+
+    /* apply the inverse transformation to projections, which avoids depending on the permutation encoding */
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      kitty::dynamic_truth_table var( num_vars );
+      kitty::create_nth_var( var, i );
+      auto const g = kitty::create_from_npn_config( std::make_tuple( var, std::get<1>( config ), std::get<2>( config ) ) );
+      for ( auto j = 0u; j < num_vars; ++j )
+      {
+        kitty::dynamic_truth_table xj( num_vars );
+        kitty::create_nth_var( xj, j );
+        if ( g == xj || g == ~xj )
+        {
+          tf.input.push_back( j );
+          tf.input_complement.push_back( ( g != xj ) != tf.output_complement );
+          break;
+        }
+      }
+    }
+
+    return transformations_.emplace( function, tf ).first->second;
+  }
+
+private:
+  exact_xmg_cache& cache_;
+  exact_xmg_params const ps_;
+  exact_xmg_stats st_;
+  std::unordered_map<kitty::dynamic_truth_table, npn_transformation, kitty::hash<kitty::dynamic_truth_table>> transformations_;
+};
+
+/*! \brief Uses a database resynthesis for small cuts and exact synthesis for larger cuts
+ *
+ * For example, `xmg3_npn_resynthesis` for cuts with up to 4 leaves and
+ * `exact_xmg_resynthesis` for cuts with 5 or 6 leaves.
+ */
+template<class Ntk, class DatabaseResynthesis, class ExactResynthesis = exact_xmg_resynthesis<Ntk>>
+class xmg_exact_fallback_resynthesis
+{
+public:
+  xmg_exact_fallback_resynthesis( DatabaseResynthesis& database, ExactResynthesis& exact, uint32_t database_vars = 4u )
+      : database_( database ), exact_( exact ), database_vars_( database_vars )
+  {
+  }
+
+  template<typename LeavesIterator, typename Fn>
+  void operator()( Ntk& ntk, kitty::dynamic_truth_table const& function, LeavesIterator begin, LeavesIterator end, Fn&& fn )
+  {
+    if ( function.num_vars() <= database_vars_ )
+    {
+      database_( ntk, function, begin, end, fn );
+    }
+    else
+    {
+      exact_( ntk, function, begin, end, fn );
+    }
+  }
+
+private:
+  DatabaseResynthesis& database_;
+  ExactResynthesis& exact_;
+  uint32_t database_vars_;
+};
+
+} /* namespace mockturtle */
@@ -0,0 +1,588 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file xmg_fraig.hpp
+  \brief SAT sweeping (functional reduction) of XMGs
+
+  Nodes are partitioned into candidate equivalence classes (up to
+  complementation) by bit-parallel random simulation.  Every node is then
+  checked against the representative of its class, i.e., the class member
+  that comes first in topological order, with one incremental solver in
+  which the network is encoded lazily and every miter is guarded by an
+  activation literal.  Proved equivalences are added as clauses to speed up
+  later calls.  Counterexamples are collected in batches of 64, simulated in
+  one word, and used to split the classes; nodes whose class changed are
+  checked again in the next round.
+
+  The result is a copy of the network in which every proved node is replaced
+  by its representative and logic that is no longer used is dropped.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <bill/sat/solver.hpp>
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include "xmg_simulation.hpp"
+
+namespace mockturtle
+{
+
+struct xmg_fraig_params
+{
+  /*! \brief Number of 64-bit words of random patterns. */
+  uint32_t num_words{8u};
+
+  /*! \brief Seed for the random patterns. */
+  uint64_t seed{0x5eed};
+
+  /*! \brief Conflict limit per SAT call (0: no limit). */
+  uint32_t conflict_limit{1000u};
+
+  /*! \brief Maximum number of refinement rounds. */
+  uint32_t max_rounds{8u};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct xmg_fraig_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime of simulation and class refinement. */
+  stopwatch<>::duration time_simulation{0};
+
+  /*! \brief Runtime of SAT calls. */
+  stopwatch<>::duration time_sat{0};
+
+  uint32_t num_classes{0u};
+  uint32_t num_rounds{0u};
+  uint32_t num_sat_calls{0u};
+  uint32_t num_proved{0u};
+  uint32_t num_disproved{0u};
+  uint32_t num_undecided{0u};
+  uint32_t gates_before{0u};
+  uint32_t gates_after{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] gates = {} -> {}, initial classes = {}, rounds = {}\n", gates_before, gates_after, num_classes, num_rounds );
+    std::cout << fmt::format( "[i] SAT calls = {} (proved: {}, disproved: {}, undecided: {})\n", num_sat_calls, num_proved, num_disproved, num_undecided );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs (simulation: {:>5.2f} secs, SAT: {:>5.2f} secs)\n", to_seconds( time_total ), to_seconds( time_simulation ), to_seconds( time_sat ) );
+  }
+};
+
+namespace detail
+{
+
+/* one solver with the lazily encoded network, miters between pairs of nodes */
+class fraig_encoder
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+  using solver_t = bill::solver<bill::solvers::ghack>;
+
+  explicit fraig_encoder( xmg_network const& ntk )
+      : ntk( ntk ), vars( ntk.size(), UINT32_MAX )
+  {
+    constant = solver.add_variable();
+    solver.add_clause( neg( constant ) );
+  }
+
+  /*! \brief Returns true if `a` and `b ^ complement` are equivalent, false and a counterexample if not, and nothing if undecided */
+  std::optional<bool> check( node const& a, node const& b, bool complement, uint32_t conflict_limit, std::vector<bool>& counterexample )
+  {
+    auto const l1 = node_literal( a );
+    auto const l2 = complement ? ~node_literal( b ) : node_literal( b );
+
+    /* activation -> ( l1 != l2 ) */
+    auto const activation = pos( solver.add_variable() );
+    solver.add_clause( {~activation, l1, l2} );
+    solver.add_clause( {~activation, ~l1, ~l2} );
+
+    auto const result = solver.solve( {activation}, conflict_limit );
+    solver.add_clause( ~activation );
+
+    if ( result == bill::result::states::unsatisfiable )
+    {
+      /* the equivalence holds in every later call */
+      solver.add_clause( {~l1, l2} );
+      solver.add_clause( {l1, ~l2} );
+      return true;
+    }
+    if ( result == bill::result::states::undefined )
+    {
+      return std::nullopt;
+    }
+
+    auto const model = solver.get_model().model();
+    counterexample.clear();
+    ntk.foreach_pi( [&]( auto const& n ) {
+      auto const v = vars[ntk.node_to_index( n )];
+      /* inputs outside of the cones are unconstrained */
+      counterexample.push_back( v != UINT32_MAX && model[v] == bill::lbool_type::true_ );
+    } );
+    return false;
+  }
+
+private:
+  static bill::lit_type pos( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::positive );
+  }
+
+  static bill::lit_type neg( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::negative );
+  }
+
+  static bill::lit_type lit( bill::lit_type l, bool value )
+  {
+    return value ? l : ~l;
+  }
+
+  bill::lit_type literal( signal const& f )
+  {
+    auto const l = node_literal( ntk.get_node( f ) );
+    return ntk.is_complemented( f ) ? ~l : l;
+  }
+
+  bill::lit_type node_literal( node const& n )
+  {
+    if ( ntk.is_constant( n ) )
+    {
+      return pos( constant );
+    }
+    auto& v = vars[ntk.node_to_index( n )];
+    if ( ntk.is_pi( n ) )
+    {
+      if ( v == UINT32_MAX )
+      {
+        v = solver.add_variable();
+      }
+      return pos( v );
+    }
+    encode( n );
+    return pos( vars[ntk.node_to_index( n )] );
+  }
+
+  /* iterative DFS to be safe on deep netlists */
+  void encode( node const& root )
+  {
+    if ( vars[ntk.node_to_index( root )] != UINT32_MAX )
+    {
+      return;
+    }
+
+    stack.clear();
+    stack.emplace_back( root, false );
+    while ( !stack.empty() )
+    {
+      auto const [n, expanded] = stack.back();
+      stack.pop_back();
+      auto const index = ntk.node_to_index( n );
+
+      if ( !expanded )
+      {
+        if ( vars[index] != UINT32_MAX || ntk.is_constant( n ) || ntk.is_pi( n ) )
+        {
+          continue;
+        }
+        stack.emplace_back( n, true );
+        ntk.foreach_fanin( n, [&]( auto const& fi ) {
+          auto const c = ntk.get_node( fi );
+          if ( !ntk.is_constant( c ) && !ntk.is_pi( c ) && vars[ntk.node_to_index( c )] == UINT32_MAX )
+          {
+            stack.emplace_back( c, false );
+          }
+        } );
+        continue;
+      }
+      if ( vars[index] != UINT32_MAX )
+      {
+        continue;
+      }
+
+      std::array<bill::lit_type, 3> fanins;
+      ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+        fanins[i] = literal( fi );
+      } );
+      vars[index] = solver.add_variable();
+      auto const x = pos( vars[index] );
+      auto const &a = fanins[0], &b = fanins[1], &c = fanins[2];
+
+      if ( ntk.is_xor3( n ) )
+      {
+        for ( auto i = 0u; i < 8u; ++i )
+        {
+          bool const va = i & 1, vb = ( i >> 1 ) & 1, vc = ( i >> 2 ) & 1;
+          solver.add_clause( {lit( a, !va ), lit( b, !vb ), lit( c, !vc ), lit( x, va ^ vb ^ vc )} );
+        }
+      }
+      else
+      {
+        solver.add_clause( {~a, ~b, x} );
+        solver.add_clause( {~a, ~c, x} );
+        solver.add_clause( {~b, ~c, x} );
+        solver.add_clause( {a, b, ~x} );
+        solver.add_clause( {a, c, ~x} );
+        solver.add_clause( {b, c, ~x} );
+      }
+    }
+  }
+
+private:
+  xmg_network const& ntk;
+  solver_t solver;
+  bill::var_type constant;
+  std::vector<uint32_t> vars;
+  std::vector<std::pair<node, bool>> stack;
+};
+
+class xmg_fraig_impl
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  xmg_fraig_impl( xmg_network const& ntk, xmg_fraig_params const& ps, xmg_fraig_stats& st )
+      : ntk( ntk ), ps( ps ), st( st ), sim( ntk, std::max( ps.num_words, 1u ) ), cex_sim( ntk, 1u ),
+        phase( ntk.size(), 0u ), class_of( ntk.size(), UINT32_MAX ), repr( ntk.size(), UINT32_MAX ), checked( ntk.size(), UINT32_MAX )
+  {
+  }
+
+  xmg_network run()
+  {
+    stopwatch t( st.time_total );
+
+    st.gates_before = ntk.num_gates();
+    sweep();
+    auto res = rebuild();
+    st.gates_after = res.num_gates();
+    return res;
+  }
+
+  /*! \brief Proves equivalences without changing the network */
+  void sweep()
+  {
+    /* candidates in topological order, the first member of a class is its representative */
+    candidates.push_back( ntk.get_node( ntk.get_constant( false ) ) );
+    ntk.foreach_pi( [&]( auto const& n ) { candidates.push_back( n ); } );
+    candidates.insert( candidates.end(), sim.order().begin(), sim.order().end() );
+
+    call_with_stopwatch( st.time_simulation, [&]() { simulate(); } );
+    st.num_classes = static_cast<uint32_t>( std::count_if( classes.begin(), classes.end(), []( auto const& c ) { return c.size() > 1u; } ) );
+
+    fraig_encoder encoder( ntk );
+    std::vector<bool> counterexample;
+    for ( auto round = 0u; round < ps.max_rounds; ++round )
+    {
+      ++st.num_rounds;
+      auto const disproved_before = st.num_disproved;
+
+      for ( auto const& n : candidates )
+      {
+        if ( ntk.is_constant( n ) || ntk.is_pi( n ) )
+        {
+          continue;
+        }
+        auto const index = ntk.node_to_index( n );
+        auto const c = class_of[index];
+        if ( c == UINT32_MAX || repr[index] != UINT32_MAX || classes[c].front() == n || checked[index] == ntk.node_to_index( classes[c].front() ) )
+        {
+          continue;
+        }
+
+        /* undecided pairs are not tried again */
+        auto const r = classes[c].front();
+        checked[index] = ntk.node_to_index( r );
+
+        ++st.num_sat_calls;
+        auto const equivalent = call_with_stopwatch( st.time_sat, [&]() {
+          return encoder.check( n, r, phase[index] != phase[ntk.node_to_index( r )], ps.conflict_limit, counterexample );
+        } );
+        if ( !equivalent )
+        {
+          ++st.num_undecided;
+        }
+        else if ( *equivalent )
+        {
+          ++st.num_proved;
+          repr[index] = ntk.node_to_index( r );
+        }
+        else
+        {
+          ++st.num_disproved;
+          counterexamples.push_back( counterexample );
+          if ( counterexamples.size() == 64u )
+          {
+            call_with_stopwatch( st.time_simulation, [&]() { refine(); } );
+          }
+        }
+      }
+
+      call_with_stopwatch( st.time_simulation, [&]() { refine(); } );
+      if ( st.num_disproved == disproved_before )
+      {
+        break;
+      }
+    }
+  }
+
+  /*! \brief Index of the node that `n` is proved equivalent to (UINT32_MAX if none) */
+  uint32_t representative( node const& n ) const
+  {
+    return repr[ntk.node_to_index( n )];
+  }
+
+  /*! \brief Whether `n` is equivalent to the complement of its representative */
+  bool complemented( node const& n ) const
+  {
+    auto const index = ntk.node_to_index( n );
+    return repr[index] != UINT32_MAX && phase[index] != phase[repr[index]];
+  }
+
+private:
+  void simulate()
+  {
+    sim.randomize( ps.seed );
+    sim.simulate();
+
+    auto const num_words = sim.num_words();
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    std::vector<uint64_t> normalized( num_words );
+    for ( auto const& n : candidates )
+    {
+      auto const index = ntk.node_to_index( n );
+      auto const* v = sim.get( n );
+
+      /* signatures are normalized such that the first bit is 0 */
+      phase[index] = v[0] & 1;
+      uint64_t const mask = phase[index] ? ~uint64_t( 0 ) : uint64_t( 0 );
+      uint64_t hash{0xcbf29ce484222325};
+      for ( auto w = 0u; w < num_words; ++w )
+      {
+        normalized[w] = v[w] ^ mask;
+        hash = ( hash ^ normalized[w] ) * 0x100000001b3;
+      }
+
+      auto& bucket = buckets[hash];
+      auto const it = std::find_if( bucket.begin(), bucket.end(), [&]( auto c ) {
+        auto const& r = classes[c].front();
+        auto const* vr = sim.get( r );
+        uint64_t const mask_r = phase[ntk.node_to_index( r )] ? ~uint64_t( 0 ) : uint64_t( 0 );
+        for ( auto w = 0u; w < num_words; ++w )
+        {
+          if ( ( vr[w] ^ mask_r ) != normalized[w] )
+          {
+            return false;
+          }
+        }
+        return true;
+      } );
+      if ( it != bucket.end() )
+      {
+        class_of[index] = *it;
+        classes[*it].push_back( n );
+      }
+      else
+      {
+        class_of[index] = static_cast<uint32_t>( classes.size() );
+        bucket.push_back( class_of[index] );
+        classes.push_back( {n} );
+      }
+    }
+  }
+
+  /* simulates the collected counterexamples in one word and splits the classes accordingly */
+  void refine()
+  {
+    if ( counterexamples.empty() )
+    {
+      return;
+    }
+
+    std::vector<uint64_t> word( 1u );
+    ntk.foreach_pi( [&]( auto const& n, auto i ) {
+      word[0] = 0u;
+      for ( auto j = 0u; j < counterexamples.size(); ++j )
+      {
+        word[0] |= uint64_t( counterexamples[j][i] ) << j;
+      }
+      cex_sim.set_pi( n, word );
+    } );
+    cex_sim.simulate();
+    counterexamples.clear();
+
+    std::vector<std::pair<uint64_t, uint32_t>> parts;
+    auto const num_classes = classes.size();
+    for ( auto c = 0u; c < num_classes; ++c )
+    {
+      if ( classes[c].size() < 2u )
+      {
+        continue;
+      }
+
+      /* the part with the representative keeps the class index, members stay in topological order */
+      auto members = std::move( classes[c] );
+      classes[c].clear();
+      parts.clear();
+      for ( auto const& n : members )
+      {
+        auto const index = ntk.node_to_index( n );
+        auto const value = cex_sim.get( n )[0] ^ ( phase[index] ? ~uint64_t( 0 ) : uint64_t( 0 ) );
+        auto it = std::find_if( parts.begin(), parts.end(), [&]( auto const& p ) { return p.first == value; } );
+        if ( it == parts.end() )
+        {
+          parts.emplace_back( value, parts.empty() ? c : static_cast<uint32_t>( classes.size() ) );
+          if ( parts.size() > 1u )
+          {
+            classes.emplace_back();
+          }
+          it = parts.end() - 1;
+        }
+        class_of[index] = it->second;
+        classes[it->second].push_back( n );
+      }
+    }
+  }
+
+  xmg_network rebuild() const
+  {
+    xmg_network res;
+    std::vector<signal> old2new( ntk.size() );
+    old2new[ntk.node_to_index( ntk.get_node( ntk.get_constant( false ) ) )] = res.get_constant( false );
+    ntk.foreach_pi( [&]( auto const& n ) {
+      old2new[ntk.node_to_index( n )] = res.create_pi();
+    } );
+
+    /* only nodes in the transitive fanin of the outputs after merging are copied */
+    std::vector<uint8_t> used( ntk.size(), 0u );
+    ntk.foreach_po( [&]( auto const& f ) {
+      used[ntk.node_to_index( ntk.get_node( f ) )] = 1u;
+    } );
+    for ( auto it = sim.order().rbegin(); it != sim.order().rend(); ++it )
+    {
+      auto const index = ntk.node_to_index( *it );
+      if ( !used[index] )
+      {
+        continue;
+      }
+      if ( repr[index] != UINT32_MAX )
+      {
+        used[repr[index]] = 1u;
+        continue;
+      }
+      ntk.foreach_fanin( *it, [&]( auto const& fi ) {
+        used[ntk.node_to_index( ntk.get_node( fi ) )] = 1u;
+      } );
+    }
+
+    for ( auto const& n : sim.order() )
+    {
+      auto const index = ntk.node_to_index( n );
+      if ( !used[index] )
+      {
+        continue;
+      }
+      if ( repr[index] != UINT32_MAX )
+      {
+        old2new[index] = old2new[repr[index]] ^ ( phase[index] != phase[repr[index]] );
+        continue;
+      }
+
+      std::array<signal, 3> children;
+      ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+        children[i] = old2new[ntk.node_to_index( ntk.get_node( fi ) )] ^ ntk.is_complemented( fi );
+      } );
+      old2new[index] = ntk.is_xor3( n ) ? res.create_xor3( children[0], children[1], children[2] ) : res.create_maj( children[0], children[1], children[2] );
+    }
+
+    ntk.foreach_po( [&]( auto const& f ) {
+      res.create_po( old2new[ntk.node_to_index( ntk.get_node( f ) )] ^ ntk.is_complemented( f ) );
+    } );
+    return res;
+  }
+
+private:
+  xmg_network const& ntk;
+  xmg_fraig_params const& ps;
+  xmg_fraig_stats& st;
+
+  xmg_simulator sim;
+  xmg_simulator cex_sim;
+
+  std::vector<node> candidates;
+  std::vector<uint8_t> phase;
+  std::vector<uint32_t> class_of;
+  std::vector<std::vector<node>> classes;
+  std::vector<uint32_t> repr;
+  std::vector<uint32_t> checked;
+  std::vector<std::vector<bool>> counterexamples;
+};
+
+} /* namespace detail */
+
+/*! \brief SAT sweeping of an XMG
+ *
+ * Returns a copy of `ntk` in which functionally equivalent nodes (up to
+ * complementation) are merged.  Node pairs that reach the conflict limit are
+ * kept apart, so the result is always equivalent to `ntk`.
+ */
+inline xmg_network xmg_fraig( xmg_network const& ntk, xmg_fraig_params const& ps = {}, xmg_fraig_stats* pst = nullptr )
+{
+  xmg_fraig_stats st;
+  detail::xmg_fraig_impl p( ntk, ps, st );
+  auto res = p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return res;
+}
+
+} /* namespace mockturtle */
@@ -0,0 +1,456 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_genlib_cost.hpp
+  \brief Area of XMG nodes derived from a genlib library
+
+  `read_genlib` parses the GATE lines of a genlib file (area and Boolean
+  expression with `!`, `*`, `+`, parentheses, CONST0, and CONST1).
+  `xmg_genlib_cost` computes the area of every function of up to three
+  inputs that a single library gate realizes (gate inputs may be tied to
+  constants or to the same variable), with inverters at the inputs or the
+  output charged with the area of the cheapest inverter.  The area of an
+  XMG node is the area of its local function after folding complemented
+  fanins and constant fanins in, so a MAJ with three complemented fanins costs
+  a MIN gate if the library has one, and MAJ + 3 inverters otherwise.
+
+  The object is a node cost function for `cut_rewriting` and
+  `xmg_delay_rewriting` (areas in units of 1/scale) and provides the gate
+  areas for `xmg_sd_resubstitution`.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <mockturtle/networks/xmg.hpp>
+
+#include "xmg_sd_resub.hpp"
+
+namespace mockturtle
+{
+
+struct genlib_gate
+{
+  std::string name;
+  double area{0.0};
+  std::string expression;
+
+  /*! \brief Inputs in order of their first occurrence in the expression. */
+  std::vector<std::string> inputs;
+
+  /*! \brief Truth table over `inputs` (at most 6). */
+  uint64_t function{0u};
+};
+
+namespace detail
+{
+
+class genlib_expression_parser
+{
+public:
+  explicit genlib_expression_parser( std::string const& expression )
+      : s( expression )
+  {
+  }
+
+  bool parse( std::vector<std::string>& inputs, uint64_t& function )
+  {
+    pos = 0u;
+    if ( !collect_inputs() )
+    {
+      return false;
+    }
+    pos = 0u;
+    ok = true;
+    function = parse_or();
+    skip_spaces();
+    if ( !ok || pos != s.size() )
+    {
+      return false;
+    }
+    function &= inputs_.size() == 6u ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << ( 1u << inputs_.size() ) ) - 1u );
+    inputs = inputs_;
+    return true;
+  }
+
+private:
+  static bool is_ident( char c )
+  {
+    return std::isalnum( static_cast<unsigned char>( c ) ) || c == '_' || c == '[' || c == ']' || c == '.';
+  }
+
+  void skip_spaces()
+  {
+    while ( pos < s.size() && std::isspace( static_cast<unsigned char>( s[pos] ) ) )
+    {
+      ++pos;
+    }
+  }
+
+  std::string identifier()
+  {
+    auto const begin = pos;
+    while ( pos < s.size() && is_ident( s[pos] ) )
+    {
+      ++pos;
+    }
+    return s.substr( begin, pos - begin );
+  }
+
+  bool collect_inputs()
+  {
+    while ( pos < s.size() )
+    {
+      if ( is_ident( s[pos] ) )
+      {
+        auto const name = identifier();
+        if ( name != "CONST0" && name != "CONST1" && std::find( inputs_.begin(), inputs_.end(), name ) == inputs_.end() )
+        {
+          inputs_.push_back( name );
+        }
+      }
+      else
+      {
+        ++pos;
+      }
+    }
+    return inputs_.size() <= 6u;
+  }
+
+  uint64_t projection( std::string const& name ) const
+  {
+    static constexpr uint64_t projections[] = {0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0,
+                                               0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000};
+    return projections[std::find( inputs_.begin(), inputs_.end(), name ) - inputs_.begin()];
+  }
+
+  uint64_t parse_or()
+  {
+    auto value = parse_and();
+    skip_spaces();
+    while ( ok && pos < s.size() && s[pos] == '+' )
+    {
+      ++pos;
+      value |= parse_and();
+      skip_spaces();
+    }
+    return value;
+  }
+
+  uint64_t parse_and()
+  {
+    auto value = parse_unary();
+    skip_spaces();
+    while ( ok && pos < s.size() && s[pos] == '*' )
+    {
+      ++pos;
+      value &= parse_unary();
+      skip_spaces();
+    }
+    return value;
+  }
+
+  uint64_t parse_unary()
+  {
+    skip_spaces();
+    if ( pos >= s.size() )
+    {
+      ok = false;
+      return 0u;
+    }
+    if ( s[pos] == '!' )
+    {
+      ++pos;
+      return ~parse_unary();
+    }
+    if ( s[pos] == '(' )
+    {
+      ++pos;
+      auto const value = parse_or();
+      skip_spaces();
+      if ( pos >= s.size() || s[pos] != ')' )
+      {
+        ok = false;
+        return 0u;
+      }
+      ++pos;
+      return value;
+    }
+
+    auto const name = identifier();
+    if ( name.empty() )
+    {
+      ok = false;
+      return 0u;
+    }
+    if ( name == "CONST0" )
+    {
+      return 0u;
+    }
+    if ( name == "CONST1" )
+    {
+      return ~uint64_t( 0 );
+    }
+    return projection( name );
+  }
+
+private:
+  std::string const& s;
+  std::size_t pos{0u};
+  bool ok{true};
+  std::vector<std::string> inputs_;
+};
+
+} /* namespace detail */
+
+/*! \brief Reads the gates of a genlib file, returns false if the file cannot be read
+ *
+ * Gates with more than 6 inputs or unsupported expressions are skipped.
+ */
+inline bool read_genlib( std::string const& filename, std::vector<genlib_gate>& gates )
+{
+  std::ifstream in( filename );
+  if ( !in.is_open() )
+  {
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline( in, line ) )
+  {
+    line = line.substr( 0u, line.find( '#' ) );
+
+    std::istringstream ls( line );
+    std::string keyword;
+    genlib_gate gate;
+    if ( !( ls >> keyword ) || keyword != "GATE" || !( ls >> gate.name >> gate.area ) )
+    {
+      continue;
+    }
+
+    std::string rest;
+    std::getline( ls, rest );
+    auto const eq = rest.find( '=' );
+    auto const semicolon = rest.find( ';' );
+    if ( eq == std::string::npos || semicolon == std::string::npos || semicolon < eq )
+    {
+      continue;
+    }
+
+    gate.expression = rest.substr( eq + 1u, semicolon - eq - 1u );
+    if ( detail::genlib_expression_parser( gate.expression ).parse( gate.inputs, gate.function ) )
+    {
+      gates.push_back( gate );
+    }
+  }
+  return true;
+}
+
+/*! \brief Area of XMG nodes according to a genlib library
+ *
+ * Without a library (default constructor), every gate has area 1 and
+ * inverters are free, i.e., the cost is the gate count.
+ */
+class xmg_genlib_cost
+{
+public:
+  xmg_genlib_cost()
+  {
+    area_.fill( 1.0 );
+    inverter_ = 0.0;
+    buffer_ = 0.0;
+  }
+
+  explicit xmg_genlib_cost( std::vector<genlib_gate> const& gates, double scale = 100.0 )
+      : scale_( scale )
+  {
+    constexpr auto infinity = std::numeric_limits<double>::infinity();
+    area_.fill( infinity );
+
+    for ( auto const& g : gates )
+    {
+      if ( g.inputs.size() == 1u && ( g.function & 3u ) == 1u )
+      {
+        inverter_ = std::min( inverter_, g.area );
+      }
+      else if ( g.inputs.size() == 1u && ( g.function & 3u ) == 2u )
+      {
+        buffer_ = std::min( buffer_, g.area );
+      }
+      add_gate( g );
+    }
+    if ( inverter_ == infinity )
+    {
+      inverter_ = 0.0;
+    }
+    if ( buffer_ == infinity )
+    {
+      buffer_ = 0.0;
+    }
+
+    /* inverters at inputs and output */
+    for ( auto changed = true; changed; )
+    {
+      changed = false;
+      for ( auto f = 0u; f < 256u; ++f )
+      {
+        auto best = area_[f ^ 0xff] + inverter_;
+        for ( auto i = 0u; i < 3u; ++i )
+        {
+          best = std::min( best, area_[flip( f, i )] + inverter_ );
+        }
+        if ( best < area_[f] )
+        {
+          area_[f] = best;
+          changed = true;
+        }
+      }
+    }
+
+    /* functions without a single-gate implementation */
+    auto max_area{0.0};
+    for ( auto a : area_ )
+    {
+      max_area = a == infinity ? max_area : std::max( max_area, a );
+    }
+    for ( auto& a : area_ )
+    {
+      a = a == infinity ? 2.0 * max_area : a;
+    }
+  }
+
+  /*! \brief Node cost in units of 1/scale (node cost function interface) */
+  uint32_t operator()( xmg_network const& ntk, xmg_network::node const& n ) const
+  {
+    return static_cast<uint32_t>( std::lround( area( ntk, n ) * scale_ ) );
+  }
+
+  /*! \brief Area of a node including inverters for complemented fanins */
+  double area( xmg_network const& ntk, xmg_network::node const& n ) const
+  {
+    if ( !ntk.is_maj( n ) && !ntk.is_xor3( n ) )
+    {
+      return 0.0;
+    }
+
+    static constexpr uint8_t projections[] = {0xaa, 0xcc, 0xf0};
+    std::array<uint8_t, 3> fanins{};
+    ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+      auto const value = ntk.is_constant( ntk.get_node( fi ) ) ? uint8_t( 0x00 ) : projections[i];
+      fanins[i] = ntk.is_complemented( fi ) ? uint8_t( ~value ) : value;
+    } );
+    auto const& [a, b, c] = fanins;
+    auto const function = ntk.is_xor3( n ) ? uint8_t( a ^ b ^ c ) : uint8_t( ( a & b ) | ( a & c ) | ( b & c ) );
+    return area_[function];
+  }
+
+  /*! \brief Area of the cheapest realization of a 3-input truth table */
+  double function_area( uint8_t function ) const
+  {
+    return area_[function];
+  }
+
+  xmg_gate_costs gate_costs() const
+  {
+    return {area_[0xe8], area_[0x96], area_[0x88], area_[0x66]};
+  }
+
+  double inverter() const
+  {
+    return inverter_;
+  }
+
+  double buffer() const
+  {
+    return buffer_;
+  }
+
+  double scale() const
+  {
+    return scale_;
+  }
+
+private:
+  static uint8_t flip( uint32_t f, uint32_t var )
+  {
+    uint32_t result{0u};
+    for ( auto m = 0u; m < 8u; ++m )
+    {
+      result |= ( ( f >> ( m ^ ( 1u << var ) ) ) & 1u ) << m;
+    }
+    return static_cast<uint8_t>( result );
+  }
+
+  /* all assignments of the gate inputs to three variables or constants (repetitions allowed) */
+  void add_gate( genlib_gate const& g )
+  {
+    auto const k = static_cast<uint32_t>( g.inputs.size() );
+    if ( k > 3u )
+    {
+      return;
+    }
+
+    uint32_t num_assignments{1u};
+    for ( auto i = 0u; i < k; ++i )
+    {
+      num_assignments *= 5u;
+    }
+    for ( auto assignment = 0u; assignment < num_assignments; ++assignment )
+    {
+      uint32_t f{0u};
+      for ( auto m = 0u; m < 8u; ++m )
+      {
+        uint32_t index{0u};
+        for ( auto i = 0u, a = assignment; i < k; ++i, a /= 5u )
+        {
+          auto const source = a % 5u; /* 0-2: variable, 3: constant 0, 4: constant 1 */
+          auto const value = source < 3u ? ( m >> source ) & 1u : source - 3u;
+          index |= value << i;
+        }
+        f |= ( ( g.function >> index ) & 1u ) << m;
+      }
+      area_[f] = std::min( area_[f], g.area );
+    }
+  }
+
+private:
+  std::array<double, 256> area_;
+  double inverter_{std::numeric_limits<double>::infinity()};
+  double buffer_{std::numeric_limits<double>::infinity()};
+  double scale_{1.0};
+};
+
+} /* namespace mockturtle */
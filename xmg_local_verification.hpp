@@ -0,0 +1,328 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_local_verification.hpp
+  \brief Local verification of rewriting candidates and optimization passes
+
+  `verified_resynthesis` wraps a resynthesis function for `cut_rewriting` and
+  checks every candidate sub-network it creates against the cut function by
+  simulating the candidate over all assignments of the cut leaves, taking
+  don't-cares into account if the resynthesis is called with them.  Failing
+  candidates are logged and not passed on to `cut_rewriting`, so that they
+  can never be committed.
+
+  Passes whose replacements cannot be observed from outside, such as
+  `xmg_resubstitution`, are guarded by comparing random simulation
+  signatures of the outputs before and after the pass.  This detects most
+  wrong replacements right after the pass that made them; a final global
+  equivalence check is still needed for a proof.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+#include <kitty/print.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include "xmg_simulation.hpp"
+
+namespace mockturtle
+{
+
+struct local_verification_params
+{
+  /*! \brief Drop candidates that fail the check instead of only logging them. */
+  bool reject{true};
+
+  /*! \brief Number of 64-bit words per output signature. */
+  uint32_t num_words{64u};
+
+  /*! \brief Seed for the random input patterns of output signatures. */
+  uint64_t seed{0x5eed};
+
+  /*! \brief Print failures when they occur. */
+  bool verbose{true};
+};
+
+struct local_verification_stats
+{
+  /*! \brief Total time spent in local checks. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of checked rewriting candidates. */
+  uint64_t num_candidates{0u};
+
+  /*! \brief Number of checked passes. */
+  uint64_t num_passes{0u};
+
+  /*! \brief Log of all failed checks. */
+  std::vector<std::string> failures;
+
+  bool all_passed() const
+  {
+    return failures.empty();
+  }
+
+  void report() const
+  {
+    fmt::print( "[i] local verification: {} candidates, {} passes, {} failures, {:>5.2f} secs\n",
+                num_candidates, num_passes, failures.size(), to_seconds( time_total ) );
+  }
+};
+
+namespace detail
+{
+
+/*! \brief Collects the nodes between `root` and `leaves` in topological order
+ *
+ * Returns false if the cone reaches a primary input that is not a leaf.
+ */
+inline bool collect_candidate_cone( xmg_network const& ntk, xmg_window_simulator const& window, xmg_network::node const& root, std::vector<xmg_network::node>& cone )
+{
+  if ( window.contains( root ) || std::find( cone.begin(), cone.end(), root ) != cone.end() )
+  {
+    return true;
+  }
+  if ( ntk.is_pi( root ) )
+  {
+    return false;
+  }
+
+  bool ok{true};
+  ntk.foreach_fanin( root, [&]( auto const& fi ) {
+    ok = ok && collect_candidate_cone( ntk, window, ntk.get_node( fi ), cone );
+  } );
+  cone.push_back( root );
+  return ok;
+}
+
+} // namespace detail
+
+/*! \brief Resynthesis function that checks every candidate of `ResynFn` */
+template<class ResynFn>
+class verified_resynthesis
+{
+public:
+  verified_resynthesis( ResynFn& resyn, local_verification_params const& ps = {}, local_verification_stats* pst = nullptr )
+      : resyn_( resyn ), ps_( ps ), pst_( pst )
+  {
+  }
+
+  template<class Ntk, typename TT, typename LeavesIterator, typename Fn>
+  void operator()( Ntk& ntk, TT const& function, LeavesIterator begin, LeavesIterator end, Fn&& fn )
+  {
+    resyn_( ntk, function, begin, end, [&]( auto const& f ) {
+      return forward_if_correct( ntk, function, static_cast<TT const*>( nullptr ), begin, end, f, fn );
+    } );
+  }
+
+  template<class Ntk, typename TT, typename LeavesIterator, typename Fn>
+  void operator()( Ntk& ntk, TT const& function, TT const& dont_cares, LeavesIterator begin, LeavesIterator end, Fn&& fn )
+  {
+    resyn_( ntk, function, dont_cares, begin, end, [&]( auto const& f ) {
+      return forward_if_correct( ntk, function, &dont_cares, begin, end, f, fn );
+    } );
+  }
+
+private:
+  template<class Ntk, typename TT, typename LeavesIterator, typename Fn>
+  auto forward_if_correct( Ntk& ntk, TT const& function, TT const* dont_cares, LeavesIterator begin, LeavesIterator end, xmg_network::signal const& f, Fn& fn )
+  {
+    bool correct;
+    {
+      stopwatch<> t( pst_ ? pst_->time_total : time_ );
+      correct = check( ntk, function, dont_cares, begin, end, f );
+    }
+    if ( pst_ )
+    {
+      ++pst_->num_candidates;
+    }
+
+    using result_t = std::invoke_result_t<Fn&, xmg_network::signal const&>;
+    if ( correct || !ps_.reject )
+    {
+      return fn( f );
+    }
+
+    /* skip the wrong candidate and continue with the next one */
+    if constexpr ( !std::is_void_v<result_t> )
+    {
+      return result_t( true );
+    }
+  }
+
+  template<class Ntk, typename TT, typename LeavesIterator>
+  bool check( Ntk const& ntk, TT const& function, TT const* dont_cares, LeavesIterator begin, LeavesIterator end, xmg_network::signal const& f )
+  {
+    xmg_network const& xmg = ntk;
+    if ( !window_ || window_ntk_ != &xmg )
+    {
+      window_ = std::make_unique<xmg_window_simulator>( xmg );
+      window_ntk_ = &xmg;
+    }
+    auto& window = *window_;
+
+    std::vector<xmg_network::node> leaves;
+    for ( auto it = begin; it != end; ++it )
+    {
+      leaves.push_back( xmg.get_node( *it ) );
+    }
+
+    window.begin_window( static_cast<uint32_t>( leaves.size() ) );
+    auto var = 0u;
+    for ( auto it = begin; it != end; ++it, ++var )
+    {
+      if ( window.contains( leaves[var] ) )
+      {
+        continue; /* repeated or constant leaf */
+      }
+      auto* v = window.add( leaves[var] );
+      for ( auto w = 0u; w < window.num_words(); ++w )
+      {
+        v[w] = xmg.is_complemented( *it ) ? ~xmg_window_simulator::projection( var, w ) : xmg_window_simulator::projection( var, w );
+      }
+    }
+
+    cone_.clear();
+    if ( !detail::collect_candidate_cone( xmg, window, xmg.get_node( f ), cone_ ) )
+    {
+      log_failure( fmt::format( "candidate {}{} for function {} depends on nodes outside its cut",
+                                xmg.is_complemented( f ) ? "!" : "", xmg.node_to_index( xmg.get_node( f ) ), kitty::to_hex( function ) ) );
+      return false;
+    }
+    for ( auto const& n : cone_ )
+    {
+      window.simulate_node( n );
+    }
+
+    /* compare on the care set; a single word of a function with k < 6 variables has 2^k valid bits */
+    auto const* actual = window.get( xmg.get_node( f ) );
+    uint64_t const mask = function.num_vars() >= 6u ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << ( 1u << function.num_vars() ) ) - 1u );
+    auto expected = function.begin();
+    for ( auto w = 0u; expected != function.end(); ++w, ++expected )
+    {
+      auto diff = ( actual[w] ^ ( xmg.is_complemented( f ) ? ~uint64_t( 0 ) : uint64_t( 0 ) ) ^ *expected ) & mask;
+      if ( dont_cares )
+      {
+        diff &= ~*( dont_cares->begin() + w );
+      }
+      if ( diff != 0u )
+      {
+        log_failure( fmt::format( "candidate {}{} for function {} differs in word {} (mask {:016x})",
+                                  xmg.is_complemented( f ) ? "!" : "", xmg.node_to_index( xmg.get_node( f ) ), kitty::to_hex( function ), w, diff ) );
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void log_failure( std::string const& message )
+  {
+    if ( ps_.verbose )
+    {
+      fmt::print( "[e] {}\n", message );
+    }
+    if ( pst_ )
+    {
+      pst_->failures.push_back( message );
+    }
+  }
+
+private:
+  ResynFn& resyn_;
+  local_verification_params ps_;
+  local_verification_stats* pst_;
+  stopwatch<>::duration time_{0};
+
+  std::unique_ptr<xmg_window_simulator> window_;
+  xmg_network const* window_ntk_{nullptr};
+  std::vector<xmg_network::node> cone_;
+};
+
+/*! \brief Random simulation signatures of the outputs of an XMG
+ *
+ * Networks with the same number of primary inputs get the same input
+ * patterns for the same `ps.seed`.
+ */
+inline std::vector<std::vector<uint64_t>> output_signatures( xmg_network const& ntk, local_verification_params const& ps = {} )
+{
+  xmg_simulator sim( ntk, ps.num_words );
+  sim.randomize( ps.seed );
+  sim.simulate();
+
+  std::vector<std::vector<uint64_t>> signatures;
+  ntk.foreach_po( [&]( auto const& f ) {
+    signatures.push_back( sim.value( f ) );
+  } );
+  return signatures;
+}
+
+/*! \brief Checks that a pass did not change the output signatures taken before it
+ *
+ * Returns false and logs the first differing output otherwise.
+ */
+inline bool check_output_signatures( std::string const& pass, std::vector<std::vector<uint64_t>> const& before, xmg_network const& ntk,
+                                     local_verification_params const& ps = {}, local_verification_stats* pst = nullptr )
+{
+  stopwatch<>::duration time{0};
+  bool ok{true};
+  {
+    stopwatch<> t( pst ? pst->time_total : time );
+    auto const after = output_signatures( ntk, ps );
+    for ( auto i = 0u; i < after.size() && ok; ++i )
+    {
+      if ( i >= before.size() || after[i] != before[i] )
+      {
+        auto const message = fmt::format( "{} changed the function of output {}", pass, i );
+        if ( ps.verbose )
+        {
+          fmt::print( "[e] {}\n", message );
+        }
+        if ( pst )
+        {
+          pst->failures.push_back( message );
+        }
+        ok = false;
+      }
+    }
+  }
+
+  if ( pst )
+  {
+    ++pst->num_passes;
+  }
+  return ok;
+}
+
+} // namespace mockturtle
@@ -23,6 +23,8 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <numeric>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -35,6 +37,7 @@
 #include <mockturtle/algorithms/xmg_optimization.hpp>
 #include <mockturtle/algorithms/cut_rewriting.hpp>
 #include <mockturtle/algorithms/node_resynthesis/xmg3_npn.hpp>
+#include <mockturtle/algorithms/node_resynthesis/xmg4_npn.hpp>
 #include <mockturtle/io/aiger_reader.hpp>
 #include <mockturtle/io/verilog_reader.hpp>
 #include <mockturtle/io/blif_reader.hpp>
@@ -46,14 +49,113 @@
 #include <mockturtle/views/topo_view.hpp>
 
 
+#include <convergence.hpp>
 #include <experiments.hpp>
+#include <golden_signatures.hpp>
+#include <network_pool.hpp>
+#include <profiling.hpp>
+#include <task_graph.hpp>
+#include <xmg_choice_mapping.hpp>
+#include <xmg_local_verification.hpp>
+#include <xmg_partition.hpp>
+#include <xmg_profile.hpp>
 
-int main()
+/*! \brief Alternates rewriting and resubstitution until `es_ps` stops the loop (by default, once an iteration improves the size by at most 0.5%)
+ *
+ * If `pass_time` is given, the time spent in the rewriting and resubstitution passes is added to it,
+ * which has the same scope as the rw/rs runtime of the monolithic flow.
+ */
+uint32_t rw_rs_flow( mockturtle::xmg_network& xmg, mockturtle::cut_rewriting_params const& cr_ps, mockturtle::resubstitution_params const& resub_ps,
+                     experiments::early_stopping_params const& es_ps = {}, double* pass_time = nullptr )
+{
+  experiments::early_stopping stopping( es_ps );
+  uint32_t num_iters = 0u;
+  do
+  {
+    ++num_iters;
+    auto const size_before = xmg.num_gates();
+
+    if ( stopping.run( "rewriting" ) )
+    {
+      auto const size_before_rw = xmg.num_gates();
+      mockturtle::cut_rewriting_stats cr_st;
+      mockturtle::xmg3_npn_resynthesis<mockturtle::xmg_network> resyn;
+      mockturtle::cut_rewriting( xmg, resyn, cr_ps, &cr_st );
+      xmg = mockturtle::cleanup_dangling( xmg );
+      stopping.pass_done( "rewriting", size_before_rw, xmg.num_gates(), mockturtle::to_seconds( cr_st.time_total ) );
+      if ( pass_time )
+      {
+        *pass_time += mockturtle::to_seconds( cr_st.time_total );
+      }
+    }
+    if ( stopping.run( "resubstitution" ) )
+    {
+      auto const size_before_rs = xmg.num_gates();
+      mockturtle::resubstitution_stats resub_st;
+      mockturtle::xmg_resubstitution( xmg, resub_ps, &resub_st );
+      xmg = mockturtle::cleanup_dangling( xmg );
+      stopping.pass_done( "resubstitution", size_before_rs, xmg.num_gates(), mockturtle::to_seconds( resub_st.time_total ) );
+      if ( pass_time )
+      {
+        *pass_time += mockturtle::to_seconds( resub_st.time_total );
+      }
+    }
+  } while ( stopping.next_iteration( size_before, xmg.num_gates() ) );
+  return num_iters;
+}
+
+int main( int argc, char** argv )
 {
     using namespace experiments;
     using namespace mockturtle;
+
+  /* `--local-verification` checks each rewriting candidate and resubstitution pass locally
+     and replaces the CEC after every pass by a single CEC at the end of the flow */
+  bool local_verification{false};
+  /* `--choices` records the XMG after every pass of the last run as structural choices
+     and maps them to the genlib together */
+  bool use_choices{false};
+  /* `--early-stop R` skips a pass once it removes less than R times its best number of gates per second,
+     `--predict-stop` stops before an iteration predicted to improve the size by at most 0.5% */
+  /* `--partitions K` also runs the flow on K output partitions in parallel (`--jobs` threads),
+     stitches them, and compares the result with the monolithic flow */
+  uint32_t num_partitions{0u};
+  std::vector<char*> args;
+  for ( auto i = 0; i < argc; ++i )
+  {
+    if ( std::string( argv[i] ) == "--local-verification" )
+    {
+      local_verification = true;
+    }
+    else if ( std::string( argv[i] ) == "--choices" )
+    {
+      use_choices = true;
+    }
+    else if ( std::string( argv[i] ) == "--partitions" && i + 1 < argc )
+    {
+      num_partitions = std::stoul( argv[++i] );
+    }
+    else
+    {
+      args.push_back( argv[i] );
+    }
+  }
+
+  auto const es_ps = parse_early_stopping_params( args );
+  auto const bps = parse_benchmark_params( static_cast<int>( args.size() ), args.data() );
   
-  experiment<std::string, uint32_t, float, std::string, std::string, std::string, float, bool> exp( "xmg_resubstituion", "benchmark", "tot_it", "size_impr", "runtime rw/rs", "sd", " sd'", "area_impr", "equivalent" );
+  experiment<std::string, uint32_t, float, std::string, sample_statistics, std::string, std::string, double, float, double, bool> exp( "xmg_resubstituion", "benchmark", "tot_it", "size_impr", "runtime rw/rs", "runtime", "sd", " sd'", "sd_ratio'", "area_impr", "peak RSS [MB]", "equivalent" );
+  auto exp_phases = make_phase_experiment( "xmg_resubstituion_phases" );
+  auto exp_trace = make_trace_experiment( "xmg_resubstituion_trace" );
+  experiment<std::string, uint32_t, uint32_t, uint32_t, double, float, float, double, double, double, double, double, bool> exp_partitions(
+      "xmg_resubstituion_partitions", "benchmark", "partitions", "size", "size (part)", "size diff [%]", "area", "area (part)", "area diff [%]",
+      "runtime rw/rs", "rw/rs (part)", "overhead (part)", "runtime (part)", "equivalent" );
+  experiment<std::string, uint32_t, float, float, float, uint32_t, uint32_t, bool> exp_choices(
+      "xmg_resubstituion_choices", "benchmark", "snapshots", "area (ABC)", "area (no choices)", "area (choices)", "choice cuts", "gates (choices)", "equivalent" );
+  phase_profiler prof;
+
+  /* the copies made by cleanup_dangling reuse the storage of released XMGs */
+  network_pool<xmg_network> xmg_pool;
 
   for ( auto const& benchmark : epfl_benchmarks() )
   {
@@ -61,11 +163,14 @@ int main()
     //        if( benchmark != "ctrl" ) 
     //    continue;
     fmt::print( "[i] processing {}\n", benchmark );
-    
-    abc_lut_reader_mf ( benchmark );
+    prof.reset();
+
+    prof.measure( "lut mapping", [&]() { abc_lut_reader_mf( benchmark ); } );
 
     klut_network klut;
-    auto result = lorina::read_bench( benchmark_path( benchmark, "_mf_bench", "bench" ), mockturtle::bench_reader( klut ) );
+    auto result = prof.measure( "reading", [&]() {
+      return lorina::read_bench( benchmark_path( benchmark, "_mf_bench", "bench" ), mockturtle::bench_reader( klut ) );
+    } );
     
     if (result == lorina::return_code::parse_error)
     {
@@ -73,24 +178,28 @@ int main()
         continue;
     }
 
-    xmg_network xmg;
+    auto xmg = xmg_pool.acquire( klut.size() );
 
     mockturtle::xmg3_npn_resynthesis<xmg_network> resyn2;
-    mockturtle::node_resynthesis( xmg, klut, resyn2 );
-    const auto cec3 = benchmark == "hyp" ? true : abc_cec( xmg, benchmark );
+    prof.measure( "resynthesis", [&]() { mockturtle::node_resynthesis( xmg, klut, resyn2 ); } );
+    const auto cec3 = benchmark == "hyp" ? true : prof.measure( "cec", [&]() { return golden_cec( xmg, benchmark ); } );
 
     topo_view topo(xmg);
-    xmg = cleanup_dangling(xmg);
-    const auto cec4 = benchmark == "hyp" ? true : abc_cec( xmg, benchmark );
+    prof.measure( "cleanup", [&]() { xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg ) ); } );
+    const auto cec4 = benchmark == "hyp" ? true : prof.measure( "cec", [&]() { return golden_cec( xmg, benchmark ); } );
 
     std::cout << "no of gates in XMG   "  << xmg.num_gates() << std::endl;
 
     //Set the genlib path here used with ABC
     std::string const genlib_path = "/home/shubham/My_work/abc-vlsi-cad-flow/std_libs/date_lib_count_tt_4.genlib";
 
-    float area_before = abc_techmap( xmg, genlib_path );
+    float area_before = prof.measure( "mapping", [&]() { return abc_techmap( xmg, genlib_path ); } );
+
+    /* the trace estimates areas with the same library */
+    std::vector<genlib_gate> trace_gates;
+    xmg_genlib_cost const trace_cost = read_genlib( genlib_path, trace_gates ) ? xmg_genlib_cost( trace_gates ) : xmg_genlib_cost();
+    convergence_trace trace( &trace_cost );
 
-    xmg_cost_params ps1, ps2;
     int32_t size_before, size_after, size_per_iteration;
     uint32_t num_iters = 0;
     float rs = 0;
@@ -114,63 +223,244 @@ int main()
     //cr_ps.progress = true;
 
     std::cout << "Before Optimizations" <<  std::endl; 
-    ps1.reset();
-    num_gate_profile( xmg, ps1 );
-    ps1.report();
-    size_before = xmg.num_gates();
-    double sd_rat = ( double( ps1.actual_maj + ps1.actual_xor3 )/  size_before ) * 100;
-    std::string sd_before = fmt::format( "{}/{} = {}", ( ps1.actual_maj + ps1.actual_xor3 ),  size_before, sd_rat);
-    float total_imp;
-
-    do 
-    {
-        num_iters++;
-        size_per_iteration = xmg.num_gates();
+    auto const profile_before = profile_xmg( xmg );
+    profile_before.report();
+    size_before = profile_before.num_gates;
+    double sd_rat = profile_before.self_dual_ratio() * 100;
+    std::string sd_before = fmt::format( "{}/{} = {}", ( profile_before.actual_maj + profile_before.actual_xor3 ),  size_before, sd_rat);
 
-        xmg3_npn_resynthesis<xmg_network> resyn;
-        cut_rewriting( xmg, resyn, cr_ps, &cr_st );
-        xmg = cleanup_dangling( xmg );
+    local_verification_params lv_ps;
+    local_verification_stats lv_st;
 
-        const auto cec2 = benchmark == "hyp" ? true : abc_cec( xmg, benchmark );
+    /* every run starts from the same XMG, only the last run is verified */
+    auto const xmg_start = xmg_pool.cleanup_dangling( xmg );
+    std::optional<xmg_choice_network> choices;
+    uint32_t run = 0u;
+    auto const runtime_stats = repeat( bps, [&]() {
+      bool const verify = ++run == bps.num_runs() && benchmark != "hyp";
+      xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg_start ) );
+      if ( use_choices && run == bps.num_runs() )
+      {
+        choices.emplace( xmg );
+      }
+      num_iters = 0;
+      rw = 0;
+      rs = 0;
+      equiv = true;
+      early_stopping stopping( es_ps );
+      trace.clear();
 
-        xmg_resubstitution(xmg, resub_ps, &resub_st);
-        xmg = cleanup_dangling( xmg );
-    
-        const auto cec = benchmark == "hyp" ? true : abc_cec( xmg, benchmark );
+      do 
+      {
+          num_iters++;
+          size_per_iteration = xmg.num_gates();
 
-        if (size_per_iteration == 0u)
-          total_imp = 0;
-        else
-        {
-          int diff = size_per_iteration - xmg.num_gates();
-          total_imp = 100 * (double(std::abs(diff))/size_per_iteration);
-        }
-        
-        rw += to_seconds( cr_st.time_total );
-        rs += to_seconds( resub_st.time_total );
-        equiv &= cec2 & cec;
-        std::cout << "eqivalent before " << cec3 << "equivalence after topp " << cec4 << " equivalence check after rs  " << cec2  << " after rw " << cec << std::endl;
+          bool cec2 = true;
+          if ( stopping.run( "rewriting" ) )
+          {
+            xmg3_npn_resynthesis<xmg_network> resyn;
+            if ( verify && local_verification )
+            {
+              /* wrong candidates are logged and never committed */
+              verified_resynthesis<decltype( resyn )> verified_resyn( resyn, lv_ps, &lv_st );
+              prof.measure( "rewriting", [&]() { cut_rewriting( xmg, verified_resyn, cr_ps, &cr_st ); } );
+            }
+            else
+            {
+              prof.measure( "rewriting", [&]() { cut_rewriting( xmg, resyn, cr_ps, &cr_st ); } );
+            }
+            prof.measure( "cleanup", [&]() { xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg ) ); } );
+            if ( choices )
+            {
+              prof.measure( "choices", [&]() { choices->add( xmg ); } );
+            }
+
+            cec2 = !verify || local_verification ? true : prof.measure( "cec", [&]() { return golden_cec( xmg, benchmark ); } );
+
+            rw += to_seconds( cr_st.time_total );
+            stopping.pass_done( "rewriting", size_per_iteration, xmg.num_gates(), to_seconds( cr_st.time_total ) );
+            trace.add( num_iters, "rewriting", xmg, to_seconds( cr_st.time_total ) );
+          }
 
-    } while ( total_imp > 0.5 );
+          bool cec = true;
+          if ( stopping.run( "resubstitution" ) )
+          {
+            std::vector<std::vector<uint64_t>> signatures;
+            if ( verify && local_verification )
+            {
+              signatures = prof.measure( "local verification", [&]() { return output_signatures( xmg, lv_ps ); } );
+            }
+
+            auto const size_before_rs = xmg.num_gates();
+            prof.measure( "resubstitution", [&]() { xmg_resubstitution( xmg, resub_ps, &resub_st ); } );
+            prof.measure( "cleanup", [&]() { xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg ) ); } );
+            if ( choices )
+            {
+              prof.measure( "choices", [&]() { choices->add( xmg ); } );
+            }
+
+            cec = !verify ? true : ( local_verification ? prof.measure( "local verification", [&]() { return check_output_signatures( "resubstitution", signatures, xmg, lv_ps, &lv_st ); } )
+                                                        : prof.measure( "cec", [&]() { return golden_cec( xmg, benchmark ); } ) );
+
+            rs += to_seconds( resub_st.time_total );
+            stopping.pass_done( "resubstitution", size_before_rs, xmg.num_gates(), to_seconds( resub_st.time_total ) );
+            trace.add( num_iters, "resubstitution", xmg, to_seconds( resub_st.time_total ) );
+          }
+
+          auto const& last = trace.records().back();
+          fmt::print( "[i] iteration {}: {} gates, {:.2f}% self-dual, area {:.2f}\n", num_iters, last.size, 100 * last.sd_ratio, last.area );
+
+          equiv &= cec2 & cec;
+          std::cout << "eqivalent before " << cec3 << "equivalence after topp " << cec4 << " equivalence check after rs  " << cec2  << " after rw " << cec << std::endl;
+
+      } while ( stopping.next_iteration( size_per_iteration, xmg.num_gates() ) );
+
+      /* local checks only detect wrong replacements, the final CEC proves equivalence */
+      if ( verify && local_verification )
+      {
+        lv_st.report();
+        equiv &= prof.measure( "cec", [&]() { return golden_cec( xmg, benchmark ); } );
+      }
+
+      return double( rw + rs );
+    } );
 
     size_after = xmg.num_gates();
     float final_improvement = ( double( std::abs( int( size_after - size_before ) ) ) / size_before ) * 100 ;
 
     std::cout << "After Optimizations" <<  std::endl; 
-    ps2.reset();
-    num_gate_profile( xmg, ps2);
-    ps2.report();
-    sd_rat = ( double( ps2.actual_maj + ps2.actual_xor3 )/  size_after ) * 100;
-    std::string sd_after = fmt::format( "{}/{} = {}", ( ps2.actual_maj + ps2.actual_xor3 ),  size_after, sd_rat );
+    auto const profile_after = profile_xmg( xmg );
+    profile_after.report();
+    sd_rat = profile_after.self_dual_ratio() * 100;
+    std::string sd_after = fmt::format( "{}/{} = {}", ( profile_after.actual_maj + profile_after.actual_xor3 ),  size_after, sd_rat );
     
-    auto area_after= abc_techmap( xmg, genlib_path );
+    auto area_after = prof.measure( "mapping", [&]() { return abc_techmap( xmg, genlib_path ); } );
     float area_imp = ( ( area_before - area_after ) / area_before ) * 100 ; 
 
+    /* one mapping pass over the choices of all passes against mapping only the final XMG */
+    if ( choices )
+    {
+      /* rewriting with the xmg4 database (if available) contributes the structures of a second NPN database */
+      xmg_network db;
+      auto const db_path = experiments_file_path( "xmg_without_sd.v" );
+      if ( lorina::read_verilog( db_path, verilog_reader( db ) ) != lorina::return_code::success )
+      {
+        fmt::print( "[w] could not read xmg4 database {}, the choices contain no xmg4 rewriting\n", db_path );
+      }
+      else
+      {
+        xmg4_npn_resynthesis<xmg_network> resyn4( mockturtle::detail::to_index_list( db ) );
+        auto xmg4 = xmg_pool.cleanup_dangling( xmg_start );
+        prof.measure( "rewriting", [&]() { cut_rewriting( xmg4, resyn4, cr_ps ); } );
+        prof.measure( "choices", [&]() { choices->add( xmg_pool.cleanup_dangling( xmg4 ) ); } );
+      }
+
+      std::vector<genlib_gate> gates;
+      if ( !read_genlib( genlib_path, gates ) )
+      {
+        fmt::print( "[e] could not read genlib {}\n", genlib_path );
+      }
+      else
+      {
+        genlib_cut_library const library( gates );
+        xmg_choice_stats choice_st;
+        prof.measure( "choices", [&]() { choices->compute_choices( {}, &choice_st ); } );
+        choice_st.report();
+
+        /* both covers are emitted as k-LUT netlists of library gates and checked against the golden benchmark */
+        choice_mapping_params map_ps;
+        choice_mapping_stats map_st_final, map_st;
+        klut_network mapped_final, mapped_choices;
+        auto const area_final = prof.measure( "choice mapping", [&]() { return map_with_choices( xmg_choice_network( xmg ), library, mapped_final, map_ps, &map_st_final ); } );
+        auto const area_choices = prof.measure( "choice mapping", [&]() { return map_with_choices( *choices, library, mapped_choices, map_ps, &map_st ); } );
+        auto const cec_choices = benchmark == "hyp" ? true : prof.measure( "cec", [&]() {
+          return abc_cec_blif( mapped_final, benchmark ) && abc_cec_blif( mapped_choices, benchmark );
+        } );
+        exp_choices( benchmark, choices->num_snapshots(), area_after, area_final, area_choices, map_st.num_choice_cuts, mapped_choices.num_gates(), cec_choices );
+      }
+    }
+
+    /* partitions are optimized from the same start XMG in parallel; `rw/rs (part)` sums the pass times of all partitions
+       (the scope of `runtime rw/rs`), `overhead (part)` is the time for partitioning, extraction, and stitching,
+       and `runtime (part)` is the wall time of the whole partitioned flow */
+    if ( num_partitions != 0u )
+    {
+      stopwatch<>::duration partition_time{0};
+      stopwatch<>::duration overhead_time{0};
+      std::vector<double> pass_times;
+      xmg_network stitched;
+      prof.measure( "partitioned flow", [&]() {
+        stopwatch t( partition_time );
+
+        std::vector<std::vector<uint32_t>> outputs;
+        std::vector<xmg_network> parts;
+        {
+          stopwatch t_overhead( overhead_time );
+          xmg_partition_params part_ps;
+          part_ps.num_partitions = num_partitions;
+          xmg_partition_stats part_st;
+          outputs = partition_outputs( xmg_start, part_ps, &part_st );
+          part_st.report();
+
+          /* extraction traverses the shared start XMG, so only the flows run concurrently */
+          for ( auto const& o : outputs )
+          {
+            parts.push_back( extract_partition( xmg_start, o ) );
+          }
+        }
+
+        pass_times.assign( parts.size(), 0.0 );
+        task_graph tasks;
+        for ( auto p = 0u; p < parts.size(); ++p )
+        {
+          tasks.add( [&, p]() { rw_rs_flow( parts[p], cr_ps, resub_ps, es_ps, &pass_times[p] ); } );
+        }
+        tasks.run( bps.jobs );
+
+        stopwatch t_overhead( overhead_time );
+        stitched = cleanup_dangling( stitch_partitions( parts, outputs, xmg_start.num_pis(), xmg_start.num_pos() ) );
+      } );
+
+      auto const area_partitioned = prof.measure( "mapping", [&]() { return abc_techmap( stitched, genlib_path ); } );
+      auto const cec_partitioned = benchmark == "hyp" ? true : prof.measure( "cec", [&]() { return golden_cec( stitched, benchmark ); } );
+      exp_partitions( benchmark, num_partitions, size_after, stitched.num_gates(),
+                      100.0 * ( double( stitched.num_gates() ) - size_after ) / std::max( size_after, 1 ),
+                      area_after, area_partitioned, 100.0 * ( area_partitioned - area_after ) / area_after,
+                      rw + rs, std::accumulate( pass_times.begin(), pass_times.end(), 0.0 ), to_seconds( overhead_time ),
+                      to_seconds( partition_time ), cec_partitioned );
+    }
+
     std::string rt = fmt::format( " {:>5.2f} / {:>5.2f}" , rw, rs  );
-    exp ( benchmark, num_iters, final_improvement, rt, sd_before, sd_after, area_imp, equiv );
+    exp ( benchmark, num_iters, final_improvement, rt, runtime_stats, sd_before, sd_after, sd_rat, area_imp, prof.peak_rss_mb(), equiv );
+    add_phases( exp_phases, benchmark, prof );
+    add_trace( exp_trace, benchmark, trace );
   }
   
+  golden_signatures().stats().report();
+
   exp.save();
   exp.table();
+  exp_phases.save();
+  exp_phases.table();
+  exp_trace.save();
+  exp_trace.table();
+  if ( use_choices )
+  {
+    exp_choices.save();
+    exp_choices.table();
+  }
+  if ( num_partitions != 0u )
+  {
+    exp_partitions.save();
+    exp_partitions.table();
+  }
+
+  if ( !bps.baseline.empty() )
+  {
+    return exp.check_regressions( bps.baseline, {{"runtime", false, bps.threshold},
+                                                 {"size_impr", true, 0.0},
+                                                 {"area_impr", true, 0.0},
+                                                 {"sd_ratio'", true, 0.0}} ) == 0u ? 0 : 1;
+  }
   return 0;
 }
@@ -0,0 +1,339 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file xmg_partition.hpp
+  \brief Partitioning of an XMG into output cones and stitching
+
+  `partition_outputs` clusters the primary outputs into balanced partitions
+  such that outputs whose cones overlap share a partition.  Outputs are
+  assigned in order of decreasing cone size to the partition that already
+  contains most of their cone, as long as the partition stays below
+  `ps.balance` times the average partition size.  Logic shared between
+  partitions is duplicated.
+
+  `extract_partition` copies the cones of a partition into a standalone XMG
+  with all primary inputs of the network, so that partitions can be
+  optimized independently, and `stitch_partitions` copies the optimized
+  partitions back into one structurally hashed XMG, which merges logic that
+  is equal across partition boundaries.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+namespace mockturtle
+{
+
+struct xmg_partition_params
+{
+  /*! \brief Number of partitions (at most 64). */
+  uint32_t num_partitions{4u};
+
+  /*! \brief Maximum partition size relative to the average partition size. */
+  double balance{1.2};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct xmg_partition_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of non-empty partitions. */
+  uint32_t num_partitions{0u};
+
+  /*! \brief Number of gates in the largest partition. */
+  uint32_t max_partition_size{0u};
+
+  /*! \brief Gates in all partitions over gates in the network. */
+  double duplication{0.0};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] partitions = {}, largest partition = {} gates, duplication = {:.2f}\n", num_partitions, max_partition_size, duplication );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", to_seconds( time_total ) );
+  }
+};
+
+namespace detail
+{
+
+class xmg_partition_impl
+{
+public:
+  using node = xmg_network::node;
+
+  xmg_partition_impl( xmg_network const& ntk, xmg_partition_params const& ps, xmg_partition_stats& st )
+      : ntk( ntk ), ps( ps ), st( st ), stamps( ntk.size(), 0u ), masks( ntk.size(), 0u )
+  {
+  }
+
+  std::vector<std::vector<uint32_t>> run()
+  {
+    stopwatch t( st.time_total );
+
+    auto const k = std::clamp( ps.num_partitions, 1u, 64u );
+    std::vector<uint32_t> cone_sizes( ntk.num_pos() );
+    std::vector<node> roots;
+    ntk.foreach_po( [&]( auto const& f, auto i ) {
+      roots.push_back( ntk.get_node( f ) );
+      cone_sizes[i] = static_cast<uint32_t>( cone( roots.back() ).size() );
+    } );
+
+    std::vector<uint32_t> order( ntk.num_pos() );
+    std::iota( order.begin(), order.end(), 0u );
+    std::stable_sort( order.begin(), order.end(), [&]( auto a, auto b ) { return cone_sizes[a] > cone_sizes[b]; } );
+
+    auto const capacity = ps.balance * ntk.num_gates() / k;
+    std::vector<std::vector<uint32_t>> outputs( k );
+    std::vector<uint32_t> sizes( k, 0u );
+    std::vector<uint32_t> overlap( k );
+    for ( auto const o : order )
+    {
+      auto const& cone_gates = cone( roots[o] );
+      std::fill( overlap.begin(), overlap.end(), 0u );
+      for ( auto const g : cone_gates )
+      {
+        for ( auto mask = masks[g]; mask != 0u; mask &= mask - 1u )
+        {
+          ++overlap[__builtin_ctzll( mask )];
+        }
+      }
+
+      /* the partition with the largest overlap that keeps its capacity, the smallest growth otherwise */
+      auto const cone_size = static_cast<uint32_t>( cone_gates.size() );
+      auto best = k;
+      for ( auto p = 0u; p < k; ++p )
+      {
+        if ( sizes[p] + cone_size - overlap[p] > capacity )
+          continue;
+        if ( best == k || overlap[p] > overlap[best] || ( overlap[p] == overlap[best] && sizes[p] < sizes[best] ) )
+          best = p;
+      }
+      if ( best == k )
+      {
+        best = 0u;
+        for ( auto p = 1u; p < k; ++p )
+        {
+          if ( sizes[p] + cone_size - overlap[p] < sizes[best] + cone_size - overlap[best] )
+            best = p;
+        }
+      }
+
+      for ( auto const g : cone_gates )
+      {
+        masks[g] |= uint64_t( 1 ) << best;
+      }
+      sizes[best] += cone_size - overlap[best];
+      outputs[best].push_back( o );
+    }
+
+    /* partitions keep the order of their outputs in the network */
+    std::vector<std::vector<uint32_t>> partitions;
+    for ( auto p = 0u; p < k; ++p )
+    {
+      if ( outputs[p].empty() )
+        continue;
+      std::sort( outputs[p].begin(), outputs[p].end() );
+      partitions.push_back( std::move( outputs[p] ) );
+      st.max_partition_size = std::max( st.max_partition_size, sizes[p] );
+    }
+    st.num_partitions = static_cast<uint32_t>( partitions.size() );
+    st.duplication = ntk.num_gates() == 0u ? 1.0 : double( std::accumulate( sizes.begin(), sizes.end(), uint64_t( 0 ) ) ) / ntk.num_gates();
+    return partitions;
+  }
+
+private:
+  /* gates in the transitive fanin of n (including n) */
+  std::vector<uint32_t> const& cone( node const& root )
+  {
+    ++stamp;
+    gates.clear();
+    stack.clear();
+    stack.push_back( root );
+    while ( !stack.empty() )
+    {
+      auto const n = stack.back();
+      stack.pop_back();
+      auto const index = ntk.node_to_index( n );
+      if ( stamps[index] == stamp || ntk.is_constant( n ) || ntk.is_pi( n ) )
+        continue;
+      stamps[index] = stamp;
+      gates.push_back( index );
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        stack.push_back( ntk.get_node( fi ) );
+      } );
+    }
+    return gates;
+  }
+
+private:
+  xmg_network const& ntk;
+  xmg_partition_params const& ps;
+  xmg_partition_stats& st;
+
+  uint32_t stamp{0u};
+  std::vector<uint32_t> stamps;
+
+  /* partitions that contain a gate */
+  std::vector<uint64_t> masks;
+
+  std::vector<uint32_t> gates;
+  std::vector<node> stack;
+};
+
+/* copies the gates of `ntk` with `keep` set into `dest` (all gates if `keep` is empty) */
+inline void copy_gates( xmg_network const& ntk, xmg_network& dest, node_map<xmg_network::signal, xmg_network>& old2new, std::vector<uint8_t> const& keep = {} )
+{
+  old2new[ntk.get_node( ntk.get_constant( false ) )] = dest.get_constant( false );
+  ntk.foreach_pi( [&]( auto const& n, auto i ) {
+    old2new[n] = dest.make_signal( dest.pi_at( i ) );
+  } );
+
+  topo_view<xmg_network>{ntk}.foreach_gate( [&]( auto const& n ) {
+    if ( !keep.empty() && !keep[ntk.node_to_index( n )] )
+    {
+      return;
+    }
+    std::array<xmg_network::signal, 3> children;
+    ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+      children[i] = old2new[ntk.get_node( fi )] ^ ntk.is_complemented( fi );
+    } );
+    old2new[n] = ntk.is_xor3( n ) ? dest.create_xor3( children[0], children[1], children[2] ) : dest.create_maj( children[0], children[1], children[2] );
+  } );
+}
+
+} // namespace detail
+
+/*! \brief Clusters the primary outputs of `ntk` into balanced partitions of overlapping cones
+ *
+ * Returns the output indices of every non-empty partition in increasing order.
+ */
+inline std::vector<std::vector<uint32_t>> partition_outputs( xmg_network const& ntk, xmg_partition_params const& ps = {}, xmg_partition_stats* pst = nullptr )
+{
+  xmg_partition_stats st;
+  detail::xmg_partition_impl p( ntk, ps, st );
+  auto const partitions = p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return partitions;
+}
+
+/*! \brief XMG with all primary inputs of `ntk` and the cones of `outputs` as primary outputs */
+inline xmg_network extract_partition( xmg_network const& ntk, std::vector<uint32_t> const& outputs )
+{
+  std::vector<uint8_t> keep( ntk.size(), 0u );
+  std::vector<xmg_network::node> stack;
+  for ( auto const o : outputs )
+  {
+    stack.push_back( ntk.get_node( ntk.po_at( o ) ) );
+  }
+  while ( !stack.empty() )
+  {
+    auto const n = stack.back();
+    stack.pop_back();
+    if ( keep[ntk.node_to_index( n )] || ntk.is_constant( n ) || ntk.is_pi( n ) )
+      continue;
+    keep[ntk.node_to_index( n )] = 1u;
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      stack.push_back( ntk.get_node( fi ) );
+    } );
+  }
+
+  xmg_network part;
+  ntk.foreach_pi( [&]( auto const& ) {
+    part.create_pi();
+  } );
+  node_map<xmg_network::signal, xmg_network> old2new( ntk );
+  detail::copy_gates( ntk, part, old2new, keep );
+  for ( auto const o : outputs )
+  {
+    auto const f = ntk.po_at( o );
+    part.create_po( old2new[ntk.get_node( f )] ^ ntk.is_complemented( f ) );
+  }
+  return part;
+}
+
+/*! \brief Copies the (optimized) partitions back into one XMG with `num_pis` inputs and `num_pos` outputs
+ *
+ * `outputs[p]` are the output indices that the outputs of `partitions[p]`
+ * drive in the stitched network.
+ */
+inline xmg_network stitch_partitions( std::vector<xmg_network> const& partitions, std::vector<std::vector<uint32_t>> const& outputs, uint32_t num_pis, uint32_t num_pos )
+{
+  assert( partitions.size() == outputs.size() );
+
+  xmg_network ntk;
+  for ( auto i = 0u; i < num_pis; ++i )
+  {
+    ntk.create_pi();
+  }
+
+  std::vector<xmg_network::signal> pos( num_pos, ntk.get_constant( false ) );
+  for ( auto p = 0u; p < partitions.size(); ++p )
+  {
+    auto const& part = partitions[p];
+    assert( part.num_pis() == num_pis && part.num_pos() == outputs[p].size() );
+
+    node_map<xmg_network::signal, xmg_network> old2new( part );
+    detail::copy_gates( part, ntk, old2new );
+    part.foreach_po( [&]( auto const& f, auto i ) {
+      pos[outputs[p][i]] = old2new[part.get_node( f )] ^ part.is_complemented( f );
+    } );
+  }
+
+  for ( auto const& f : pos )
+  {
+    ntk.create_po( f );
+  }
+  return ntk;
+}
+
+} // namespace mockturtle
@@ -0,0 +1,282 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_profile.hpp
+  \brief Gate mix, self-dual ratio, depth and fanout of an XMG in one pass
+
+  `profile_xmg` replaces separate calls to `num_gate_profile`, `num_gates`,
+  and `depth_view` by a single sweep over the node storage.  The light
+  variant `profile_xmg_gates` only counts gates and is cheap enough to be
+  called after every optimization iteration.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+
+namespace mockturtle
+{
+
+struct xmg_profile_params
+{
+  /*! \brief Compute logic depth. */
+  bool compute_depth{true};
+
+  /*! \brief Compute fanout histogram. */
+  bool compute_fanout{true};
+
+  /*! \brief Nodes with this or a larger fanout share the last histogram bucket. */
+  uint32_t max_fanout_bucket{16u};
+};
+
+struct xmg_profile
+{
+  uint32_t num_gates{0u};
+
+  /*! \brief MAJ gates with three non-constant fanins (self-dual). */
+  uint32_t actual_maj{0u};
+
+  /*! \brief MAJ gates with a constant fanin, i.e., AND/OR gates. */
+  uint32_t and_or{0u};
+
+  /*! \brief XOR3 gates with three non-constant fanins (self-dual). */
+  uint32_t actual_xor3{0u};
+
+  /*! \brief XOR3 gates with a constant fanin, i.e., XOR2 gates. */
+  uint32_t xor2{0u};
+
+  /*! \brief Complemented fanin edges of gates. */
+  uint32_t complemented_edges{0u};
+
+  /*! \brief Complemented primary outputs. */
+  uint32_t complemented_pos{0u};
+
+  /*! \brief Logic depth (only if `compute_depth` is set). */
+  uint32_t depth{0u};
+
+  /*! \brief Number of nodes (PIs and gates) per fanout size (only if `compute_fanout` is set). */
+  std::vector<uint32_t> fanout_histogram;
+
+  uint32_t max_fanout{0u};
+
+  uint32_t total_maj() const
+  {
+    return actual_maj + and_or;
+  }
+
+  uint32_t total_xor3() const
+  {
+    return actual_xor3 + xor2;
+  }
+
+  /*! \brief Ratio of self-dual gates (MAJ3 and XOR3) to all gates */
+  double self_dual_ratio() const
+  {
+    return num_gates == 0u ? 0.0 : double( actual_maj + actual_xor3 ) / num_gates;
+  }
+
+  /*! \brief Ratio of MAJ3, XOR3, and XOR2 gates to all gates (as counted by the RFET experiments) */
+  double self_dual_ratio_with_xor2() const
+  {
+    return num_gates == 0u ? 0.0 : double( actual_maj + actual_xor3 + xor2 ) / num_gates;
+  }
+
+  void report( std::ostream& os = std::cout ) const
+  {
+    os << fmt::format( "[i] gates     = {:>8d}   depth = {:>5d}\n", num_gates, depth );
+    os << fmt::format( "[i] MAJ3      = {:>8d}   AND/OR = {:>8d}\n", actual_maj, and_or );
+    os << fmt::format( "[i] XOR3      = {:>8d}   XOR2   = {:>8d}\n", actual_xor3, xor2 );
+    os << fmt::format( "[i] self-dual = {:>8.2f}%  compl. edges = {} (+{} POs)\n", 100.0 * self_dual_ratio(), complemented_edges, complemented_pos );
+    if ( !fanout_histogram.empty() )
+    {
+      os << "[i] fanout histogram:";
+      for ( auto i = 0u; i < fanout_histogram.size(); ++i )
+      {
+        if ( fanout_histogram[i] == 0u )
+        {
+          continue;
+        }
+        os << fmt::format( " {}{}:{}", i, i + 1u == fanout_histogram.size() ? "+" : "", fanout_histogram[i] );
+      }
+      os << fmt::format( " (max {})\n", max_fanout );
+    }
+  }
+};
+
+namespace detail
+{
+
+/* fallback for networks whose storage is not topologically sorted (after in-place substitutions) */
+inline uint32_t xmg_depth_dfs( xmg_network const& xmg, std::vector<uint32_t>& levels )
+{
+  std::vector<uint8_t> done( xmg.size(), 0u );
+  std::vector<std::pair<xmg_network::node, bool>> stack;
+
+  uint32_t depth{0u};
+  xmg.foreach_po( [&]( auto const& f ) {
+    stack.emplace_back( xmg.get_node( f ), false );
+    while ( !stack.empty() )
+    {
+      auto const [n, expanded] = stack.back();
+      stack.pop_back();
+      auto const index = xmg.node_to_index( n );
+      if ( done[index] )
+      {
+        continue;
+      }
+      if ( xmg.is_constant( n ) || xmg.is_pi( n ) )
+      {
+        levels[index] = 0u;
+        done[index] = 1u;
+        continue;
+      }
+      if ( expanded )
+      {
+        uint32_t level{0u};
+        xmg.foreach_fanin( n, [&]( auto const& fi ) {
+          level = std::max( level, levels[xmg.node_to_index( xmg.get_node( fi ) )] );
+        } );
+        levels[index] = level + 1u;
+        done[index] = 1u;
+        continue;
+      }
+      stack.emplace_back( n, true );
+      xmg.foreach_fanin( n, [&]( auto const& fi ) {
+        if ( !done[xmg.node_to_index( xmg.get_node( fi ) )] )
+        {
+          stack.emplace_back( xmg.get_node( fi ), false );
+        }
+      } );
+    }
+    depth = std::max( depth, levels[xmg.node_to_index( xmg.get_node( f ) )] );
+  } );
+
+  return depth;
+}
+
+} /* namespace detail */
+
+/*! \brief Profiles an XMG in a single pass over its nodes
+ *
+ * Counts MAJ3/XOR3 gates with and without constant fanins, complemented
+ * edges, and optionally computes the logic depth and the fanout histogram in
+ * the same sweep.
+ */
+inline xmg_profile profile_xmg( xmg_network const& xmg, xmg_profile_params const& ps = {} )
+{
+  xmg_profile p;
+
+  std::vector<uint32_t> levels;
+  if ( ps.compute_depth )
+  {
+    levels.resize( xmg.size(), 0u );
+  }
+  if ( ps.compute_fanout )
+  {
+    p.fanout_histogram.resize( ps.max_fanout_bucket + 1u, 0u );
+  }
+
+  bool topological{true};
+  xmg.foreach_node( [&]( auto const& n ) {
+    if ( xmg.is_constant( n ) )
+    {
+      return;
+    }
+
+    if ( ps.compute_fanout )
+    {
+      auto const fanout = xmg.fanout_size( n );
+      p.max_fanout = std::max( p.max_fanout, fanout );
+      ++p.fanout_histogram[std::min( fanout, ps.max_fanout_bucket )];
+    }
+
+    if ( xmg.is_pi( n ) )
+    {
+      return;
+    }
+
+    ++p.num_gates;
+    auto const index = xmg.node_to_index( n );
+    bool has_constant{false};
+    uint32_t level{0u};
+    xmg.foreach_fanin( n, [&]( auto const& fi ) {
+      auto const child = xmg.node_to_index( xmg.get_node( fi ) );
+      has_constant |= xmg.is_constant( xmg.get_node( fi ) );
+      p.complemented_edges += xmg.is_complemented( fi ) ? 1u : 0u;
+      if ( ps.compute_depth )
+      {
+        topological &= child < index;
+        level = std::max( level, levels[child] );
+      }
+    } );
+
+    if ( ps.compute_depth )
+    {
+      levels[index] = level + 1u;
+    }
+
+    if ( xmg.is_maj( n ) )
+    {
+      ++( has_constant ? p.and_or : p.actual_maj );
+    }
+    else if ( xmg.is_xor3( n ) )
+    {
+      ++( has_constant ? p.xor2 : p.actual_xor3 );
+    }
+  } );
+
+  if ( ps.compute_depth && !topological )
+  {
+    p.depth = detail::xmg_depth_dfs( xmg, levels );
+  }
+
+  xmg.foreach_po( [&]( auto const& f ) {
+    p.complemented_pos += xmg.is_complemented( f ) ? 1u : 0u;
+    if ( ps.compute_depth && topological )
+    {
+      p.depth = std::max( p.depth, levels[xmg.node_to_index( xmg.get_node( f ) )] );
+    }
+  } );
+
+  return p;
+}
+
+/*! \brief Gate counts and self-dual ratio only (no depth, no fanout histogram) */
+inline xmg_profile profile_xmg_gates( xmg_network const& xmg )
+{
+  xmg_profile_params ps;
+  ps.compute_depth = false;
+  ps.compute_fanout = false;
+  return profile_xmg( xmg, ps );
+}
+
+} /* namespace mockturtle */
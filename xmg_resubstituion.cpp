@@ -35,19 +35,57 @@
 #include <mockturtle/networks/xmg.hpp>
 
 #include <experiments.hpp>
+#include <golden_signatures.hpp>
+#include <network_pool.hpp>
+#include <xmg_genlib_cost.hpp>
+#include <xmg_profile.hpp>
+#include <xmg_sd_resub.hpp>
 
-int main()
+int main( int argc, char** argv )
 {
   using namespace experiments;
   using namespace mockturtle;
 
-  experiment<std::string, uint32_t, uint32_t, float, bool> exp( "xmg_resubstitution", "benchmark", "size_before", "size_after", "runtime", "equivalent" );
+  /* `--genlib <file>` makes the self-dual resubstitution minimize the library area */
+  std::string genlib;
+  std::vector<char*> args;
+  for ( auto i = 0; i < argc; ++i )
+  {
+    if ( std::string( argv[i] ) == "--genlib" && i + 1 < argc )
+    {
+      genlib = argv[++i];
+    }
+    else
+    {
+      args.push_back( argv[i] );
+    }
+  }
+
+  auto const bps = parse_benchmark_params( static_cast<int>( args.size() ), args.data() );
+
+  xmg_genlib_cost genlib_cost;
+  if ( !genlib.empty() )
+  {
+    std::vector<genlib_gate> gates;
+    if ( !read_genlib( genlib, gates ) )
+    {
+      fmt::print( "[e] could not read genlib {}\n", genlib );
+      return -1;
+    }
+    genlib_cost = xmg_genlib_cost( gates );
+  }
+
+  experiment<std::string, uint32_t, uint32_t, sample_statistics, bool> exp( "xmg_resubstitution", "benchmark", "size_before", "size_after", "runtime", "equivalent" );
+  experiment<std::string, uint32_t, uint32_t, double, double, sample_statistics, bool> exp_sd( "xmg_sd_resubstitution", "benchmark", "size_before", "size_after", "sd_before", "sd_after", "runtime", "equivalent" );
+
+  /* the fresh copy of every run reuses the storage of the previous one */
+  network_pool<xmg_network> xmg_pool;
 
   for ( auto const& benchmark : epfl_benchmarks() )
   {
     fmt::print( "[i] processing {}\n", benchmark );
-    xmg_network xmg;
-    lorina::read_aiger( benchmark_path( benchmark ), aiger_reader( xmg ) );
+    xmg_network xmg_original;
+    lorina::read_aiger( benchmark_path( benchmark ), aiger_reader( xmg_original ) );
 
     resubstitution_params ps;
     resubstitution_stats st;
@@ -58,20 +96,54 @@ int main()
     ps.max_inserts = 1u;  
     ps.use_dont_cares = true; 
     ps.window_size = 12u;  
-    auto const xmg_size_before = xmg.size();
+    const uint32_t size_before = xmg_original.num_gates();
 
-    const uint32_t size_before = xmg.num_gates();
-    xmg_resubstitution( xmg, ps, &st );
+    /* every run starts from a fresh copy of the benchmark */
+    xmg_network xmg;
+    auto const runtime = repeat( bps, [&]() {
+      xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg_original ) );
+      xmg_resubstitution( xmg, ps, &st );
+      return to_seconds( st.time_total );
+    } );
 
-    xmg = cleanup_dangling( xmg );
+    xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg ) );
 
-    const auto cec = benchmark == "hyp" ? true : abc_cec( xmg, benchmark );
+    const auto cec = benchmark == "hyp" ? true : golden_cec( xmg, benchmark );
 
-    exp( benchmark, size_before, xmg.num_gates(), to_seconds( st.time_total ), cec );
+    exp( benchmark, size_before, xmg.num_gates(), runtime, cec );
+
+    /* resubstitution with MAJ3/XOR3 of divisors that favours self-dual gates */
+    xmg_sd_resubstitution_params sd_ps;
+    xmg_sd_resubstitution_stats sd_st;
+    sd_ps.max_pis = 8u;
+    sd_ps.costs = genlib_cost.gate_costs();
+
+    auto const runtime_sd = repeat( bps, [&]() {
+      xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg_original ) );
+      xmg_sd_resubstitution( xmg, sd_ps, &sd_st );
+      return to_seconds( sd_st.time_total );
+    } );
+
+    xmg_pool.replace( xmg, xmg_pool.cleanup_dangling( xmg ) );
+
+    const auto cec_sd = benchmark == "hyp" ? true : golden_cec( xmg, benchmark );
+
+    exp_sd( benchmark, size_before, xmg.num_gates(), profile_xmg_gates( xmg_original ).self_dual_ratio(), profile_xmg_gates( xmg ).self_dual_ratio(), runtime_sd, cec_sd );
   }
 
+  golden_signatures().stats().report();
+
   exp.save();
   exp.table();
+  exp_sd.save();
+  exp_sd.table();
+
+  if ( !bps.baseline.empty() )
+  {
+    auto const regressions = exp.check_regressions( bps.baseline, {{"runtime", false, bps.threshold}, {"size_after", false, 0.0}} ) +
+                             exp_sd.check_regressions( bps.baseline, {{"runtime", false, bps.threshold}, {"size_after", false, 0.0}, {"sd_after", true, 0.0}} );
+    return regressions == 0u ? 0 : 1;
+  }
 
   return 0;
 }
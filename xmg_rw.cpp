@@ -33,12 +33,27 @@
 #include "mockturtle/io/verilog_reader.hpp"
 #include "mockturtle/properties/xmgcost.hpp"
 
+#include "checkpoint.hpp"
+#include "convergence.hpp"
 #include "experiments.hpp"
+#include "golden_signatures.hpp"
+#include "network_pool.hpp"
+#include "profiling.hpp"
+#include "self_duality_sampling.hpp"
+#include "streaming_cut_enumeration.hpp"
+#include "task_graph.hpp"
+#include "xmg_delay_rewriting.hpp"
+#include "xmg_exact.hpp"
+#include "xmg_fraig.hpp"
+#include "xmg_genlib_cost.hpp"
+#include "xmg_profile.hpp"
 
 #include <lorina/lorina.hpp>
 #include <kitty/kitty.hpp>
 #include <fmt/format.h>
 
+#include <optional>
+
 template<typename Ntk>
 bool read_benchmark( Ntk& ntk, std::string const& benchmark, std::string const& path_type = "", std::string const& file_type = "aig" )
 {
@@ -108,7 +123,7 @@ void experiment1( experiment1_params const& ep, std::vector<std::string> const&
     num_gate_profile( xmg, xmg_st );
 
     /* verify results using ABC's CEC command */
-    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::abc_cec( xmg, benchmark, path_type, file_type );
+    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::golden_cec( xmg, benchmark, path_type, file_type );
 
     /* fill benchmark table */
     exp( benchmark,
@@ -179,7 +194,7 @@ void experiment2( experiment2_params const& ep, std::vector<std::string> const&
     num_gate_profile( xmg, xmg_st );
 
     /* verify results using ABC's CEC command */
-    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::abc_cec( xmg, benchmark, path_type, file_type );
+    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::golden_cec( xmg, benchmark, path_type, file_type );
 
     /* fill benchmark table */
     exp( benchmark,
@@ -198,42 +213,41 @@ struct experiment3_params
   uint32_t cut_size{5u};
   uint32_t num_rewrite_times{3u};
   bool verify = true;
+
+  /* cache file for exact synthesis of cuts with more than 4 leaves (rewriting uses 4-cuts if empty) */
+  std::string exact_cache{};
+
+  /* genlib whose gate areas drive rewriting (gate count if empty) */
+  std::string genlib{};
+
+  /* merge equivalent nodes with SAT sweeping before rewriting */
+  bool fraig{false};
+
+  /* estimate self-duality scores from this many sampled gates (exact scores if 0) */
+  uint32_t sd_samples{0u};
+
+  /* error bound for which the sample size needed is reported */
+  double sd_error{0.01};
+
+  /* rewriting stops early under this policy (by default, once a pass does not change the size) */
+  experiments::early_stopping_params early_stopping{0.0};
 };
 
 /*! \brief Quantifies self-duality of a network by assessing how many 3- to 5-feasiable cuts of a node on average represent a self-dual function. */
 template<typename Ntk>
 double quantify_self_duality_using_average_over_cuts( Ntk const& ntk )
 {
-  mockturtle::cut_enumeration_params ps;
+  mockturtle::streaming_cut_enumeration_params ps;
   ps.cut_size = 5;
   ps.cut_limit = 12;
   ps.minimize_truth_table = true;
 
-  mockturtle::cut_enumeration_stats st;
-  auto const cuts = mockturtle::cut_enumeration<Ntk, true>( ntk, ps, &st );
-
+  /* cuts are released as soon as all fanouts of a node have been visited */
   double sum_score = 0.0;
-  ntk.foreach_gate( [&]( auto const& n ) {
-      auto num_self_dual_node_cuts = 0u;
-      auto num_node_cuts = 0u;
-
-      /* foreach cut */
-      for ( auto const& cut : cuts.cuts( ntk.node_to_index( n ) ) )
-      {
-        /* skip trivial cuts */
-        if ( cut->size() < 2 )
-          continue;
-
-        const auto tt = cuts.truth_table( *cut );
-        if ( kitty::is_selfdual( tt ) )
-        {
-          ++num_self_dual_node_cuts;
-        }
-        ++num_node_cuts;
-
-        sum_score += double( num_self_dual_node_cuts ) / num_node_cuts;
-      }
-    });
+  mockturtle::streaming_cut_enumeration( ntk, [&]( auto const& n, auto const& cuts ) {
+      (void)n;
+      sum_score += mockturtle::detail::average_cut_score( cuts );
+    }, ps );
 
   return sum_score / ntk.num_gates();
 }
@@ -242,40 +256,25 @@ double quantify_self_duality_using_average_over_cuts( Ntk const& ntk )
 template<typename Ntk>
 double quantify_self_duality_using_maximum_of_cuts( Ntk const& ntk )
 {
-  mockturtle::cut_enumeration_params ps;
+  mockturtle::streaming_cut_enumeration_params ps;
   ps.cut_size = 5;
   ps.cut_limit = 12;
   ps.minimize_truth_table = true;
 
-  mockturtle::cut_enumeration_stats st;
-  auto const cuts = mockturtle::cut_enumeration<Ntk, true>( ntk, ps, &st );
-
   uint32_t num_self_dual_nodes = 0u;
-  ntk.foreach_gate( [&]( auto const& n ) {
-      bool has_self_dual_node_cut = false;
-      for ( auto const& cut : cuts.cuts( ntk.node_to_index( n ) ) )
-      {
-        /* skip trivial cuts */
-        if ( cut->size() < 2 )
-          continue;
-
-        const auto tt = cuts.truth_table( *cut );
-        if ( kitty::is_selfdual( tt ) )
-        {
-          has_self_dual_node_cut = true;
-        }
-      }
-
-      if ( has_self_dual_node_cut )
+  mockturtle::streaming_cut_enumeration( ntk, [&]( auto const& n, auto const& cuts ) {
+      (void)n;
+      if ( mockturtle::detail::has_self_dual_cut( cuts ) )
       {
         ++num_self_dual_nodes;
       }
-    });
+    }, ps );
 
   return double( num_self_dual_nodes ) / ntk.num_gates();
 }
 
-void experiment3( experiment3_params const& ep, std::vector<std::string> const& benchmarks = experiments::epfl_benchmarks(), std::string const& path_type = "", std::string const& file_type = "aig" )
+/*! \brief Runs experiment #3 and returns the number of regressions against `bps.baseline` (1 if the genlib cannot be read) */
+uint32_t experiment3( experiment3_params const& ep, std::vector<std::string> const& benchmarks = experiments::epfl_benchmarks(), std::string const& path_type = "", std::string const& file_type = "aig", experiments::benchmark_params const& bps = {} )
 {
   std::string const TECHLIB_PATH = "../experiments/techlib/simple.genlib";
 
@@ -283,93 +282,528 @@ void experiment3( experiment3_params const& ep, std::vector<std::string> const&
   std::cout << "EXPERIMENT#3: node_resynthesis, rewriting, and quantify self-duality" << std::endl;
   std::cout << "===========================================================================" << std::endl;
 
-  experiments::experiment<std::string, std::string, std::string, std::string, std::string, std::string, double, double, double, double, bool>
-    exp( "node_resynthesis", "benchmark", "AIG gates [= ANDs]", "XMG gates [= XOR3s + MAJs]",
+  /* EPFL and crypto benchmarks are stored in tables of their own, such that each has its own baseline */
+  experiments::experiment<std::string, std::string, std::string, std::string, std::string, std::string, double, double, double, experiments::sample_statistics, uint32_t, double, double, bool>
+    exp( "node_resynthesis" + path_type, "benchmark", "AIG gates [= ANDs]", "XMG gates [= XOR3s + MAJs]",
          "self-dual AIG (bef)", /* (avg cut-ratio / best cut-ratio) */
          "self-dual XMG (bef)", /* (avg cut-ratio / best cut-ratio) */
          "self-dual (aft)",  /* (node-ratio / avg cut-ratio / best cut-ratio) */
          "area-before", "area-after", "area-improv",
-         "runtime", "equivalent" );
+         "runtime", "XMG gates (aft)", "sd ratio (aft)", bps.jobs == 1u ? "peak RSS [MB]" : "peak RSS (process) [MB]", "equivalent" );
+  auto exp_phases = experiments::make_phase_experiment( "node_resynthesis" + path_type + "_phases" );
+
+  /* the phases of concurrent benchmarks overlap, such that only the peak RSS of the process is meaningful */
+  if ( bps.jobs != 1u )
+  {
+    experiments::shared_phase_profiler::disable_peak_reset();
+  }
+  auto exp_trace = experiments::make_trace_experiment( "node_resynthesis" + path_type + "_trace" );
+
+  /* the copies made by cleanup_dangling reuse the storage of released XMGs */
+  experiments::network_pool<mockturtle::xmg_network> xmg_pool;
+
+  mockturtle::exact_xmg_cache exact_cache( ep.exact_cache );
+  mockturtle::exact_xmg_params exact_ps;
+  exact_ps.conflict_limit = 100000u;
+  mockturtle::exact_xmg_resynthesis<mockturtle::xmg_network> exact_resyn( exact_cache, exact_ps );
+
+  mockturtle::xmg_genlib_cost genlib_cost;
+  if ( !ep.genlib.empty() )
+  {
+    std::vector<mockturtle::genlib_gate> gates;
+    if ( !mockturtle::read_genlib( ep.genlib, gates ) )
+    {
+      /* a run without its library must not pass as free of regressions */
+      fmt::print( "[e] could not read genlib {}\n", ep.genlib );
+      return 1u;
+    }
+    genlib_cost = mockturtle::xmg_genlib_cost( gates );
+  }
+
+  /* rewriting minimizes genlib area if a library is given and gate count otherwise */
+  auto const rewrite = [&]( auto& ntk, auto& rewriting_fn, auto const& rewrite_ps, auto* rewrite_st ) {
+    if ( ep.genlib.empty() )
+    {
+      mockturtle::cut_rewriting( ntk, rewriting_fn, rewrite_ps, rewrite_st );
+    }
+    else
+    {
+      mockturtle::cut_rewriting( ntk, rewriting_fn, rewrite_ps, rewrite_st, genlib_cost );
+    }
+  };
+
+  /* finished stages are checkpointed, `--resume` continues an interrupted sweep */
+  experiments::checkpoint cp( fmt::format( "node_resynthesis{}{}{}", path_type, ep.fraig ? "_fraig" : "", ep.sd_samples != 0u ? "_sampled" : "" ), bps.resume );
+
+  /* scores are exact or estimated from sampled gates with confidence intervals */
+  auto const quantify_self_duality = [&]( auto const& ntk ) {
+    mockturtle::self_duality_scores scores;
+    if ( ep.sd_samples == 0u )
+    {
+      scores.average_over_cuts.value = quantify_self_duality_using_average_over_cuts( ntk );
+      scores.maximum_of_cuts.value = quantify_self_duality_using_maximum_of_cuts( ntk );
+      return scores;
+    }
+
+    mockturtle::self_duality_sampling_params sampling_ps;
+    sampling_ps.num_samples = ep.sd_samples;
+    sampling_ps.error_bound = ep.sd_error;
+    mockturtle::self_duality_sampling_stats sampling_st;
+    scores = mockturtle::estimate_self_duality( ntk, sampling_ps, &sampling_st );
+    fmt::print( "[i] self-duality of {} sampled gates, {} / {} samples needed for +-{}\n", sampling_st.num_samples,
+                scores.average_over_cuts.required_samples, scores.maximum_of_cuts.required_samples, ep.sd_error );
+    return scores;
+  };
+  auto const format_scores = []( mockturtle::self_duality_scores const& scores ) {
+    if ( scores.average_over_cuts.half_width == 0.0 && scores.maximum_of_cuts.half_width == 0.0 )
+    {
+      return fmt::format( "{:3.2f} / {:3.2f}", scores.average_over_cuts.value, scores.maximum_of_cuts.value );
+    }
+    return fmt::format( "{:3.2f}+-{:3.2f} / {:3.2f}+-{:3.2f}", scores.average_over_cuts.value, scores.average_over_cuts.half_width,
+                        scores.maximum_of_cuts.value, scores.maximum_of_cuts.half_width );
+  };
+
+  /* every benchmark is a small task DAG: mapping and scoring of the AIG run
+     next to resynthesis, scoring, mapping, and verification of the final XMG
+     run concurrently, and the next benchmark is read and resynthesized while
+     the current one is rewritten; rewriting is serialized over the benchmarks
+     since the exact synthesis cache is shared, and rows are added in order */
+  struct benchmark_state
+  {
+    std::string benchmark;
+    bool failed{false};
+    bool resynthesized_restored{false};
+    experiments::shared_phase_profiler prof;
+    mockturtle::xmg3_npn_resynthesis<mockturtle::xmg_network> resyn;
+
+    /* every concurrent task works on a copy of its own */
+    mockturtle::aig_network aig, aig_mapping, aig_scoring;
+    mockturtle::xmg_network xmg, xmg_scoring, xmg_mapping, xmg_cec;
+
+    /* results of stage 1, every field is written by a single task */
+    uint32_t aig_gates{0u};
+    double area_before{0.0}, resynthesis_time{0.0};
+    mockturtle::self_duality_scores scores_before, scores_before_xmg;
+    experiments::sample_statistics runtime;
+    experiments::convergence_trace trace;
+    mockturtle::xmg_profile xmg_st;
+    mockturtle::self_duality_scores scores;
+    double area_after{0.0};
+    bool cec{true};
+  };
+  std::vector<std::unique_ptr<benchmark_state>> states;
+
+  experiments::task_graph tasks;
+  std::vector<experiments::task_graph::task_id> read_tasks, rewrite_tasks, row_tasks;
+  auto const previous = []( auto const& ids, std::size_t distance ) {
+    return ids.size() >= distance ? std::vector<experiments::task_graph::task_id>{ids[ids.size() - distance]} : std::vector<experiments::task_graph::task_id>{};
+  };
+  auto const concat = []( std::vector<experiments::task_graph::task_id> a, std::vector<experiments::task_graph::task_id> const& b ) {
+    a.insert( a.end(), b.begin(), b.end() );
+    return a;
+  };
+
   for ( auto const& benchmark : benchmarks )
   {
-    fmt::print( "[i] processing {}\n", benchmark );
+    auto& s = *states.emplace_back( std::make_unique<benchmark_state>() );
+    s.benchmark = benchmark;
+    s.trace = experiments::convergence_trace( &genlib_cost );
 
-    /* read the benchmarks */
-    mockturtle::aig_network aig;
-    if ( !read_benchmark( aig, benchmark, path_type, file_type ) )
+    if ( cp.has_rows( benchmark, exp ) )
+    {
+      row_tasks.push_back( tasks.add( [&]() {
+        fmt::print( "[i] restored {} from checkpoint\n", s.benchmark );
+        cp.restore_rows( s.benchmark, exp );
+        cp.restore_rows( s.benchmark, exp_phases );
+        cp.restore_rows( s.benchmark, exp_trace );
+      }, previous( row_tasks, 1u ) ) );
       continue;
+    }
+
+    /* stage 1: node resynthesis of the AIG into an XMG */
+    auto const read = tasks.add( [&]() {
+      fmt::print( "[i] processing {}\n", s.benchmark );
+      s.xmg = xmg_pool.acquire();
+      nlohmann::json resynthesized;
+      if ( cp.load_stage( s.benchmark, "resynthesized", s.xmg, resynthesized ) )
+      {
+        s.resynthesized_restored = true;
+        s.aig_gates = resynthesized["aig_gates"].get<uint32_t>();
+        s.area_before = resynthesized["area_before"].get<double>();
+        s.resynthesis_time = resynthesized["resynthesis_time"].get<double>();
+        s.scores_before.average_over_cuts = {resynthesized["score1_before"].get<double>(), resynthesized.value( "score1_before_ci", 0.0 )};
+        s.scores_before.maximum_of_cuts = {resynthesized["score2_before"].get<double>(), resynthesized.value( "score2_before_ci", 0.0 )};
+        s.scores_before_xmg.average_over_cuts = {resynthesized["score1_before_xmg"].get<double>(), resynthesized.value( "score1_before_xmg_ci", 0.0 )};
+        s.scores_before_xmg.maximum_of_cuts = {resynthesized["score2_before_xmg"].get<double>(), resynthesized.value( "score2_before_xmg_ci", 0.0 )};
+        return;
+      }
+      if ( !s.prof.measure( "reading", [&]() { return read_benchmark( s.aig, s.benchmark, path_type, file_type ); } ) )
+      {
+        s.failed = true;
+        xmg_pool.release( std::move( s.xmg ) );
+        return;
+      }
+      s.aig_mapping = mockturtle::cleanup_dangling( s.aig );
+      s.aig_scoring = mockturtle::cleanup_dangling( s.aig );
+    }, concat( previous( read_tasks, 1u ), previous( row_tasks, 2u ) ) );
+    read_tasks.push_back( read );
+
+    auto const stage1 = [&]( auto&& fn ) {
+      return [&s, fn]() {
+        if ( !s.failed && !s.resynthesized_restored )
+        {
+          fn();
+        }
+      };
+    };
 
     /* technology mapping on the initial benchmark */
-    double const area_before = experiments::abc_techmap( aig, TECHLIB_PATH );
+    auto const premap = tasks.add( stage1( [&]() {
+      s.area_before = s.prof.measure( "mapping", [&]() { return experiments::abc_techmap( s.aig_mapping, TECHLIB_PATH ); } );
+    } ), {read} );
+    auto const score_aig = tasks.add( stage1( [&]() {
+      s.scores_before = s.prof.measure( "self-duality", [&]() { return quantify_self_duality( s.aig_scoring ); } );
+    } ), {read} );
+    auto const resynthesis = tasks.add( stage1( [&]() {
+      xmg_pool.replace( s.xmg, xmg_pool.acquire( s.aig.size() ) );
+      mockturtle::node_resynthesis_params noderesyn_ps;
+      mockturtle::node_resynthesis_stats noderesyn_st;
+      s.prof.measure( "resynthesis", [&]() { mockturtle::node_resynthesis( s.xmg, s.aig, s.resyn, noderesyn_ps, &noderesyn_st ); } );
+
+      /* SAT sweeping shrinks the XMG that every rewriting pass starts from */
+      mockturtle::xmg_fraig_stats fraig_st;
+      if ( ep.fraig )
+      {
+        s.prof.measure( "fraig", [&]() { xmg_pool.replace( s.xmg, mockturtle::xmg_fraig( s.xmg, {}, &fraig_st ) ); } );
+        fmt::print( "[i] fraig: {} -> {} gates ({} merged, {} undecided)\n", fraig_st.gates_before, fraig_st.gates_after, fraig_st.num_proved, fraig_st.num_undecided );
+      }
 
-    mockturtle::xmg_network xmg;
-    mockturtle::xmg3_npn_resynthesis<mockturtle::xmg_network> resyn;
+      s.aig_gates = s.aig.num_gates();
+      s.resynthesis_time = mockturtle::to_seconds( noderesyn_st.time_total + fraig_st.time_total );
+      s.xmg_scoring = xmg_pool.cleanup_dangling( s.xmg );
+    } ), {read} );
+    auto const score_xmg = tasks.add( stage1( [&]() {
+      s.scores_before_xmg = s.prof.measure( "self-duality", [&]() { return quantify_self_duality( s.xmg_scoring ); } );
+    } ), {resynthesis} );
+
+    auto const save_resynthesized = tasks.add( stage1( [&]() {
+      nlohmann::json const resynthesized = {{"aig_gates", s.aig_gates},
+                                            {"area_before", s.area_before},
+                                            {"resynthesis_time", s.resynthesis_time},
+                                            {"score1_before", s.scores_before.average_over_cuts.value},
+                                            {"score1_before_ci", s.scores_before.average_over_cuts.half_width},
+                                            {"score2_before", s.scores_before.maximum_of_cuts.value},
+                                            {"score2_before_ci", s.scores_before.maximum_of_cuts.half_width},
+                                            {"score1_before_xmg", s.scores_before_xmg.average_over_cuts.value},
+                                            {"score1_before_xmg_ci", s.scores_before_xmg.average_over_cuts.half_width},
+                                            {"score2_before_xmg", s.scores_before_xmg.maximum_of_cuts.value},
+                                            {"score2_before_xmg_ci", s.scores_before_xmg.maximum_of_cuts.half_width}};
+      cp.save_stage( s.benchmark, "resynthesized", s.xmg_scoring, resynthesized );
+      s.aig = s.aig_mapping = s.aig_scoring = mockturtle::aig_network();
+      xmg_pool.release( std::move( s.xmg_scoring ) );
+    } ), {premap, score_aig, score_xmg} );
+
+    /* stage 2: repeated rewriting of the resynthesized XMG */
+    auto const rewriting = tasks.add( [&]() {
+      if ( s.failed )
+      {
+        return;
+      }
 
-    /* prepare XMG using node resynthesis */
-    mockturtle::node_resynthesis_params noderesyn_ps;
-    mockturtle::node_resynthesis_stats noderesyn_st;
-    mockturtle::node_resynthesis( xmg, aig, resyn, noderesyn_ps, &noderesyn_st );
+      auto xmg_rewritten = xmg_pool.acquire();
+      nlohmann::json rewritten;
+      if ( cp.load_stage( s.benchmark, "rewritten", xmg_rewritten, rewritten ) )
+      {
+        xmg_pool.replace( s.xmg, std::move( xmg_rewritten ) );
+        s.runtime = rewritten["runtime"].get<experiments::sample_statistics>();
+        if ( rewritten.contains( "trace" ) )
+        {
+          s.trace = experiments::convergence_trace::from_json( rewritten["trace"] );
+        }
+      }
+      else
+      {
+        xmg_pool.release( std::move( xmg_rewritten ) );
+
+        /* every run rewrites the same resynthesized XMG */
+        auto const xmg_resynthesized = xmg_pool.cleanup_dangling( s.xmg );
+        s.runtime = experiments::repeat( bps, [&]() {
+          xmg_pool.replace( s.xmg, xmg_pool.cleanup_dangling( xmg_resynthesized ) );
+
+          mockturtle::stopwatch<>::duration rewrite_time_total{0};
+          experiments::early_stopping stopping( ep.early_stopping );
+          s.trace.clear();
+          for ( auto i = 0u; i < ep.num_rewrite_times; ++i )
+          {
+            auto const size_before = s.xmg.num_gates();
+
+            mockturtle::cut_rewriting_params rewrite_ps;
+            rewrite_ps.cut_enumeration_ps.cut_size = ep.exact_cache.empty() ? 4u : ep.cut_size;
+            /* progress bars of concurrent tasks would interleave */
+            rewrite_ps.progress = bps.jobs == 1u;
+
+            mockturtle::cut_rewriting_stats rewrite_st;
+            if ( ep.exact_cache.empty() )
+            {
+              s.prof.measure( "rewriting", [&]() { rewrite( s.xmg, s.resyn, rewrite_ps, &rewrite_st ); } );
+            }
+            else
+            {
+              mockturtle::xmg_exact_fallback_resynthesis<mockturtle::xmg_network, decltype( s.resyn )> exact_fallback( s.resyn, exact_resyn );
+              s.prof.measure( "rewriting", [&]() { rewrite( s.xmg, exact_fallback, rewrite_ps, &rewrite_st ); } );
+            }
+            s.prof.measure( "cleanup", [&]() { xmg_pool.replace( s.xmg, xmg_pool.cleanup_dangling( s.xmg ) ); } );
+
+            rewrite_time_total += rewrite_st.time_total;
+            stopping.pass_done( "rewriting", size_before, s.xmg.num_gates(), mockturtle::to_seconds( rewrite_st.time_total ) );
+            s.trace.add( i + 1u, "rewriting", s.xmg, mockturtle::to_seconds( rewrite_st.time_total ) );
+
+            if ( !stopping.next_iteration( size_before, s.xmg.num_gates() ) )
+              break;
+          }
+
+          return s.resynthesis_time + mockturtle::to_seconds( rewrite_time_total );
+        } );
+        cp.save_stage( s.benchmark, "rewritten", s.xmg, {{"runtime", s.runtime}, {"trace", s.trace.to_json()}} );
+      }
 
-    auto const score1_before = quantify_self_duality_using_average_over_cuts( aig );
-    auto const score2_before = quantify_self_duality_using_maximum_of_cuts( aig );
+      /* profile XMG gates */
+      s.xmg_st = mockturtle::profile_xmg( s.xmg );
+      s.xmg_mapping = xmg_pool.cleanup_dangling( s.xmg );
+      s.xmg_cec = xmg_pool.cleanup_dangling( s.xmg );
+    }, concat( {resynthesis}, previous( rewrite_tasks, 1u ) ) );
+    rewrite_tasks.push_back( rewriting );
 
-    auto const score1_before_xmg = quantify_self_duality_using_average_over_cuts( xmg );
-    auto const score2_before_xmg = quantify_self_duality_using_maximum_of_cuts( xmg );
+    auto const stage3 = [&]( auto&& fn ) {
+      return [&s, fn]() {
+        if ( !s.failed )
+        {
+          fn();
+        }
+      };
+    };
 
-    mockturtle::stopwatch<>::duration rewrite_time_total{0};
-    auto size_before = xmg.size();
-    for ( auto i = 0u; i < ep.num_rewrite_times; ++i )
-    {
-      mockturtle::cut_rewriting_params rewrite_ps;
-      rewrite_ps.cut_enumeration_ps.cut_size = 4;
-      rewrite_ps.progress = true;
+    auto const score_after = tasks.add( stage3( [&]() {
+      s.scores = s.prof.measure( "self-duality", [&]() { return quantify_self_duality( s.xmg ); } );
+    } ), {rewriting} );
 
-      mockturtle::cut_rewriting_stats rewrite_st;
-      mockturtle::cut_rewriting( xmg, resyn, rewrite_ps, &rewrite_st );
-      xmg = mockturtle::cleanup_dangling( xmg );
+    /* technology mapping on the optimized benchmark */
+    auto const map_after = tasks.add( stage3( [&]() {
+      s.area_after = s.prof.measure( "mapping", [&]() { return experiments::abc_techmap( s.xmg_mapping, TECHLIB_PATH ); } );
+    } ), {rewriting} );
 
-      rewrite_time_total += rewrite_st.time_total;
+    /* verify results using ABC's CEC command */
+    auto const cec = tasks.add( stage3( [&]() {
+      s.cec = ( !ep.verify || s.benchmark == "hyp" ) ? true : s.prof.measure( "cec", [&]() { return experiments::golden_cec( s.xmg_cec, s.benchmark, path_type, file_type ); } );
+    } ), {rewriting} );
 
-      /* terminate early if size does not change */
-      if ( xmg.size() == size_before )
-        break;
+    /* fill benchmark table */
+    row_tasks.push_back( tasks.add( stage3( [&]() {
+      double const area_improvement = double( 1.0 ) - ( s.area_after / s.area_before );
+      double const sd_ratio = s.xmg_st.self_dual_ratio();
+      auto const first_phase_row = exp_phases.num_rows();
+      auto const first_trace_row = exp_trace.num_rows();
+
+      exp( s.benchmark,
+           /* AIG: */ fmt::format( "{:7d}", s.aig_gates ),
+           /* XMG: */ fmt::format( "{:7d} = {:7d} + {:7d}", s.xmg.num_gates(), s.xmg_st.total_xor3(), s.xmg_st.total_maj() ),
+           /* self-duality AIG scores (before): */ format_scores( s.scores_before ),
+           /* self-duality XMG scores (before): */ format_scores( s.scores_before_xmg ),
+           /* self-duality scores (after): */ fmt::format( "{:3.2f} / {}", sd_ratio, format_scores( s.scores ) ),
+           /* TECH-MAP: */ s.area_before, s.area_after, area_improvement,
+           /* runtime */ s.runtime,
+           /* QoR */ s.xmg.num_gates(), sd_ratio,
+           /* memory */ bps.jobs == 1u ? s.prof.peak_rss_mb() : experiments::read_memory_status().peak_rss / 1024.0,
+           /* verify: */ s.cec );
+      experiments::add_phases( exp_phases, s.benchmark, s.prof.profiler() );
+      experiments::add_trace( exp_trace, s.benchmark, s.trace );
+
+      /* the main row is saved last and marks the benchmark as finished */
+      cp.save_rows( s.benchmark, exp_phases, first_phase_row );
+      cp.save_rows( s.benchmark, exp_trace, first_trace_row );
+      cp.save_rows( s.benchmark, exp, exp.num_rows() - 1u );
+
+      /* later benchmarks do not need the networks anymore */
+      xmg_pool.release( std::move( s.xmg ) );
+      xmg_pool.release( std::move( s.xmg_mapping ) );
+      xmg_pool.release( std::move( s.xmg_cec ) );
+    } ), concat( {save_resynthesized, score_after, map_after, cec}, previous( row_tasks, 1u ) ) ) );
+  }
 
-      size_before = xmg.size();
+  tasks.run( bps.jobs );
+  if ( bps.jobs != 1u )
+  {
+    tasks.stats().report();
+  }
+
+  exp.save();
+  exp.table();
+  exp_phases.save();
+  exp_phases.table();
+  exp_trace.save();
+  exp_trace.table();
+
+  if ( !ep.exact_cache.empty() )
+  {
+    exact_resyn.stats().report();
+    exact_cache.save();
+  }
+
+  if ( bps.baseline.empty() )
+  {
+    return 0u;
+  }
+  return exp.check_regressions( bps.baseline, {{"runtime", false, bps.threshold},
+                                               {"area-after", false, 0.0},
+                                               {"XMG gates (aft)", false, 0.0},
+                                               {"sd ratio (aft)", true, 0.0}} );
+}
+
+struct experiment4_params
+{
+  uint32_t num_rewrite_times{3u};
+  double level_weight{0.5};
+  double non_self_dual_weight{1.0};
+  bool verify{true};
+
+  /* genlib whose gate areas are combined with the level gain and used for mapping (unit cost and simple.genlib if empty) */
+  std::string genlib{};
+};
+
+/*! \brief Delay-aware rewriting that keeps the depth of the resynthesized XMG as timing target, returns 1 if the genlib cannot be read */
+uint32_t experiment4( experiment4_params const& ep, std::vector<std::string> const& benchmarks = experiments::epfl_benchmarks(), std::string const& path_type = "", std::string const& file_type = "aig" )
+{
+  std::string const TECHLIB_PATH = "../experiments/techlib/simple.genlib";
+
+  std::cout << "===========================================================================" << std::endl;
+  std::cout << "EXPERIMENT#4: node_resynthesis and delay-aware self-dual rewriting" << std::endl;
+  std::cout << "===========================================================================" << std::endl;
+
+  std::optional<mockturtle::xmg_genlib_cost> genlib_cost;
+  if ( !ep.genlib.empty() )
+  {
+    std::vector<mockturtle::genlib_gate> gates;
+    if ( !mockturtle::read_genlib( ep.genlib, gates ) )
+    {
+      fmt::print( "[e] could not read genlib {}\n", ep.genlib );
+      return 1u;
     }
+    genlib_cost.emplace( gates );
+  }
+  auto const techlib = ep.genlib.empty() ? TECHLIB_PATH : ep.genlib;
 
-    /* profile XMG gates */
-    mockturtle::xmg_cost_params xmg_st;
-    num_gate_profile( xmg, xmg_st );
+  experiments::experiment<std::string, uint32_t, uint32_t, uint32_t, uint32_t, double, double, double, float, bool>
+    exp( "delay_rewriting", "benchmark", "size (bef)", "size (aft)", "depth (bef)", "depth (aft)",
+         "sd ratio (bef)", "sd ratio (aft)", "area-after", "runtime", "equivalent" );
+  for ( auto const& benchmark : benchmarks )
+  {
+    fmt::print( "[i] processing {}\n", benchmark );
 
-    auto const score1 = quantify_self_duality_using_average_over_cuts( xmg );
-    auto const score2 = quantify_self_duality_using_maximum_of_cuts( xmg );
+    mockturtle::aig_network aig;
+    if ( !read_benchmark( aig, benchmark, path_type, file_type ) )
+      continue;
 
-    /* technology mapping on the initial benchmark */
-    double const area_after = experiments::abc_techmap( xmg, TECHLIB_PATH );
+    mockturtle::xmg_network xmg;
+    mockturtle::xmg3_npn_resynthesis<mockturtle::xmg_network> resyn;
+    mockturtle::node_resynthesis( xmg, aig, resyn );
+    xmg = mockturtle::cleanup_dangling( xmg );
 
-    double const area_improvement = double( 1.0 ) - ( area_after / area_before );
+    auto const xmg_st_before = mockturtle::profile_xmg( xmg );
 
-    /* verify results using ABC's CEC command */
-    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::abc_cec( xmg, benchmark, path_type, file_type );
+    mockturtle::xmg_delay_rewriting_params ps;
+    ps.required_depth = xmg_st_before.depth;
+    ps.level_weight = ep.level_weight;
+    ps.non_self_dual_weight = ep.non_self_dual_weight;
+    ps.progress = true;
+    if ( genlib_cost )
+    {
+      /* the cost function returns areas in units of 1/scale */
+      ps.area_weight = 1.0 / genlib_cost->scale();
+    }
 
-    /* fill benchmark table */
-    exp( benchmark,
-         /* AIG: */ fmt::format( "{:7d}", aig.num_gates() ),
-         /* XMG: */ fmt::format( "{:7d} = {:7d} + {:7d}", xmg.num_gates(), xmg_st.total_xor3, xmg_st.total_maj ),
-         /* self-duality AIG scores (before): */ fmt::format( "{:3.2f} / {:3.2f}", score1_before, score2_before ),
-         /* self-duality XMG scores (before): */ fmt::format( "{:3.2f} / {:3.2f}", score1_before_xmg, score2_before_xmg ),
-         /* self-duality scores (after): */ fmt::format( "{:3.2f} / {:3.2f} / {:3.2f}", double( xmg_st.actual_xor3 + xmg_st.actual_maj ) / double( xmg.num_gates() ), score1, score2 ),
-         /* TECH-MAP: */ area_before, area_after, area_improvement,
-         /* runtime */ mockturtle::to_seconds( noderesyn_st.time_total + rewrite_time_total ),
-         /* verify: */ cec );
+    mockturtle::stopwatch<>::duration time_total{0};
+    for ( auto i = 0u; i < ep.num_rewrite_times; ++i )
+    {
+      mockturtle::xmg_delay_rewriting_stats st;
+      if ( genlib_cost )
+      {
+        mockturtle::xmg_delay_rewriting( xmg, resyn, ps, &st, *genlib_cost );
+      }
+      else
+      {
+        mockturtle::xmg_delay_rewriting( xmg, resyn, ps, &st );
+      }
+      xmg = mockturtle::cleanup_dangling( xmg );
+      time_total += st.time_total;
+
+      if ( st.num_replacements == 0u )
+        break;
+    }
+
+    auto const xmg_st_after = mockturtle::profile_xmg( xmg );
+    double const area_after = experiments::abc_techmap( xmg, techlib );
+    auto const cec = ( !ep.verify || benchmark == "hyp" ) ? true : experiments::golden_cec( xmg, benchmark, path_type, file_type );
+
+    exp( benchmark, xmg_st_before.num_gates, xmg_st_after.num_gates, xmg_st_before.depth, xmg_st_after.depth,
+         xmg_st_before.self_dual_ratio(), xmg_st_after.self_dual_ratio(), area_after, mockturtle::to_seconds( time_total ), cec );
   }
 
   exp.save();
   exp.table();
+  return 0u;
 }
 
-int main()
+int main( int argc, char** argv )
 {
+  /* `--exact-cache <file>` enables exact synthesis of 5-cuts in experiment #3 */
+  /* `--genlib <file>` makes rewriting in experiments #3 and #4 minimize the library area */
+  /* `--delay-rewriting` runs experiment #4 */
+  /* `--fraig` runs SAT sweeping on the resynthesized XMGs in experiment #3 */
+  /* `--sd-samples N` and `--sd-error X` estimate the self-duality scores in experiment #3 from N sampled gates */
+  /* `--min-improvement X`, `--early-stop R`, and `--predict-stop` set when rewriting in experiment #3 stops (see convergence.hpp) */
+  std::string exact_cache;
+  std::string genlib;
+  bool fraig{false};
+  bool delay_rewriting{false};
+  uint32_t sd_samples{0u};
+  double sd_error{0.01};
+  std::vector<char*> args;
+  for ( auto i = 0; i < argc; ++i )
+  {
+    if ( std::string( argv[i] ) == "--exact-cache" && i + 1 < argc )
+    {
+      exact_cache = argv[++i];
+    }
+    else if ( std::string( argv[i] ) == "--genlib" && i + 1 < argc )
+    {
+      genlib = argv[++i];
+    }
+    else if ( std::string( argv[i] ) == "--fraig" )
+    {
+      fraig = true;
+    }
+    else if ( std::string( argv[i] ) == "--delay-rewriting" )
+    {
+      delay_rewriting = true;
+    }
+    else if ( std::string( argv[i] ) == "--sd-samples" && i + 1 < argc )
+    {
+      sd_samples = std::stoul( argv[++i] );
+    }
+    else if ( std::string( argv[i] ) == "--sd-error" && i + 1 < argc )
+    {
+      sd_error = std::stod( argv[++i] );
+    }
+    else
+    {
+      args.push_back( argv[i] );
+    }
+  }
+
+  auto const early_stop = experiments::parse_early_stopping_params( args, experiment3_params{}.early_stopping );
+  auto const bps = experiments::parse_benchmark_params( static_cast<int>( args.size() ), args.data() );
+  uint32_t regressions{0u};
+
   /* NOTE that we disable equivalence checking for cryptographic benchmarks because it is typically too time consuming */
 
 #if 0
@@ -390,11 +824,21 @@ int main()
 
   /* experiment #3: node resynthesis, rewriting, and quantify self-duality */
   {
-    experiment3( experiment3_params{5u, true} );
-    experiment3( experiment3_params{5u, false}, experiments::crypto_benchmarks(), "_crypto", "v" );
+    regressions += experiment3( experiment3_params{5u, true, true, exact_cache, genlib, fraig, sd_samples, sd_error, early_stop}, experiments::epfl_benchmarks(), "", "aig", bps );
+    regressions += experiment3( experiment3_params{5u, false, true, exact_cache, genlib, fraig, sd_samples, sd_error, early_stop}, experiments::crypto_benchmarks(), "_crypto", "v", bps );
   }
 
-  return 0;
+  /* experiment #4: node resynthesis and rewriting under the depth of the resynthesized XMG */
+  if ( delay_rewriting )
+  {
+    experiment4_params ep4;
+    ep4.genlib = genlib;
+    regressions += experiment4( ep4 );
+  }
+
+  experiments::golden_signatures().stats().report();
+
+  return regressions == 0u ? 0 : 1;
 }
 
 /***
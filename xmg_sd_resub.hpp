@@ -0,0 +1,762 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_sd_resub.hpp
+  \brief Resubstitution with MAJ3/XOR3 of divisors that favours self-dual gates
+
+  For every node, a reconvergence-driven cut defines a window.  Divisors are
+  the window nodes outside the MFFC of the root and side nodes whose fanins
+  are divisors.  All truth tables of a window are stored in one flat arena of
+  64-bit words.  The root is replaced by a divisor (0-resubstitution) or by a
+  new MAJ3/XOR3 gate of three (possibly complemented) divisors, where the
+  constant 0 is a divisor as well, i.e., AND/OR/XOR2 are found too.
+  Candidates are ranked by the weighted decrease of gate area and of the
+  number of gates that are not self-dual.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/progress_bar.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include "xmg_simulation.hpp"
+
+namespace mockturtle
+{
+
+/*! \brief Area of the four XMG gate kinds */
+struct xmg_gate_costs
+{
+  double maj3{1.0};
+  double xor3{1.0};
+  double and_or{1.0};
+  double xor2{1.0};
+};
+
+struct xmg_sd_resubstitution_params
+{
+  /*! \brief Maximum number of leaves of a window (truth tables have 2^max_pis bits). */
+  uint32_t max_pis{8u};
+
+  /*! \brief Maximum number of divisors. */
+  uint32_t max_divisors{150u};
+
+  /*! \brief Do not use nodes with a larger fanout as roots. */
+  uint32_t skip_fanout_limit_for_roots{1000u};
+
+  /*! \brief Do not collect side divisors through nodes with a larger fanout. */
+  uint32_t skip_fanout_limit_for_divisors{100u};
+
+  /*! \brief Search MAJ3/XOR3 of three divisors (otherwise 0-resubstitution only). */
+  bool use_three_divisors{true};
+
+  /*! \brief Gate areas, e.g., from a genlib file. */
+  xmg_gate_costs costs{};
+
+  /*! \brief Weight of the area decrease. */
+  double area_weight{1.0};
+
+  /*! \brief Weight of the decrease of gates that are not self-dual. */
+  double self_dual_weight{1.0};
+
+  /*! \brief Show progress. */
+  bool progress{false};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct xmg_sd_resubstitution_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime for windowing and divisor collection. */
+  stopwatch<>::duration time_windows{0};
+
+  /*! \brief Runtime for simulation. */
+  stopwatch<>::duration time_simulation{0};
+
+  /*! \brief Runtime for the divisor search. */
+  stopwatch<>::duration time_search{0};
+
+  uint32_t num_windows{0u};
+  uint32_t num_divisors{0u};
+  uint32_t num_resub0{0u};
+  uint32_t num_maj3{0u};
+  uint32_t num_xor3{0u};
+  uint32_t num_and_or{0u};
+  uint32_t num_xor2{0u};
+  double estimated_area_gain{0.0};
+  int32_t estimated_self_dual_gain{0};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] resub0 = {}, MAJ3 = {}, XOR3 = {}, AND/OR = {}, XOR2 = {}\n", num_resub0, num_maj3, num_xor3, num_and_or, num_xor2 );
+    std::cout << fmt::format( "[i] windows = {}, avg. divisors = {:.1f}\n", num_windows, double( num_divisors ) / std::max( 1u, num_windows ) );
+    std::cout << fmt::format( "[i] est. gain: area = {:.2f}, non-self-dual gates = {}\n", estimated_area_gain, estimated_self_dual_gain );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs (windows: {:>5.2f}, simulation: {:>5.2f}, search: {:>5.2f})\n",
+                              to_seconds( time_total ), to_seconds( time_windows ), to_seconds( time_simulation ), to_seconds( time_search ) );
+  }
+};
+
+namespace detail
+{
+
+class xmg_sd_resubstitution_impl
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  xmg_sd_resubstitution_impl( xmg_network& ntk, xmg_sd_resubstitution_params const& ps, xmg_sd_resubstitution_stats& st )
+      : ntk( ntk ), ps( ps ), st( st )
+  {
+  }
+
+  void run()
+  {
+    stopwatch t( st.time_total );
+
+    fanouts.resize( ntk.size() );
+    ntk.foreach_gate( [&]( auto const& n ) {
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        fanouts[ntk.node_to_index( ntk.get_node( fi ) )].push_back( n );
+      } );
+    } );
+
+    std::vector<node> roots;
+    ntk.foreach_gate( [&]( auto const& n ) {
+      roots.push_back( n );
+    } );
+
+    progress_bar pbar{static_cast<uint32_t>( roots.size() ), "sd-resub |{0}| node = {1:>4} / " + std::to_string( roots.size() ), ps.progress};
+    for ( auto i = 0u; i < roots.size(); ++i )
+    {
+      pbar( i, i );
+
+      auto const n = roots[i];
+      if ( ntk.fanout_size( n ) == 0u || ntk.fanout_size( n ) > ps.skip_fanout_limit_for_roots )
+      {
+        continue;
+      }
+      resubstitute( n );
+    }
+  }
+
+private:
+  enum class gate_kind : uint8_t
+  {
+    maj3,
+    xor3,
+    and_or,
+    xor2
+  };
+
+  struct candidate
+  {
+    bool is_xor3{false};
+    std::array<uint32_t, 3> divisors{}; /* indices into `divisors` */
+    std::array<bool, 3> complements{};
+    bool output_complement{false};
+    double score{0.0};
+    double area_gain{0.0};
+    int32_t self_dual_gain{0};
+  };
+
+  gate_kind kind( node const& n ) const
+  {
+    bool has_constant{false};
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      has_constant |= ntk.is_constant( ntk.get_node( fi ) );
+    } );
+    if ( ntk.is_xor3( n ) )
+    {
+      return has_constant ? gate_kind::xor2 : gate_kind::xor3;
+    }
+    return has_constant ? gate_kind::and_or : gate_kind::maj3;
+  }
+
+  double area( gate_kind k ) const
+  {
+    switch ( k )
+    {
+    case gate_kind::maj3:
+      return ps.costs.maj3;
+    case gate_kind::xor3:
+      return ps.costs.xor3;
+    case gate_kind::and_or:
+      return ps.costs.and_or;
+    default:
+      return ps.costs.xor2;
+    }
+  }
+
+  /* arena access */
+  uint64_t* tt( uint32_t slot )
+  {
+    return arena.data() + slot * num_words;
+  }
+
+  uint32_t new_slot()
+  {
+    arena.resize( arena.size() + num_words );
+    return static_cast<uint32_t>( arena.size() / num_words ) - 1u;
+  }
+
+  uint32_t slot_of( node const& n ) const
+  {
+    auto const it = slots.find( n );
+    return it == slots.end() ? UINT32_MAX : it->second;
+  }
+
+  void resubstitute( node const& root )
+  {
+    if ( !call_with_stopwatch( st.time_windows, [&]() { return collect_window( root ); } ) )
+    {
+      return;
+    }
+    call_with_stopwatch( st.time_simulation, [&]() { simulate_window( root ); } );
+    call_with_stopwatch( st.time_windows, [&]() { collect_side_divisors(); } );
+
+    ++st.num_windows;
+    st.num_divisors += static_cast<uint32_t>( divisors.size() );
+
+    auto const best = call_with_stopwatch( st.time_search, [&]() { return search(); } );
+    if ( !best || best->score <= 0.0 )
+    {
+      return;
+    }
+
+    st.estimated_area_gain += best->area_gain;
+    st.estimated_self_dual_gain += best->self_dual_gain;
+
+    signal replacement;
+    if ( best->divisors[1] == UINT32_MAX )
+    {
+      ++st.num_resub0;
+      replacement = ntk.make_signal( divisors[best->divisors[0]] ) ^ best->complements[0];
+    }
+    else
+    {
+      std::array<signal, 3> fanins;
+      for ( auto k = 0u; k < 3u; ++k )
+      {
+        fanins[k] = ntk.make_signal( divisors[best->divisors[k]] ) ^ best->complements[k];
+      }
+      replacement = best->is_xor3 ? ntk.create_xor3( fanins[0], fanins[1], fanins[2] ) : ntk.create_maj( fanins[0], fanins[1], fanins[2] );
+
+      auto const g = ntk.get_node( replacement );
+      if ( g == root )
+      {
+        return;
+      }
+      if ( ntk.node_to_index( g ) >= fanouts.size() )
+      {
+        fanouts.resize( ntk.size() );
+        for ( auto const& f : fanins )
+        {
+          fanouts[ntk.node_to_index( ntk.get_node( f ) )].push_back( g );
+        }
+      }
+
+      switch ( kind( g ) )
+      {
+      case gate_kind::maj3:
+        ++st.num_maj3;
+        break;
+      case gate_kind::xor3:
+        ++st.num_xor3;
+        break;
+      case gate_kind::and_or:
+        ++st.num_and_or;
+        break;
+      default:
+        ++st.num_xor2;
+        break;
+      }
+    }
+
+    ntk.substitute_node( root, replacement ^ best->output_complement );
+  }
+
+  /* reconvergence-driven cut, window nodes in topological order, and MFFC */
+  bool collect_window( node const& root )
+  {
+    leaves.clear();
+    window.clear();
+    in_window.clear();
+
+    in_window.emplace( root, 0u );
+    ntk.foreach_fanin( root, [&]( auto const& fi ) {
+      auto const c = ntk.get_node( fi );
+      if ( !ntk.is_constant( c ) && in_window.emplace( c, 0u ).second )
+      {
+        leaves.push_back( c );
+      }
+    } );
+
+    while ( true )
+    {
+      auto best_leaf = leaves.end();
+      uint32_t best_cost = UINT32_MAX;
+      for ( auto it = leaves.begin(); it != leaves.end(); ++it )
+      {
+        if ( ntk.is_pi( *it ) )
+        {
+          continue;
+        }
+        uint32_t cost{0u};
+        ntk.foreach_fanin( *it, [&]( auto const& fi ) {
+          auto const c = ntk.get_node( fi );
+          cost += ( !ntk.is_constant( c ) && !in_window.count( c ) ) ? 1u : 0u;
+        } );
+        if ( cost < best_cost )
+        {
+          best_cost = cost;
+          best_leaf = it;
+        }
+      }
+
+      if ( best_leaf == leaves.end() || leaves.size() - 1u + best_cost > ps.max_pis )
+      {
+        break;
+      }
+
+      auto const n = *best_leaf;
+      leaves.erase( best_leaf );
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        auto const c = ntk.get_node( fi );
+        if ( !ntk.is_constant( c ) && in_window.emplace( c, 0u ).second )
+        {
+          leaves.push_back( c );
+        }
+      } );
+    }
+
+    if ( leaves.size() > ps.max_pis )
+    {
+      return false;
+    }
+
+    /* topological order of the inner nodes (including the root) */
+    std::vector<std::pair<node, bool>> stack{{root, false}};
+    std::unordered_map<node, bool> done;
+    for ( auto const& l : leaves )
+    {
+      done[l] = true;
+    }
+    while ( !stack.empty() )
+    {
+      auto const [n, expanded] = stack.back();
+      stack.pop_back();
+      if ( expanded )
+      {
+        window.push_back( n );
+        continue;
+      }
+      if ( done[n] )
+      {
+        continue;
+      }
+      done[n] = true;
+      stack.emplace_back( n, true );
+      ntk.foreach_fanin( n, [&]( auto const& fi ) {
+        auto const c = ntk.get_node( fi );
+        if ( !ntk.is_constant( c ) && !done[c] )
+        {
+          stack.emplace_back( c, false );
+        }
+      } );
+    }
+
+    /* MFFC bounded by the leaves; in_window values: 0 = divisor, 1 = MFFC */
+    mffc_area = 0.0;
+    mffc_non_self_dual = 0;
+    std::unordered_map<node, uint32_t> refs;
+    std::vector<node> mffc{root};
+    in_window[root] = 1u;
+    for ( auto i = 0u; i < mffc.size(); ++i )
+    {
+      auto const k = kind( mffc[i] );
+      mffc_area += area( k );
+      mffc_non_self_dual += ( k == gate_kind::and_or || k == gate_kind::xor2 ) ? 1 : 0;
+      ntk.foreach_fanin( mffc[i], [&]( auto const& fi ) {
+        auto const c = ntk.get_node( fi );
+        if ( ntk.is_constant( c ) || ntk.is_pi( c ) || std::find( leaves.begin(), leaves.end(), c ) != leaves.end() )
+        {
+          return;
+        }
+        auto it = refs.find( c );
+        if ( it == refs.end() )
+        {
+          it = refs.emplace( c, ntk.fanout_size( c ) ).first;
+        }
+        if ( --it->second == 0u )
+        {
+          in_window[c] = 1u;
+          mffc.push_back( c );
+        }
+      } );
+    }
+
+    return true;
+  }
+
+  void simulate_window( node const& root )
+  {
+    auto const num_vars = static_cast<uint32_t>( leaves.size() );
+    num_words = num_vars <= 6u ? 1u : ( 1u << ( num_vars - 6u ) );
+    arena.clear();
+    slots.clear();
+    divisors.clear();
+    divisor_slots.clear();
+
+    /* constant 0 */
+    auto const constant = new_slot();
+    std::fill( tt( constant ), tt( constant ) + num_words, uint64_t( 0 ) );
+    add_divisor( ntk.get_node( ntk.get_constant( false ) ), constant );
+
+    static constexpr uint64_t projections[] = {0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0,
+                                               0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000};
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      auto const s = new_slot();
+      for ( auto w = 0u; w < num_words; ++w )
+      {
+        tt( s )[w] = i < 6u ? projections[i] : ( ( ( w >> ( i - 6u ) ) & 1 ) ? ~uint64_t( 0 ) : uint64_t( 0 ) );
+      }
+      add_divisor( leaves[i], s );
+    }
+
+    for ( auto const& n : window )
+    {
+      auto const s = simulate_node( n );
+      if ( n != root && in_window[n] == 0u )
+      {
+        add_divisor( n, s );
+      }
+    }
+    root_slot = slot_of( root );
+  }
+
+  uint32_t simulate_node( node const& n )
+  {
+    std::array<uint32_t, 3> fanin_slots{};
+    uint32_t complements{0u};
+    uint32_t k{0u};
+    bool ok{true};
+    ntk.foreach_fanin( n, [&]( auto const& fi ) {
+      auto const c = ntk.get_node( fi );
+      fanin_slots[k] = ntk.is_constant( c ) ? 0u : slot_of( c );
+      ok &= fanin_slots[k] != UINT32_MAX;
+      complements |= ntk.is_complemented( fi ) ? ( 1u << k ) : 0u;
+      ++k;
+    } );
+    if ( !ok )
+    {
+      return UINT32_MAX;
+    }
+
+    auto const s = new_slot();
+    detail::simulate_gate( simulation_kernel::automatic, tt( s ), tt( fanin_slots[0] ), tt( fanin_slots[1] ), tt( fanin_slots[2] ), complements, ntk.is_xor3( n ), num_words );
+    slots[n] = s;
+    return s;
+  }
+
+  void add_divisor( node const& n, uint32_t slot )
+  {
+    slots[n] = slot;
+    divisors.push_back( n );
+    divisor_slots.push_back( slot );
+  }
+
+  /* nodes outside the window whose fanins are all divisors */
+  void collect_side_divisors()
+  {
+    for ( auto i = 1u; i < divisors.size() && divisors.size() < ps.max_divisors; ++i )
+    {
+      auto const d = divisors[i];
+      if ( ntk.node_to_index( d ) >= fanouts.size() || ntk.fanout_size( d ) > ps.skip_fanout_limit_for_divisors )
+      {
+        continue;
+      }
+      for ( auto const& p : fanouts[ntk.node_to_index( d )] )
+      {
+        if ( divisors.size() >= ps.max_divisors )
+        {
+          break;
+        }
+        if ( in_window.count( p ) || slots.count( p ) || ntk.fanout_size( p ) == 0u )
+        {
+          continue;
+        }
+
+        bool all_divisors{true};
+        ntk.foreach_fanin( p, [&]( auto const& fi ) {
+          auto const c = ntk.get_node( fi );
+          all_divisors &= ntk.is_constant( c ) || ( slots.count( c ) && ( !in_window.count( c ) || in_window[c] == 0u ) );
+        } );
+        if ( !all_divisors )
+        {
+          continue;
+        }
+
+        auto const s = call_with_stopwatch( st.time_simulation, [&]() { return simulate_node( p ); } );
+        if ( s != UINT32_MAX )
+        {
+          add_divisor( p, s );
+        }
+      }
+    }
+  }
+
+  bool equal( uint64_t const* a, uint64_t const* b, bool complement ) const
+  {
+    auto const mask = complement ? ~uint64_t( 0 ) : uint64_t( 0 );
+    for ( auto w = 0u; w < num_words; ++w )
+    {
+      if ( a[w] != ( b[w] ^ mask ) )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t hash_words( uint64_t const* a, bool complement ) const
+  {
+    auto const mask = complement ? ~uint64_t( 0 ) : uint64_t( 0 );
+    uint64_t h{0xcbf29ce484222325};
+    for ( auto w = 0u; w < num_words; ++w )
+    {
+      h = ( h ^ ( a[w] ^ mask ) ) * 0x100000001b3;
+    }
+    return h;
+  }
+
+  void score( candidate& c, gate_kind k ) const
+  {
+    c.area_gain = mffc_area - area( k );
+    c.self_dual_gain = mffc_non_self_dual - ( ( k == gate_kind::and_or || k == gate_kind::xor2 ) ? 1 : 0 );
+    c.score = ps.area_weight * c.area_gain + ps.self_dual_weight * c.self_dual_gain;
+  }
+
+  std::optional<candidate> search()
+  {
+    auto const* target = tt( root_slot );
+    auto const num_divisors = static_cast<uint32_t>( divisors.size() );
+
+    /* 0-resubstitution dominates every candidate with a new gate */
+    for ( auto i = 0u; i < num_divisors; ++i )
+    {
+      for ( auto compl_ : {false, true} )
+      {
+        if ( equal( target, tt( divisor_slots[i] ), compl_ ) )
+        {
+          candidate c;
+          c.divisors = {i, UINT32_MAX, UINT32_MAX};
+          c.complements[0] = compl_;
+          c.area_gain = mffc_area;
+          c.self_dual_gain = mffc_non_self_dual;
+          c.score = ps.area_weight * c.area_gain + ps.self_dual_weight * c.self_dual_gain;
+          return c;
+        }
+      }
+    }
+
+    if ( !ps.use_three_divisors )
+    {
+      return std::nullopt;
+    }
+
+    std::optional<candidate> best;
+    auto const consider = [&]( candidate& c ) {
+      auto const uses_constant = c.divisors[0] == 0u;
+      score( c, c.is_xor3 ? ( uses_constant ? gate_kind::xor2 : gate_kind::xor3 ) : ( uses_constant ? gate_kind::and_or : gate_kind::maj3 ) );
+      if ( c.score > 0.0 && ( !best || c.score > best->score ) )
+      {
+        best = c;
+      }
+    };
+
+    /* XOR3: the third divisor is the XOR of the target and two divisors */
+    std::unordered_multimap<uint64_t, uint32_t> table;
+    for ( auto i = 0u; i < num_divisors; ++i )
+    {
+      auto const* d = tt( divisor_slots[i] );
+      table.emplace( hash_words( d, d[0] & 1 ), i );
+    }
+    std::vector<uint64_t> rest( num_words );
+    for ( auto i = 0u; i < num_divisors; ++i )
+    {
+      for ( auto j = i + 1u; j < num_divisors; ++j )
+      {
+        auto const* a = tt( divisor_slots[i] );
+        auto const* b = tt( divisor_slots[j] );
+        for ( auto w = 0u; w < num_words; ++w )
+        {
+          rest[w] = target[w] ^ a[w] ^ b[w];
+        }
+        bool const rest_compl = rest[0] & 1;
+        auto const range = table.equal_range( hash_words( rest.data(), rest_compl ) );
+        for ( auto it = range.first; it != range.second; ++it )
+        {
+          auto const k = it->second;
+          if ( k <= j )
+          {
+            continue;
+          }
+          auto const* c = tt( divisor_slots[k] );
+          if ( !equal( rest.data(), c, false ) && !equal( rest.data(), c, true ) )
+          {
+            continue;
+          }
+          candidate cand;
+          cand.is_xor3 = true;
+          cand.divisors = {i, j, k};
+          cand.output_complement = !equal( rest.data(), c, false );
+          consider( cand );
+        }
+      }
+    }
+
+    /* MAJ3: where two fanins agree they determine the output, elsewhere the third one does */
+    std::vector<uint64_t> disagree( num_words );
+    for ( auto out_compl : {false, true} )
+    {
+      auto const tmask = out_compl ? ~uint64_t( 0 ) : uint64_t( 0 );
+      for ( auto i = 0u; i < num_divisors; ++i )
+      {
+        auto const* a = tt( divisor_slots[i] );
+        for ( auto j = i + 1u; j < num_divisors; ++j )
+        {
+          auto const* b = tt( divisor_slots[j] );
+          for ( auto bc : {false, true} )
+          {
+            auto const bmask = bc ? ~uint64_t( 0 ) : uint64_t( 0 );
+            bool feasible{true};
+            for ( auto w = 0u; w < num_words && feasible; ++w )
+            {
+              auto const t = target[w] ^ tmask;
+              auto const bw = b[w] ^ bmask;
+              feasible = ( ~( a[w] ^ bw ) & ( a[w] ^ t ) ) == 0u;
+              disagree[w] = a[w] ^ bw;
+            }
+            if ( !feasible )
+            {
+              continue;
+            }
+
+            for ( auto k = j + 1u; k < num_divisors; ++k )
+            {
+              auto const* c = tt( divisor_slots[k] );
+              for ( auto cc : {false, true} )
+              {
+                auto const cmask = cc ? ~uint64_t( 0 ) : uint64_t( 0 );
+                bool match{true};
+                for ( auto w = 0u; w < num_words && match; ++w )
+                {
+                  match = ( ( ( c[w] ^ cmask ) ^ ( target[w] ^ tmask ) ) & disagree[w] ) == 0u;
+                }
+                if ( match )
+                {
+                  candidate cand;
+                  cand.divisors = {i, j, k};
+                  cand.complements = {false, bc, cc};
+                  cand.output_complement = out_compl;
+                  consider( cand );
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    return best;
+  }
+
+private:
+  xmg_network& ntk;
+  xmg_sd_resubstitution_params const& ps;
+  xmg_sd_resubstitution_stats& st;
+
+  std::vector<std::vector<node>> fanouts;
+
+  /* current window */
+  std::vector<node> leaves;
+  std::vector<node> window;
+  std::unordered_map<node, uint32_t> in_window;
+  double mffc_area{0.0};
+  int32_t mffc_non_self_dual{0};
+
+  /* truth table arena */
+  uint32_t num_words{1u};
+  std::vector<uint64_t> arena;
+  std::unordered_map<node, uint32_t> slots;
+  uint32_t root_slot{0u};
+
+  std::vector<node> divisors;
+  std::vector<uint32_t> divisor_slots;
+};
+
+} /* namespace detail */
+
+/*! \brief Resubstitution of XMG nodes with self-dual gates of divisors
+ *
+ * Replaced nodes are removed by `substitute_node`, candidates are only
+ * created when they are used.  Call `cleanup_dangling` afterwards to compact
+ * the network.
+ */
+inline void xmg_sd_resubstitution( xmg_network& ntk, xmg_sd_resubstitution_params const& ps = {}, xmg_sd_resubstitution_stats* pst = nullptr )
+{
+  xmg_sd_resubstitution_stats st;
+  detail::xmg_sd_resubstitution_impl p( ntk, ps, st );
+  p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+}
+
+} /* namespace mockturtle */
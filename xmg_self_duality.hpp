@@ -0,0 +1,477 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_self_duality.hpp
+  \brief Checks whether the primary outputs of an XMG are self-dual
+
+  An output f is self-dual iff f(x) = !f(!x) for all x.  The check first
+  simulates random patterns x and their complements !x; every output with a
+  pattern such that f(x) = f(!x) is refuted without SAT.  The remaining
+  outputs are resolved with one dual miter per output, i.e., the cone of the
+  output is encoded twice (the second copy with complemented primary inputs)
+  and the solver looks for x with f(x) = f(!x).
+
+  Outputs are distributed over worker threads in chunks of consecutive
+  outputs.  Every thread owns one solver; cones are encoded lazily, so logic
+  shared by outputs of the same thread is encoded once, and the miter of each
+  output is guarded by an activation literal.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <bill/sat/solver.hpp>
+#include <fmt/format.h>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include "xmg_simulation.hpp"
+
+namespace mockturtle
+{
+
+struct self_duality_params
+{
+  /*! \brief Number of 64-bit words of random patterns. */
+  uint32_t num_words{16u};
+
+  /*! \brief Seed for the random patterns. */
+  uint64_t seed{0x5eed};
+
+  /*! \brief Conflict limit per SAT call (0: no limit). */
+  uint32_t conflict_limit{0u};
+
+  /*! \brief Number of worker threads (0: hardware concurrency). */
+  uint32_t num_threads{0u};
+
+  /*! \brief Number of consecutive outputs a thread takes at once. */
+  uint32_t chunk_size{16u};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct self_duality_stats
+{
+  /*! \brief Total runtime. */
+  stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime of random simulation. */
+  stopwatch<>::duration time_simulation{0};
+
+  /*! \brief Runtime of the SAT phase (wall clock over all threads). */
+  stopwatch<>::duration time_sat{0};
+
+  uint32_t num_threads{0u};
+  uint32_t num_refuted_by_simulation{0u};
+  uint32_t num_sat_calls{0u};
+  uint32_t num_self_dual{0u};
+  uint32_t num_not_self_dual{0u};
+  uint32_t num_undecided{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] self-dual = {}, not self-dual = {} ({} by simulation), undecided = {}\n", num_self_dual, num_not_self_dual, num_refuted_by_simulation, num_undecided );
+    std::cout << fmt::format( "[i] SAT calls = {} on {} threads\n", num_sat_calls, num_threads );
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs (simulation: {:>5.2f} secs, SAT: {:>5.2f} secs)\n", to_seconds( time_total ), to_seconds( time_simulation ), to_seconds( time_sat ) );
+  }
+};
+
+struct self_duality_result
+{
+  enum class status : uint8_t
+  {
+    self_dual,
+    not_self_dual,
+    undecided
+  };
+
+  /*! \brief Status per primary output. */
+  std::vector<status> outputs;
+
+  /*! \brief Input assignment x with f(x) = f(!x) per output (empty unless not self-dual). */
+  std::vector<std::vector<bool>> counterexamples;
+
+  bool all_self_dual() const
+  {
+    return std::all_of( outputs.begin(), outputs.end(), []( auto s ) { return s == status::self_dual; } );
+  }
+
+  uint32_t count( status s ) const
+  {
+    return static_cast<uint32_t>( std::count( outputs.begin(), outputs.end(), s ) );
+  }
+};
+
+namespace detail
+{
+
+/* one solver with the lazily encoded network in two copies (inputs x and !x) */
+class dual_miter_encoder
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+  using solver_t = bill::solver<bill::solvers::ghack>;
+
+  explicit dual_miter_encoder( xmg_network const& ntk )
+      : ntk( ntk ), vars{std::vector<uint32_t>( ntk.size(), UINT32_MAX ), std::vector<uint32_t>( ntk.size(), UINT32_MAX )}
+  {
+    constant = solver.add_variable();
+    solver.add_clause( neg( constant ) );
+  }
+
+  /*! \brief Returns true if `f` is self-dual, false and a counterexample if not, and nothing if undecided */
+  std::optional<bool> check( signal const& f, uint32_t conflict_limit, std::vector<bool>& counterexample )
+  {
+    auto const l1 = literal( f, 0u );
+    auto const l2 = literal( f, 1u );
+
+    /* activation -> ( l1 == l2 ) */
+    auto const activation = pos( solver.add_variable() );
+    solver.add_clause( {~activation, ~l1, l2} );
+    solver.add_clause( {~activation, l1, ~l2} );
+
+    auto const result = solver.solve( {activation}, conflict_limit );
+    solver.add_clause( ~activation );
+
+    if ( result == bill::result::states::unsatisfiable )
+    {
+      return true;
+    }
+    if ( result == bill::result::states::undefined )
+    {
+      return std::nullopt;
+    }
+
+    auto const model = solver.get_model().model();
+    counterexample.clear();
+    ntk.foreach_pi( [&]( auto const& n ) {
+      auto const v = vars[0u][ntk.node_to_index( n )];
+      /* inputs outside of the cone are unconstrained */
+      counterexample.push_back( v != UINT32_MAX && model[v] == bill::lbool_type::true_ );
+    } );
+    return false;
+  }
+
+private:
+  static bill::lit_type pos( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::positive );
+  }
+
+  static bill::lit_type neg( bill::var_type v )
+  {
+    return bill::lit_type( v, bill::lit_type::polarities::negative );
+  }
+
+  static bill::lit_type lit( bill::lit_type l, bool value )
+  {
+    return value ? l : ~l;
+  }
+
+  bill::lit_type literal( signal const& f, uint32_t copy )
+  {
+    auto const l = node_literal( ntk.get_node( f ), copy );
+    return ntk.is_complemented( f ) ? ~l : l;
+  }
+
+  bill::lit_type node_literal( node const& n, uint32_t copy )
+  {
+    if ( ntk.is_constant( n ) )
+    {
+      return pos( constant );
+    }
+    if ( ntk.is_pi( n ) )
+    {
+      /* both copies share the input variables, the second one complemented */
+      auto const l = pos( encode_pi( n ) );
+      return copy == 0u ? l : ~l;
+    }
+    encode( n, copy );
+    return pos( vars[copy][ntk.node_to_index( n )] );
+  }
+
+  uint32_t encode_pi( node const& n )
+  {
+    auto& v = vars[0u][ntk.node_to_index( n )];
+    if ( v == UINT32_MAX )
+    {
+      v = solver.add_variable();
+    }
+    return v;
+  }
+
+  /* iterative DFS to be safe on deep netlists */
+  void encode( node const& root, uint32_t copy )
+  {
+    auto& var = vars[copy];
+    if ( var[ntk.node_to_index( root )] != UINT32_MAX )
+    {
+      return;
+    }
+
+    stack.clear();
+    stack.emplace_back( root, false );
+    while ( !stack.empty() )
+    {
+      auto const [n, expanded] = stack.back();
+      stack.pop_back();
+      auto const index = ntk.node_to_index( n );
+
+      if ( !expanded )
+      {
+        if ( var[index] != UINT32_MAX || ntk.is_constant( n ) || ntk.is_pi( n ) )
+        {
+          continue;
+        }
+        stack.emplace_back( n, true );
+        ntk.foreach_fanin( n, [&]( auto const& fi ) {
+          auto const c = ntk.get_node( fi );
+          if ( !ntk.is_constant( c ) && !ntk.is_pi( c ) && var[ntk.node_to_index( c )] == UINT32_MAX )
+          {
+            stack.emplace_back( c, false );
+          }
+        } );
+        continue;
+      }
+      if ( var[index] != UINT32_MAX )
+      {
+        continue;
+      }
+
+      std::array<bill::lit_type, 3> fanins;
+      ntk.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+        fanins[i] = literal( fi, copy );
+      } );
+      var[index] = solver.add_variable();
+      auto const x = pos( var[index] );
+      auto const &a = fanins[0], &b = fanins[1], &c = fanins[2];
+
+      if ( ntk.is_xor3( n ) )
+      {
+        for ( auto i = 0u; i < 8u; ++i )
+        {
+          bool const va = i & 1, vb = ( i >> 1 ) & 1, vc = ( i >> 2 ) & 1;
+          solver.add_clause( {lit( a, !va ), lit( b, !vb ), lit( c, !vc ), lit( x, va ^ vb ^ vc )} );
+        }
+      }
+      else
+      {
+        solver.add_clause( {~a, ~b, x} );
+        solver.add_clause( {~a, ~c, x} );
+        solver.add_clause( {~b, ~c, x} );
+        solver.add_clause( {a, b, ~x} );
+        solver.add_clause( {a, c, ~x} );
+        solver.add_clause( {b, c, ~x} );
+      }
+    }
+  }
+
+private:
+  xmg_network const& ntk;
+  solver_t solver;
+  bill::var_type constant;
+  std::array<std::vector<uint32_t>, 2> vars;
+  std::vector<std::pair<node, bool>> stack;
+};
+
+class self_duality_impl
+{
+public:
+  using status = self_duality_result::status;
+
+  self_duality_impl( xmg_network const& ntk, self_duality_params const& ps, self_duality_stats& st )
+      : ntk( ntk ), ps( ps ), st( st )
+  {
+  }
+
+  self_duality_result run()
+  {
+    stopwatch t( st.time_total );
+
+    result.outputs.assign( ntk.num_pos(), status::undecided );
+    result.counterexamples.resize( ntk.num_pos() );
+
+    call_with_stopwatch( st.time_simulation, [&]() { simulate(); } );
+    call_with_stopwatch( st.time_sat, [&]() { solve(); } );
+
+    st.num_self_dual = result.count( status::self_dual );
+    st.num_not_self_dual = result.count( status::not_self_dual );
+    st.num_undecided = result.count( status::undecided );
+    return result;
+  }
+
+private:
+  void simulate()
+  {
+    if ( ps.num_words == 0u )
+    {
+      return;
+    }
+
+    xmg_simulator sim_x( ntk, ps.num_words );
+    xmg_simulator sim_nx( ntk, ps.num_words );
+    std::mt19937_64 rng( ps.seed );
+    std::vector<uint64_t> words( ps.num_words );
+    ntk.foreach_pi( [&]( auto const& n ) {
+      std::generate( words.begin(), words.end(), std::ref( rng ) );
+      sim_x.set_pi( n, words );
+      std::transform( words.begin(), words.end(), words.begin(), []( auto w ) { return ~w; } );
+      sim_nx.set_pi( n, words );
+    } );
+    sim_x.simulate();
+    sim_nx.simulate();
+
+    ntk.foreach_po( [&]( auto const& f, auto i ) {
+      auto const v1 = sim_x.value( f );
+      auto const v2 = sim_nx.value( f );
+      for ( auto w = 0u; w < ps.num_words; ++w )
+      {
+        /* bits where f(x) = f(!x) */
+        auto const equal = ~( v1[w] ^ v2[w] );
+        if ( equal == 0u )
+        {
+          continue;
+        }
+
+        auto const bit = __builtin_ctzll( equal );
+        auto& cex = result.counterexamples[i];
+        ntk.foreach_pi( [&]( auto const& n ) {
+          cex.push_back( ( sim_x.get( n )[w] >> bit ) & 1 );
+        } );
+        result.outputs[i] = status::not_self_dual;
+        ++st.num_refuted_by_simulation;
+        break;
+      }
+    } );
+  }
+
+  void solve()
+  {
+    std::vector<xmg_network::signal> pos;
+    ntk.foreach_po( [&]( auto const& f ) { pos.push_back( f ); } );
+
+    std::vector<uint32_t> open;
+    for ( auto i = 0u; i < pos.size(); ++i )
+    {
+      if ( result.outputs[i] == status::undecided )
+      {
+        open.push_back( i );
+      }
+    }
+    if ( open.empty() )
+    {
+      return;
+    }
+
+    auto const chunk_size = std::max( ps.chunk_size, 1u );
+    auto const num_chunks = static_cast<uint32_t>( ( open.size() + chunk_size - 1u ) / chunk_size );
+    auto num_threads = ps.num_threads != 0u ? ps.num_threads : std::max( std::thread::hardware_concurrency(), 1u );
+    num_threads = std::min( num_threads, num_chunks );
+    st.num_threads = num_threads;
+
+    std::atomic<uint32_t> next_chunk{0u};
+    std::atomic<uint32_t> num_sat_calls{0u};
+
+    /* every thread writes only the entries of the outputs it took */
+    auto const worker = [&]() {
+      dual_miter_encoder encoder( ntk );
+      for ( auto chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++ )
+      {
+        auto const end = std::min<std::size_t>( ( chunk + 1u ) * chunk_size, open.size() );
+        for ( auto j = chunk * chunk_size; j < end; ++j )
+        {
+          auto const i = open[j];
+          ++num_sat_calls;
+          auto const self_dual = encoder.check( pos[i], ps.conflict_limit, result.counterexamples[i] );
+          if ( self_dual )
+          {
+            result.outputs[i] = *self_dual ? status::self_dual : status::not_self_dual;
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for ( auto t = 1u; t < num_threads; ++t )
+    {
+      threads.emplace_back( worker );
+    }
+    worker();
+    for ( auto& t : threads )
+    {
+      t.join();
+    }
+
+    st.num_sat_calls = num_sat_calls;
+  }
+
+private:
+  xmg_network const& ntk;
+  self_duality_params const& ps;
+  self_duality_stats& st;
+
+  self_duality_result result;
+};
+
+} /* namespace detail */
+
+/*! \brief Checks which primary outputs of an XMG are self-dual
+ *
+ * Returns the status of every output and, for outputs that are not
+ * self-dual, an assignment x to the primary inputs with f(x) = f(!x).
+ * Outputs stay undecided only if the conflict limit is reached.
+ */
+inline self_duality_result check_self_duality( xmg_network const& ntk, self_duality_params const& ps = {}, self_duality_stats* pst = nullptr )
+{
+  self_duality_stats st;
+  detail::self_duality_impl p( ntk, ps, st );
+  auto const result = p.run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+  return result;
+}
+
+} /* namespace mockturtle */
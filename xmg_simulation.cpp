@@ -0,0 +1,120 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <lorina/bench.hpp>
+#include <mockturtle/algorithms/cleanup.hpp>
+#include <mockturtle/algorithms/node_resynthesis.hpp>
+#include <mockturtle/algorithms/node_resynthesis/xmg3_npn.hpp>
+#include <mockturtle/io/bench_reader.hpp>
+#include <mockturtle/networks/klut.hpp>
+#include <mockturtle/networks/xmg.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#include <experiments.hpp>
+#include <xmg_simulation.hpp>
+
+int main( int argc, char** argv )
+{
+  using namespace experiments;
+  using namespace mockturtle;
+
+  auto const bps = parse_benchmark_params( argc, argv );
+
+  /* 256 words = 16384 patterns per node */
+  constexpr uint32_t num_words = 256u;
+
+  /* throughputs are in 10^9 gate evaluations per pattern bit and second, measured by re-simulating only the MAJ or XOR3 gates */
+  experiment<std::string, uint32_t, uint32_t, uint32_t, uint32_t, std::string, sample_statistics, sample_statistics, double, double, double, double, double, bool> exp(
+      "xmg_simulation", "benchmark", "gates", "MAJ", "XOR3", "words", "kernel", "scalar", "simd", "speedup",
+      "MAJ scalar [G/s]", "MAJ simd [G/s]", "XOR3 scalar [G/s]", "XOR3 simd [G/s]", "equal" );
+
+  for ( auto const& benchmark : epfl_benchmarks() )
+  {
+    fmt::print( "[i] processing {}\n", benchmark );
+
+    /* the AIGs are mapped into 4-LUTs and resynthesized, such that the XMGs contain XOR3 gates */
+    abc_lut_reader_mf( benchmark );
+    klut_network klut;
+    if ( lorina::read_bench( benchmark_path( benchmark, "_mf_bench", "bench" ), bench_reader( klut ) ) != lorina::return_code::success )
+    {
+      fmt::print( "[e] could not read the LUT mapping of {}\n", benchmark );
+      continue;
+    }
+    xmg_network xmg;
+    xmg3_npn_resynthesis<xmg_network> resyn;
+    node_resynthesis( xmg, klut, resyn );
+    xmg = cleanup_dangling( xmg );
+
+    xmg_simulator scalar_sim( xmg, num_words, simulation_kernel::scalar );
+    xmg_simulator simd_sim( xmg, num_words, simulation_kernel::automatic );
+
+    std::vector<xmg_network::node> maj_gates, xor3_gates;
+    for ( auto const& n : simd_sim.order() )
+    {
+      ( xmg.is_xor3( n ) ? xor3_gates : maj_gates ).push_back( n );
+    }
+
+    auto const measure = [&]( auto&& fn ) {
+      return repeat( bps, [&]() {
+        stopwatch<>::duration time{0};
+        call_with_stopwatch( time, fn );
+        return to_seconds( time );
+      } );
+    };
+    auto const throughput = [&]( xmg_simulator& sim, std::vector<xmg_network::node> const& gates ) {
+      auto const runtime = measure( [&]() { sim.simulate( gates ); } );
+      return runtime.median > 0 ? 1e-9 * gates.size() * num_words * 64.0 / runtime.median : 0.0;
+    };
+
+    auto const runtime_scalar = measure( [&]() { scalar_sim.simulate(); } );
+    auto const runtime_simd = measure( [&]() { simd_sim.simulate(); } );
+
+    bool equal{true};
+    xmg.foreach_po( [&]( auto const& f ) {
+      equal &= scalar_sim.value( f ) == simd_sim.value( f );
+    } );
+
+    exp( benchmark, xmg.num_gates(), static_cast<uint32_t>( maj_gates.size() ), static_cast<uint32_t>( xor3_gates.size() ), num_words,
+         simulation_kernel_name( simulation_kernel::automatic ), runtime_scalar, runtime_simd,
+         runtime_simd.median > 0 ? runtime_scalar.median / runtime_simd.median : 0.0,
+         throughput( scalar_sim, maj_gates ), throughput( simd_sim, maj_gates ),
+         throughput( scalar_sim, xor3_gates ), throughput( simd_sim, xor3_gates ), equal );
+  }
+
+  exp.save();
+  exp.table();
+
+  if ( !bps.baseline.empty() )
+  {
+    auto const regressions = exp.check_regressions( bps.baseline, {{"simd", false, bps.threshold}} );
+    return regressions == 0u ? 0 : 1;
+  }
+
+  return 0;
+}
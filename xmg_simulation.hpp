@@ -0,0 +1,525 @@
+/* mockturtle: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file xmg_simulation.hpp
+  \brief Bit-parallel simulation of XMGs with SIMD MAJ3/XOR3 kernels
+
+  Node values are stored in one contiguous array of 64-bit words, `num_words`
+  words per node.  MAJ3 and XOR3 are evaluated on 512-bit blocks with
+  `vpternlogq` if the translation unit is compiled with AVX-512F (immediates
+  0xE8 and 0x96, complemented fanins are folded into the immediate), on
+  256-bit blocks with AVX2, and word by word otherwise.  Complemented fanins
+  are applied as XOR masks in the latter two cases.
+
+  Compile with `-march=native` (CMake option `EXPERIMENTS_NATIVE_ARCH`) to
+  enable the vector kernels.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#if defined( __AVX2__ ) || defined( __AVX512F__ )
+#include <immintrin.h>
+#endif
+
+#include <mockturtle/networks/xmg.hpp>
+
+namespace mockturtle
+{
+
+enum class simulation_kernel
+{
+  /*! \brief The widest kernel the translation unit has been compiled for. */
+  automatic,
+  scalar,
+  avx2,
+  avx512
+};
+
+inline constexpr bool has_simulation_kernel( simulation_kernel k )
+{
+  switch ( k )
+  {
+  case simulation_kernel::avx512:
+#if defined( __AVX512F__ )
+    return true;
+#else
+    return false;
+#endif
+  case simulation_kernel::avx2:
+#if defined( __AVX2__ )
+    return true;
+#else
+    return false;
+#endif
+  default:
+    return true;
+  }
+}
+
+inline constexpr simulation_kernel resolve_simulation_kernel( simulation_kernel k )
+{
+  if ( k != simulation_kernel::automatic )
+  {
+    return k;
+  }
+  return has_simulation_kernel( simulation_kernel::avx512 ) ? simulation_kernel::avx512 : ( has_simulation_kernel( simulation_kernel::avx2 ) ? simulation_kernel::avx2 : simulation_kernel::scalar );
+}
+
+inline char const* simulation_kernel_name( simulation_kernel k )
+{
+  switch ( resolve_simulation_kernel( k ) )
+  {
+  case simulation_kernel::avx512:
+    return "avx512";
+  case simulation_kernel::avx2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+namespace detail
+{
+
+/* complements are given as bit 0 (a), bit 1 (b), and bit 2 (c) */
+inline void simulate_gate_scalar( uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t complements, bool is_xor3, uint32_t begin, uint32_t end )
+{
+  uint64_t const ma = ( complements & 1 ) ? ~uint64_t( 0 ) : uint64_t( 0 );
+  uint64_t const mb = ( complements & 2 ) ? ~uint64_t( 0 ) : uint64_t( 0 );
+  uint64_t const mc = ( complements & 4 ) ? ~uint64_t( 0 ) : uint64_t( 0 );
+  if ( is_xor3 )
+  {
+    uint64_t const m = ma ^ mb ^ mc;
+    for ( auto w = begin; w < end; ++w )
+    {
+      out[w] = a[w] ^ b[w] ^ c[w] ^ m;
+    }
+  }
+  else
+  {
+    for ( auto w = begin; w < end; ++w )
+    {
+      auto const x = a[w] ^ ma, y = b[w] ^ mb, z = c[w] ^ mc;
+      out[w] = ( x & y ) | ( x & z ) | ( y & z );
+    }
+  }
+}
+
+#if defined( __AVX2__ )
+inline uint32_t simulate_gate_avx2( uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t complements, bool is_xor3, uint32_t num_words )
+{
+  auto const ones = _mm256_set1_epi64x( -1 );
+  auto const zero = _mm256_setzero_si256();
+  auto const ma = ( complements & 1 ) ? ones : zero;
+  auto const mb = ( complements & 2 ) ? ones : zero;
+  auto const mc = ( complements & 4 ) ? ones : zero;
+
+  uint32_t w{0u};
+  if ( is_xor3 )
+  {
+    auto const m = _mm256_xor_si256( _mm256_xor_si256( ma, mb ), mc );
+    for ( ; w + 4u <= num_words; w += 4u )
+    {
+      auto const x = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( a + w ) );
+      auto const y = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( b + w ) );
+      auto const z = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( c + w ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + w ), _mm256_xor_si256( _mm256_xor_si256( x, y ), _mm256_xor_si256( z, m ) ) );
+    }
+  }
+  else
+  {
+    for ( ; w + 4u <= num_words; w += 4u )
+    {
+      auto const x = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( a + w ) ), ma );
+      auto const y = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( b + w ) ), mb );
+      auto const z = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( c + w ) ), mc );
+      auto const maj = _mm256_or_si256( _mm256_and_si256( x, y ), _mm256_and_si256( z, _mm256_or_si256( x, y ) ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + w ), maj );
+    }
+  }
+  return w;
+}
+#endif
+
+#if defined( __AVX512F__ )
+/* ternary-logic immediate of MAJ3/XOR3 with complemented inputs (A = bit 2, B = bit 1, C = bit 0 of the index) */
+constexpr uint8_t ternary_logic_immediate( bool is_xor3, uint32_t complements )
+{
+  uint8_t imm{0u};
+  for ( auto i = 0u; i < 8u; ++i )
+  {
+    bool const x = ( ( i >> 2 ) & 1 ) ^ ( complements & 1 );
+    bool const y = ( ( i >> 1 ) & 1 ) ^ ( ( complements >> 1 ) & 1 );
+    bool const z = ( i & 1 ) ^ ( ( complements >> 2 ) & 1 );
+    bool const v = is_xor3 ? ( x ^ y ^ z ) : ( ( x && y ) || ( x && z ) || ( y && z ) );
+    imm |= v ? uint8_t( 1u << i ) : uint8_t( 0u );
+  }
+  return imm;
+}
+
+template<uint8_t Imm>
+inline uint32_t simulate_gate_avx512_imm( uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t num_words )
+{
+  uint32_t w{0u};
+  for ( ; w + 8u <= num_words; w += 8u )
+  {
+    auto const x = _mm512_loadu_si512( a + w );
+    auto const y = _mm512_loadu_si512( b + w );
+    auto const z = _mm512_loadu_si512( c + w );
+    _mm512_storeu_si512( out + w, _mm512_ternarylogic_epi64( x, y, z, Imm ) );
+  }
+  return w;
+}
+
+template<bool IsXor3, uint32_t... Cs>
+inline uint32_t simulate_gate_avx512_dispatch( uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t complements, uint32_t num_words, std::integer_sequence<uint32_t, Cs...> )
+{
+  uint32_t w{0u};
+  ( ( complements == Cs ? ( w = simulate_gate_avx512_imm<ternary_logic_immediate( IsXor3, Cs )>( out, a, b, c, num_words ), 0 ) : 0 ), ... );
+  return w;
+}
+
+inline uint32_t simulate_gate_avx512( uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t complements, bool is_xor3, uint32_t num_words )
+{
+  return is_xor3 ? simulate_gate_avx512_dispatch<true>( out, a, b, c, complements, num_words, std::make_integer_sequence<uint32_t, 8>{} )
+                 : simulate_gate_avx512_dispatch<false>( out, a, b, c, complements, num_words, std::make_integer_sequence<uint32_t, 8>{} );
+}
+#endif
+
+/*! \brief Evaluates one MAJ3/XOR3 gate on `num_words` words */
+inline void simulate_gate( simulation_kernel kernel, uint64_t* out, uint64_t const* a, uint64_t const* b, uint64_t const* c, uint32_t complements, bool is_xor3, uint32_t num_words )
+{
+  uint32_t done{0u};
+  switch ( resolve_simulation_kernel( kernel ) )
+  {
+#if defined( __AVX512F__ )
+  case simulation_kernel::avx512:
+    done = simulate_gate_avx512( out, a, b, c, complements, is_xor3, num_words );
+    break;
+#endif
+#if defined( __AVX2__ )
+  case simulation_kernel::avx2:
+    done = simulate_gate_avx2( out, a, b, c, complements, is_xor3, num_words );
+    break;
+#endif
+  default:
+    break;
+  }
+  simulate_gate_scalar( out, a, b, c, complements, is_xor3, done, num_words );
+}
+
+} /* namespace detail */
+
+/*! \brief Simulates all nodes of an XMG
+ *
+ * Primary inputs are assigned random patterns (or values set with `set_pi`),
+ * the constant has all bits 0.  `simulate` evaluates all gates in
+ * topological order, which is computed once in the constructor.
+ */
+class xmg_simulator
+{
+public:
+  using node = xmg_network::node;
+  using signal = xmg_network::signal;
+
+  xmg_simulator( xmg_network const& ntk, uint32_t num_words, simulation_kernel kernel = simulation_kernel::automatic )
+      : ntk_( ntk ), num_words_( num_words ), kernel_( kernel ), values_( static_cast<std::size_t>( ntk.size() ) * num_words, 0u )
+  {
+    compute_order();
+    randomize();
+  }
+
+  void randomize( uint64_t seed = 0x5eed )
+  {
+    std::mt19937_64 rng( seed );
+    ntk_.foreach_pi( [&]( auto const& n ) {
+      auto* v = get( n );
+      for ( auto w = 0u; w < num_words_; ++w )
+      {
+        v[w] = rng();
+      }
+    } );
+  }
+
+  void set_pi( node const& n, std::vector<uint64_t> const& words )
+  {
+    std::copy( words.begin(), words.begin() + num_words_, get( n ) );
+  }
+
+  void set_kernel( simulation_kernel kernel )
+  {
+    kernel_ = kernel;
+  }
+
+  void simulate()
+  {
+    for ( auto const& g : order_ )
+    {
+      simulate_node( g );
+    }
+  }
+
+  /*! \brief Re-simulates only `gates` (in topological order) from the current fanin values, e.g., to time one kernel */
+  void simulate( std::vector<node> const& gates )
+  {
+    for ( auto const& g : gates )
+    {
+      simulate_node( g );
+    }
+  }
+
+  uint64_t* get( node const& n )
+  {
+    return values_.data() + static_cast<std::size_t>( ntk_.node_to_index( n ) ) * num_words_;
+  }
+
+  uint64_t const* get( node const& n ) const
+  {
+    return values_.data() + static_cast<std::size_t>( ntk_.node_to_index( n ) ) * num_words_;
+  }
+
+  /*! \brief Value of a signal (complemented if necessary) */
+  std::vector<uint64_t> value( signal const& f ) const
+  {
+    auto const* v = get( ntk_.get_node( f ) );
+    std::vector<uint64_t> words( v, v + num_words_ );
+    if ( ntk_.is_complemented( f ) )
+    {
+      for ( auto& w : words )
+      {
+        w = ~w;
+      }
+    }
+    return words;
+  }
+
+  uint32_t num_words() const
+  {
+    return num_words_;
+  }
+
+  std::vector<node> const& order() const
+  {
+    return order_;
+  }
+
+private:
+  void simulate_node( node const& n )
+  {
+    std::array<uint64_t const*, 3> fanins{};
+    uint32_t complements{0u};
+    ntk_.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+      fanins[i] = get( ntk_.get_node( fi ) );
+      complements |= ntk_.is_complemented( fi ) ? ( 1u << i ) : 0u;
+    } );
+    detail::simulate_gate( kernel_, get( n ), fanins[0], fanins[1], fanins[2], complements, ntk_.is_xor3( n ), num_words_ );
+  }
+
+  /* storage order is not topological after in-place substitutions */
+  void compute_order()
+  {
+    bool topological{true};
+    ntk_.foreach_gate( [&]( auto const& n ) {
+      ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+        topological &= ntk_.node_to_index( ntk_.get_node( fi ) ) < ntk_.node_to_index( n );
+      } );
+      order_.push_back( n );
+    } );
+    if ( topological )
+    {
+      return;
+    }
+
+    order_.clear();
+    std::vector<uint8_t> visited( ntk_.size(), 0u );
+    std::vector<std::pair<node, bool>> stack;
+    ntk_.foreach_gate( [&]( auto const& g ) {
+      stack.emplace_back( g, false );
+      while ( !stack.empty() )
+      {
+        auto const [n, expanded] = stack.back();
+        stack.pop_back();
+        if ( expanded )
+        {
+          order_.push_back( n );
+          continue;
+        }
+        auto const index = ntk_.node_to_index( n );
+        if ( visited[index] || ntk_.is_constant( n ) || ntk_.is_pi( n ) )
+        {
+          continue;
+        }
+        visited[index] = 1u;
+        stack.emplace_back( n, true );
+        ntk_.foreach_fanin( n, [&]( auto const& fi ) {
+          stack.emplace_back( ntk_.get_node( fi ), false );
+        } );
+      }
+    } );
+  }
+
+private:
+  xmg_network const& ntk_;
+  uint32_t num_words_;
+  simulation_kernel kernel_;
+  std::vector<uint64_t> values_;
+  std::vector<node> order_;
+};
+
+/*! \brief Simulates windows of an XMG over all assignments of their leaves
+ *
+ * Truth tables of a window with k leaves have max(1, 2^(k - 6)) words; for
+ * fewer than 6 leaves a word contains repeated copies of the truth table.
+ * Slots are reused between windows; a time stamp per node marks the nodes of
+ * the current window.
+ */
+class xmg_window_simulator
+{
+public:
+  using node = xmg_network::node;
+
+  explicit xmg_window_simulator( xmg_network const& ntk, simulation_kernel kernel = simulation_kernel::automatic )
+      : ntk_( ntk ), kernel_( kernel )
+  {
+  }
+
+  /*! \brief Simulates `nodes` (in topological order) with `leaves` as inputs */
+  void simulate( std::vector<node> const& leaves, std::vector<node> const& nodes )
+  {
+    begin_window( static_cast<uint32_t>( leaves.size() ) );
+    for ( auto i = 0u; i < leaves.size(); ++i )
+    {
+      auto* v = add( leaves[i] );
+      for ( auto w = 0u; w < num_words_; ++w )
+      {
+        v[w] = projection( i, w );
+      }
+    }
+    for ( auto const& n : nodes )
+    {
+      simulate_node( n );
+    }
+  }
+
+  /*! \brief Starts a window with `num_leaves` leaves (for callers that add nodes one by one) */
+  void begin_window( uint32_t num_leaves )
+  {
+    num_words_ = num_leaves <= 6u ? 1u : ( 1u << ( num_leaves - 6u ) );
+    ++stamp_;
+    num_slots_ = 1u; /* slot 0 is the constant */
+    values_.assign( num_words_, 0u );
+    if ( stamp_of_.size() < ntk_.size() )
+    {
+      stamp_of_.resize( ntk_.size(), 0u );
+      slot_of_.resize( ntk_.size(), 0u );
+    }
+  }
+
+  /*! \brief Adds a node with uninitialized value to the window */
+  uint64_t* add( node const& n )
+  {
+    auto const index = ntk_.node_to_index( n );
+    if ( index >= stamp_of_.size() )
+    {
+      stamp_of_.resize( ntk_.size(), 0u );
+      slot_of_.resize( ntk_.size(), 0u );
+    }
+    stamp_of_[index] = stamp_;
+    slot_of_[index] = num_slots_++;
+    values_.resize( static_cast<std::size_t>( num_slots_ ) * num_words_ );
+    return values_.data() + static_cast<std::size_t>( slot_of_[index] ) * num_words_;
+  }
+
+  /*! \brief Simulates a node whose fanins are in the window, returns false otherwise */
+  bool simulate_node( node const& n )
+  {
+    std::array<uint32_t, 3> fanins{};
+    uint32_t complements{0u};
+    bool ok{true};
+    ntk_.foreach_fanin( n, [&]( auto const& fi, auto i ) {
+      auto const c = ntk_.get_node( fi );
+      ok &= contains( c );
+      fanins[i] = ntk_.is_constant( c ) ? 0u : slot_of_[ntk_.node_to_index( c )];
+      complements |= ntk_.is_complemented( fi ) ? ( 1u << i ) : 0u;
+    } );
+    if ( !ok )
+    {
+      return false;
+    }
+
+    auto* out = add( n ); /* may reallocate */
+    detail::simulate_gate( kernel_, out, words( fanins[0] ), words( fanins[1] ), words( fanins[2] ), complements, ntk_.is_xor3( n ), num_words_ );
+    return true;
+  }
+
+  bool contains( node const& n ) const
+  {
+    auto const index = ntk_.node_to_index( n );
+    return ntk_.is_constant( n ) || ( index < stamp_of_.size() && stamp_of_[index] == stamp_ );
+  }
+
+  uint64_t const* get( node const& n ) const
+  {
+    return ntk_.is_constant( n ) ? words( 0u ) : words( slot_of_[ntk_.node_to_index( n )] );
+  }
+
+  uint32_t num_words() const
+  {
+    return num_words_;
+  }
+
+  static uint64_t projection( uint32_t var, uint32_t word )
+  {
+    static constexpr uint64_t projections[] = {0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0,
+                                               0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000};
+    return var < 6u ? projections[var] : ( ( ( word >> ( var - 6u ) ) & 1 ) ? ~uint64_t( 0 ) : uint64_t( 0 ) );
+  }
+
+private:
+  uint64_t const* words( uint32_t slot ) const
+  {
+    return values_.data() + static_cast<std::size_t>( slot ) * num_words_;
+  }
+
+private:
+  xmg_network const& ntk_;
+  simulation_kernel kernel_;
+  uint32_t num_words_{1u};
+  uint32_t num_slots_{1u};
+  uint32_t stamp_{0u};
+  std::vector<uint64_t> values_;
+  std::vector<uint32_t> stamp_of_;
+  std::vector<uint32_t> slot_of_;
+};
+
+} /* namespace mockturtle */